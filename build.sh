@@ -37,6 +37,10 @@ export AICPU_KERNEL_TARGET=cust_aicpu_kernels
 # The version of soc.
 # export AICPU_SOC_VERSION=Ascend910
 
+# FACE_ALIGN_WITH_OPENCV: Set to ON to link OpenCV into the custom operator kernels library, FaceAlign then uses
+#                         estimateAffine2D for "ransac" and warpAffine for uncommon crop sizes. Off by default.
+# export FACE_ALIGN_WITH_OPENCV=ON
+
 ###### The following logic can be used without modification ######
 
 # parse input parameters
@@ -149,15 +153,16 @@ cd $project_path/build_out
 rm -rf *.run
 log "[INFO] Cmake begin."
 
+OPENCV_ARGS="-DFACE_ALIGN_WITH_OPENCV=${FACE_ALIGN_WITH_OPENCV:-OFF}"
 if [ "x$AICPU_SOC_VERSION" = "xLMIX" ];then
      CMAKE_ARGS="-DLMIX=TRUE"
-     cmake $CMAKE_ARGS ..
+     cmake $CMAKE_ARGS $OPENCV_ARGS ..
 else
   if [ "x$AICPU_SOC_VERSION" = "xAscend310RC" ];then
     CMAKE_ARGS="-DMINRC=TRUE"
-    cmake $CMAKE_ARGS ..
+    cmake $CMAKE_ARGS $OPENCV_ARGS ..
   else 
-    cmake ..
+    cmake $OPENCV_ARGS ..
   fi
 fi
 if [ $? -ne 0 ]; then
@@ -15,11 +15,9 @@
  */
 
 #include "async_event_util.h"
-#include <dlfcn.h>
 #include "log.h"
 
 namespace {
-const char *kSharderPath = "/usr/lib64/libaicpu_sharder.so";
 const char *kNotifyWaitFunc = "AicpuNotifyWait";
 const char *kRegEventCbFunc = "AicpuRegEventCb";
 }  // namespace
@@ -31,32 +29,9 @@ AsyncEventUtil &AsyncEventUtil::GetInstance() {
     return async_event_util;
 }
 
-AsyncEventUtil::AsyncEventUtil() {
-  sharder_ = dlopen(kSharderPath, RTLD_LAZY | RTLD_GLOBAL);
-  if (sharder_ == nullptr) {
-    KERNEL_LOG_WARN("Device sharder dlopen so [%s] failed, error[%s]",
-                    kSharderPath, dlerror());
-    notify_wait_func_ = nullptr;
-    reg_event_cb_func_ = nullptr;
-  } else {
-    notify_wait_func_ = reinterpret_cast<NotifyWaitFunc>(dlsym(sharder_, kNotifyWaitFunc));
-    if (notify_wait_func_ == nullptr) {
-      KERNEL_LOG_WARN("Get Function[%s] address failed, error[%s]", kNotifyWaitFunc, dlerror());
-    }
-    reg_event_cb_func_ = reinterpret_cast<RegEventCbFunc>(dlsym(sharder_, kRegEventCbFunc));
-    if (reg_event_cb_func_ == nullptr) {
-      KERNEL_LOG_WARN("Get Function[%s] address failed, error[%s]", kRegEventCbFunc, dlerror());
-    }
-
-    KERNEL_LOG_INFO("Device sharder dlopen so[%s] success.", kSharderPath);
-  }
-}
-
-AsyncEventUtil::~AsyncEventUtil() {
-  if (sharder_ != nullptr) {
-    (void)dlclose(sharder_);
-  }
-}
+AsyncEventUtil::AsyncEventUtil()
+    : notify_wait_func_(GetSharderApi().notify_wait),
+      reg_event_cb_func_(GetSharderApi().reg_event_cb) {}
 
 void AsyncEventUtil::NotifyWait(void *notify_param, const uint32_t param_len) {
   if (notify_wait_func_ != nullptr) {
@@ -19,12 +19,9 @@
 
 #include <functional>
 #include "aicpu_context.h"
+#include "sharder_api.h"
 
 namespace aicpu {
-typedef void (*NotifyWaitFunc)(void *notify_param, const uint32_t param_len);
-typedef bool (*RegEventCbFunc)(const uint32_t event_id,
-  const uint32_t sub_event_id, const std::function<void(void *)> &cb);
-
 class AsyncEventUtil {
  public:
   static AsyncEventUtil &GetInstance();
@@ -35,9 +32,8 @@ class AsyncEventUtil {
                   const std::function<void(void *)> &cb);
  private:
   AsyncEventUtil();
-  ~AsyncEventUtil();
+  ~AsyncEventUtil() = default;
  private:
-  void *sharder_;
   NotifyWaitFunc notify_wait_func_;
   RegEventCbFunc reg_event_cb_func_;
 };
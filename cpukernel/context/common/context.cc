@@ -65,6 +65,9 @@ uint32_t CpuKernelContext::Init(NodeDef *node_def) {
       return KERNEL_STATUS_INNER_ERROR;
     }
   }
+  if (device_ != nullptr) {
+    device_->SetAttrs(attrs_);
+  }
 
   KERNEL_LOG_INFO("Construct the ctx of the op[%s] succcess.", op_.c_str());
 
@@ -16,12 +16,18 @@
 #include "cpu_kernel_cache.h"
 
 #include <limits.h>
+#include <string.h>
+
+#include <chrono>
 
 #include "cce/aicpu_engine_struct.h"
 #include "cpu_kernel.h"
 #include "cpu_kernel_register.h"
 #include "cpu_kernel_utils.h"
+#include "kernel_metrics.h"
+#include "kernel_trace.h"
 #include "log.h"
+#include "sharded_cache.h"
 #include "status.h"
 
 using namespace aicpu;
@@ -31,6 +37,82 @@ namespace {
 constexpr uint32_t kMaxIoAddrNumParamLen = 1024;
 // max LRU cache number is 256
 constexpr uint32_t kMaxLRUCacheNum = 256;
+// max nodedef cache number of each thread is 64
+constexpr uint32_t kMaxNodeDefCacheNum = 64;
+// max extend info plan number of each thread is 64
+constexpr uint32_t kMaxExtInfoPlanNum = 64;
+
+/*
+ * Parsed nodedef and context of launches without session info, keyed by a
+ * hash of the serialized nodedef. Kept per thread, so a cached context is
+ * never updated by two launches at once.
+ */
+struct NodeDefCache {
+  NodeDefCache() { cache.Init(kMaxNodeDefCacheNum); }
+  ShardedCache<CpuCacheData> cache;
+};
+thread_local NodeDefCache g_nodedef_cache;
+
+/*
+ * Extend info plans keyed by the address of the extend info buffer.
+ */
+struct ExtInfoPlanCache {
+  ExtInfoPlanCache() { cache.Init(kMaxExtInfoPlanNum); }
+  ShardedCache<ExtInfoPlan> cache;
+};
+thread_local ExtInfoPlanCache g_ext_info_plans;
+
+/*
+ * type and length of an extend info entry as one word.
+ */
+uint64_t GetExtInfoHead(const FWKAdapter::ExtInfo *ext_info) {
+  uint64_t head = 0;
+  memcpy(&head, ext_info, sizeof(head));
+  return head;
+}
+
+/*
+ * whether the extend info buffer of the launch still has the planned layout.
+ */
+bool MatchExtInfoPlan(const ExtInfoPlan &plan,
+                      const AicpuParamHead *param_head) {
+  if ((plan.ext_info_addr != param_head->extInfoAddr) ||
+      (plan.ext_info_len != param_head->extInfoLength)) {
+    return false;
+  }
+  const char *ext_info_buf =
+      reinterpret_cast<const char *>(static_cast<uintptr_t>(plan.ext_info_addr));
+  uint32_t offset = 0;
+  for (uint64_t head : plan.heads) {
+    auto ext_info =
+        reinterpret_cast<const FWKAdapter::ExtInfo *>(ext_info_buf + offset);
+    if (GetExtInfoHead(ext_info) != head) {
+      return false;
+    }
+    // the same heads as when planned, so no overflow
+    offset += FWKAdapter::kExtInfoHeadSize + ext_info->infoLen;
+  }
+  return true;
+}
+
+/*
+ * 64-bit multiply-xorshift hash over 8-byte words of a serialized nodedef.
+ */
+uint64_t HashNodeDef(const char *nodedef, uint32_t nodedef_len) {
+  constexpr uint64_t kMul = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = nodedef_len * kMul;
+  uint32_t pos = 0;
+  for (; pos + sizeof(uint64_t) <= nodedef_len; pos += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, nodedef + pos, sizeof(uint64_t));
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 32;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, nodedef + pos, nodedef_len - pos);
+  hash = (hash ^ tail) * kMul;
+  return hash ^ (hash >> 29);
+}
 }  // namespace
 
 namespace aicpu {
@@ -88,16 +170,16 @@ void CpuKernelCache::GetDimsFromShapeAndType(
  * update tensor information.
  */
 uint32_t CpuKernelCache::UpdateTensor(
-    const std::vector<uint64_t> &io_addrs, bool unknown_shape,
+    const uint64_t *io_addrs, uint32_t io_addr_num, bool unknown_shape,
     const std::vector<FWKAdapter::ShapeAndType *> &input_shape_and_type,
     const std::vector<FWKAdapter::ShapeAndType *> &output_shape_and_type,
     CpuKernelContext &ctx) {
   KERNEL_LOG_INFO("Update tensor info begin.");
-  if (io_addrs.size() != ctx.GetInputsSize() + ctx.GetOutputsSize()) {
+  if (io_addr_num != ctx.GetInputsSize() + ctx.GetOutputsSize()) {
     KERNEL_LOG_ERROR(
-        "Addr number[%zu] is not equal to the sum of inputs[%zu] and "
+        "Addr number[%u] is not equal to the sum of inputs[%zu] and "
         "output[%zu].",
-        io_addrs.size(), ctx.GetInputsSize(), ctx.GetOutputsSize());
+        io_addr_num, ctx.GetInputsSize(), ctx.GetOutputsSize());
     return KERNEL_STATUS_PARAM_INVALID;
   }
 
@@ -113,6 +195,8 @@ uint32_t CpuKernelCache::UpdateTensor(
     return KERNEL_STATUS_PARAM_INVALID;
   }
 
+  // reused by every launch of the thread, clear keeps its capacity
+  thread_local std::vector<int64_t> dims;
   size_t addr_index = 0;
   for (size_t i = 0; i < ctx.GetInputsSize(); ++i, ++addr_index) {
     Tensor *input = ctx.Input(i);
@@ -122,7 +206,7 @@ uint32_t CpuKernelCache::UpdateTensor(
         reinterpret_cast<void *>(static_cast<uintptr_t>(io_addrs[addr_index])));
 
     if (unknown_shape) {
-      std::vector<int64_t> dims;
+      dims.clear();
       GetDimsFromShapeAndType(input_shape_and_type[i], dims);
       auto shape = input->GetTensorShape();
       KERNEL_CHECK_NULLPTR(shape, KERNEL_STATUS_PARAM_INVALID,
@@ -148,7 +232,7 @@ uint32_t CpuKernelCache::UpdateTensor(
         reinterpret_cast<void *>(static_cast<uintptr_t>(io_addrs[addr_index])));
 
     if (unknown_shape) {
-      std::vector<int64_t> dims;
+      dims.clear();
       GetDimsFromShapeAndType(output_shape_and_type[i], dims);
       auto shape = output->GetTensorShape();
       KERNEL_CHECK_NULLPTR(shape, KERNEL_STATUS_PARAM_INVALID,
@@ -192,11 +276,8 @@ uint32_t CpuKernelCache::ParseExtShapeType(const FWKAdapter::ExtInfo *ext_info,
  * parse extend tensor shape and types information.
  */
 uint32_t CpuKernelCache::ParseExtShapeAndType(
-    bool unknown_shape, FWKAdapter::ExtInfo *ext_info,
+    FWKAdapter::ExtInfo *ext_info,
     std::vector<FWKAdapter::ShapeAndType *> &shape_and_type) {
-  if (!unknown_shape) {
-    return KERNEL_STATUS_OK;
-  }
   uint32_t size = (ext_info->infoLen) / sizeof(FWKAdapter::ShapeAndType);
   KERNEL_LOG_INFO("Parse extend shape and type, size[%u].", size);
   uint32_t check = (ext_info->infoLen) % sizeof(FWKAdapter::ShapeAndType);
@@ -282,17 +363,15 @@ uint32_t CpuKernelCache::ParseAsyncWait(FWKAdapter::ExtInfo *ext_info,
  * parse extend information.
  */
 uint32_t CpuKernelCache::ParseExtMsg(AicpuParamHead *param_head,
-                                     bool &has_session_info,
-                                     uint64_t &kernel_id,
-                                     bool &unknown_shape,
-                                     bool &async_flag,
-                                     uint8_t &wait_type,
-                                     uint32_t &wait_id,
-                                     std::vector<FWKAdapter::ShapeAndType *> &input_shape_and_type,
-                                     std::vector<FWKAdapter::ShapeAndType *> &output_shape_and_type) {
+                                     ExtInfoPlan &plan) {
   KERNEL_LOG_INFO("Parse extend info and update shape begin.");
+  plan.ext_info_addr = param_head->extInfoAddr;
+  plan.ext_info_len = param_head->extInfoLength;
+  uint64_t kernel_id = 0;
+  bool unknown_shape = false;
+  uint8_t wait_type = 0;
+  uint32_t wait_id = 0;
   uint32_t offset = 0;
-  async_flag = false;
   FWKAdapter::ExtInfo *ext_info = nullptr;
   char *extInfo_buf =
       reinterpret_cast<char *>(static_cast<uintptr_t>(param_head->extInfoAddr));
@@ -306,33 +385,33 @@ uint32_t CpuKernelCache::ParseExtMsg(AicpuParamHead *param_head,
       return KERNEL_STATUS_PARAM_INVALID;
     }
 
+    plan.heads.push_back(GetExtInfoHead(ext_info));
     uint32_t ret = KERNEL_STATUS_OK;
     switch (ext_info->infoType) {
       case FWKAdapter::FWK_ADPT_EXT_SHAPE_TYPE:
+        plan.shape_flags.push_back(ext_info);
         ret = ParseExtShapeType(ext_info, unknown_shape);
         break;
       case FWKAdapter::FWK_ADPT_EXT_INPUT_SHAPE:
-        ret =
-            ParseExtShapeAndType(unknown_shape, ext_info, input_shape_and_type);
+        ret = ParseExtShapeAndType(ext_info,
+                                   plan.shape_and_type->input_shape_and_type);
         break;
       case FWKAdapter::FWK_ADPT_EXT_OUTPUT_SHAPE:
-        ret = ParseExtShapeAndType(unknown_shape, ext_info,
-                                   output_shape_and_type);
+        ret = ParseExtShapeAndType(ext_info,
+                                   plan.shape_and_type->output_shape_and_type);
         break;
       case FWKAdapter::FWK_ADPT_EXT_SESSION_INFO:
-        has_session_info = true;
+        plan.has_session_info = true;
+        plan.session_info = ext_info;
         ret = ParseExtSessionInfo(ext_info, kernel_id);
         break;
       case FWKAdapter::FWK_ADPT_EXT_BITMAP:
+        plan.shape_flags.push_back(ext_info);
         ret = ParseExtBitMap(ext_info, unknown_shape);
         break;
       case FWKAdapter::FWK_ADPT_EXT_ASYNCWAIT:
+        plan.async_wait = ext_info;
         ret = ParseAsyncWait(ext_info, wait_type, wait_id);
-        if (ret == KERNEL_STATUS_OK &&
-            wait_type != FWKAdapter::FWKExtWaitType::FWK_ADPT_WAIT_TYPE_NULL &&
-            wait_type != FWKAdapter::FWKExtWaitType::FWK_ADPT_WAIT_TYPE_INVALID) {
-          async_flag = true;
-        }
         break;
       default:
         KERNEL_LOG_INFO("Ignore infoType[%d], infoLen[%u].", ext_info->infoType,
@@ -352,11 +431,82 @@ uint32_t CpuKernelCache::ParseExtMsg(AicpuParamHead *param_head,
   return KERNEL_STATUS_OK;
 }
 
+/*
+ * get the extend info plan of the launch.
+ */
+std::shared_ptr<ExtInfoPlan> CpuKernelCache::GetExtInfoPlan(
+    AicpuParamHead *param_head) {
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  LaunchMetrics &metrics = registry.GetLaunchMetrics();
+  bool record = registry.Enabled();
+  std::shared_ptr<ExtInfoPlan> plan =
+      g_ext_info_plans.cache.Get(param_head->extInfoAddr);
+  if ((plan != nullptr) && MatchExtInfoPlan(*plan, param_head)) {
+    if (record) {
+      metrics.ext_info_plan_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return plan;
+  }
+  if (record) {
+    metrics.ext_info_plan_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // a plan in use by an async kernel is never changed, replace it
+  ExtInfoPlan *plan_ptr = new (std::nothrow) ExtInfoPlan();
+  KERNEL_CHECK_NULLPTR(plan_ptr, nullptr, "Create extend info plan failed.")
+  std::shared_ptr<ExtInfoPlan> new_plan(plan_ptr);
+  new_plan->shape_and_type = std::make_shared<ShapeAndTypeState>();
+  if (ParseExtMsg(param_head, *new_plan) != KERNEL_STATUS_OK) {
+    return nullptr;
+  }
+  g_ext_info_plans.cache.Set(param_head->extInfoAddr, new_plan);
+  return new_plan;
+}
+
+/*
+ * read the values of the launch that the plan points at.
+ */
+uint32_t CpuKernelCache::ParseExtValues(const ExtInfoPlan &plan,
+                                        uint64_t &kernel_id,
+                                        bool &unknown_shape, bool &async_flag,
+                                        uint8_t &wait_type, uint32_t &wait_id) {
+  unknown_shape = false;
+  async_flag = false;
+  // the framework rewrites the bitmap in place between launches
+  for (const FWKAdapter::ExtInfo *shape_flag : plan.shape_flags) {
+    uint32_t ret =
+        (shape_flag->infoType == FWKAdapter::FWK_ADPT_EXT_BITMAP)
+            ? ParseExtBitMap(shape_flag, unknown_shape)
+            : ParseExtShapeType(shape_flag, unknown_shape);
+    if (ret != KERNEL_STATUS_OK) {
+      return ret;
+    }
+  }
+
+  if (plan.session_info != nullptr) {
+    uint32_t ret = ParseExtSessionInfo(plan.session_info, kernel_id);
+    if (ret != KERNEL_STATUS_OK) {
+      return ret;
+    }
+  }
+
+  if (plan.async_wait != nullptr) {
+    uint32_t ret = ParseAsyncWait(plan.async_wait, wait_type, wait_id);
+    if (ret != KERNEL_STATUS_OK) {
+      return ret;
+    }
+    async_flag =
+        (wait_type != FWKAdapter::FWKExtWaitType::FWK_ADPT_WAIT_TYPE_NULL) &&
+        (wait_type != FWKAdapter::FWKExtWaitType::FWK_ADPT_WAIT_TYPE_INVALID);
+  }
+  return KERNEL_STATUS_OK;
+}
+
 /*
  * parse io address.
  */
 uint32_t CpuKernelCache::ParseIoAddr(AicpuParamHead *param_head,
-                                     std::vector<uint64_t> &io_addrs,
+                                     uint64_t *&io_addrs, uint32_t &io_addr_num,
                                      char *&nodedef, uint32_t &nodedef_len) {
   auto param_base = reinterpret_cast<char *>(param_head);
   char *extend_param_base = param_base + sizeof(AicpuParamHead);
@@ -378,10 +528,8 @@ uint32_t CpuKernelCache::ParseIoAddr(AicpuParamHead *param_head,
       return KERNEL_STATUS_PARAM_INVALID;
     }
 
-    auto io_addr_base = reinterpret_cast<uint64_t *>(extend_param_base);
-    for (uint32_t i = 0; i < param_head->ioAddrNum; ++i) {
-      io_addrs.push_back(io_addr_base[i]);
-    }
+    io_addrs = reinterpret_cast<uint64_t *>(extend_param_base);
+    io_addr_num = param_head->ioAddrNum;
     extend_param_base = extend_param_base + addr_len;
     extend_param_len -= addr_len;
   }
@@ -397,8 +545,8 @@ uint32_t CpuKernelCache::ParseIoAddr(AicpuParamHead *param_head,
   nodedef_len = *reinterpret_cast<uint32_t *>(extend_param_base);
   extend_param_base += sizeof(uint32_t);
   nodedef = extend_param_base;
-  KERNEL_LOG_INFO("Parse io addr success, io number[%zu], nodedef length[%u].",
-                  io_addrs.size(), nodedef_len);
+  KERNEL_LOG_INFO("Parse io addr success, io number[%u], nodedef length[%u].",
+                  io_addr_num, nodedef_len);
   return KERNEL_STATUS_OK;
 }
 
@@ -407,19 +555,49 @@ uint32_t CpuKernelCache::ParseIoAddr(AicpuParamHead *param_head,
  */
 std::shared_ptr<CpuKernelContext> CpuKernelCache::GetCpuKernelContext(
     bool has_sess_info, uint64_t kernel_id, const char *nodedef,
-    uint32_t nodedef_len, std::shared_ptr<NodeDef> &nodedef_proto) {
+    uint32_t nodedef_len, bool async_flag,
+    std::shared_ptr<NodeDef> &nodedef_proto,
+    std::shared_ptr<CpuCacheData> &cache_data) {
   std::shared_ptr<CpuKernelContext> ctx = nullptr;
   KERNEL_LOG_INFO("Get cpu kernel context begin, kernel id[%llu].", kernel_id);
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  LaunchMetrics &metrics = registry.GetLaunchMetrics();
+  bool record = registry.Enabled();
+  // an async kernel may still use its context when the thread moves on
+  bool use_nodedef_cache = !has_sess_info && !async_flag;
+  uint64_t nodedef_hash = 0;
   if (has_sess_info) {
-    CpuCacheData *cache = GetCache(kernel_id);
+    std::shared_ptr<CpuCacheData> cache = GetCache(kernel_id);
     if (cache != nullptr) {
       KERNEL_LOG_INFO("Get kernel from cache success.");
-      return cache->context;
+      if (record) {
+        metrics.context_cache_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+      cache_data = cache;
+      return std::shared_ptr<CpuKernelContext>(cache, cache->context.get());
+    }
+  } else if (use_nodedef_cache) {
+    nodedef_hash = HashNodeDef(nodedef, nodedef_len);
+    std::shared_ptr<CpuCacheData> cache =
+        g_nodedef_cache.cache.Get(nodedef_hash);
+    if ((cache != nullptr) && (cache->nodedef.size() == nodedef_len) &&
+        (memcmp(cache->nodedef.data(), nodedef, nodedef_len) == 0)) {
+      KERNEL_LOG_INFO("Get kernel from nodedef cache success, hash[%llu].",
+                      nodedef_hash);
+      if (record) {
+        metrics.context_cache_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+      cache_data = cache;
+      return std::shared_ptr<CpuKernelContext>(cache, cache->context.get());
     }
   }
+  if (record) {
+    metrics.context_cache_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+  TraceScope trace("ParseNodeDef");
 
   std::string str_data(nodedef, nodedef_len);
-  nodedef_proto = CpuKernelUtils::CreateNodeDef();
+  nodedef_proto = CpuKernelUtils::CreateArenaNodeDef();
   KERNEL_CHECK_NULLPTR(nodedef_proto,
                        std::shared_ptr<CpuKernelContext>(nullptr),
                        "Create node def failed.")
@@ -435,69 +613,115 @@ std::shared_ptr<CpuKernelContext> CpuKernelCache::GetCpuKernelContext(
   if (ret != KERNEL_STATUS_OK) {
     return std::shared_ptr<CpuKernelContext>(nullptr);
   }
+  if (KernelTracer::Instance().Enabled()) {
+    KernelTracer::CurrentLaunch().SetOpType(ctx->GetOpType());
+  }
 
+  // the tensors of the context live in the arena of the node def, so the
+  // returned context keeps both alive, also in an async kernel
+  CpuCacheData *cache_ptr = new (std::nothrow) CpuCacheData(nodedef_proto, ctx);
+  KERNEL_CHECK_NULLPTR(cache_ptr, std::shared_ptr<CpuKernelContext>(nullptr),
+                       "Create cpu cache data failed.")
+  std::shared_ptr<CpuCacheData> cache_shared =
+      std::shared_ptr<CpuCacheData>(cache_ptr);
+  cache_ptr->op_type = ctx->GetOpType();
+  cache_ptr->kernel =
+      CpuKernelRegister::Instance().GetCpuKernel(cache_ptr->op_type);
+  KERNEL_CHECK_NULLPTR(cache_ptr->kernel,
+                       std::shared_ptr<CpuKernelContext>(nullptr),
+                       "Get kernel[%s] failed.", cache_ptr->op_type.c_str())
   if (has_sess_info) {
-    CpuCacheData *cache_ptr =
-        new (std::nothrow) CpuCacheData(nodedef_proto, ctx);
-    KERNEL_CHECK_NULLPTR(cache_ptr, std::shared_ptr<CpuKernelContext>(nullptr),
-                         "Create cpu cache data failed.")
-    std::shared_ptr<CpuCacheData> cache_shared =
-        std::shared_ptr<CpuCacheData>(cache_ptr);
     SetCache(kernel_id, cache_shared);
     KERNEL_LOG_INFO("Cache cpu kernel data success, kernel id[%llu].",
                     kernel_id);
+  } else if (use_nodedef_cache) {
+    cache_ptr->nodedef.swap(str_data);
+    g_nodedef_cache.cache.Set(nodedef_hash, cache_shared);
+    KERNEL_LOG_INFO("Cache cpu kernel data success, nodedef hash[%llu].",
+                    nodedef_hash);
   }
   KERNEL_LOG_INFO("Get cpu kernel context success, kernel id[%llu].",
                   kernel_id);
-  return ctx;
+  cache_data = cache_shared;
+  return std::shared_ptr<CpuKernelContext>(cache_shared, ctx.get());
 }
 
 /*
  * run kernel.
  */
 int32_t CpuKernelCache::RunKernel(void *param) {
+  TraceLaunchScope launch;
+  TraceScope trace("RunKernel");
   AicpuParamHead *param_head = static_cast<AicpuParamHead *>(param);
-  std::vector<uint64_t> io_addrs;
+  uint64_t *io_addrs = nullptr;
+  uint32_t io_addr_num = 0;
   char *nodedef = nullptr;
   uint32_t nodedef_len = 0;
-  uint32_t ret = ParseIoAddr(param_head, io_addrs, nodedef, nodedef_len);
+  uint32_t ret =
+      ParseIoAddr(param_head, io_addrs, io_addr_num, nodedef, nodedef_len);
   if (ret != KERNEL_STATUS_OK) {
     return -1;
   }
 
-  bool has_sess_info = false;
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  bool record = registry.Enabled();
+  std::chrono::steady_clock::time_point parse_start;
+  if (record) {
+    parse_start = std::chrono::steady_clock::now();
+  }
+  std::shared_ptr<ExtInfoPlan> plan = GetExtInfoPlan(param_head);
+  if (plan == nullptr) {
+    return -1;
+  }
+  bool has_sess_info = plan->has_session_info;
   uint64_t kernel_id = 0;
   bool unknown_shape = false;
   bool async_flag = false;
   uint8_t wait_type = 0;
   uint32_t wait_id = 0;
-  std::shared_ptr<ShapeAndTypeState> shape_and_type_state = std::make_shared<ShapeAndTypeState>();
-  ret = ParseExtMsg(param_head, has_sess_info, kernel_id, unknown_shape,
-                    async_flag, wait_type, wait_id,
-                    shape_and_type_state->input_shape_and_type,
-                    shape_and_type_state->output_shape_and_type);
+  ret = ParseExtValues(*plan, kernel_id, unknown_shape, async_flag, wait_type,
+                       wait_id);
   if (ret != KERNEL_STATUS_OK) {
     return -1;
   }
+  if (record) {
+    auto parse_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - parse_start);
+    registry.GetLaunchMetrics().ext_info_parse_time.Record(
+        static_cast<uint64_t>(parse_ns.count()));
+  }
+  std::shared_ptr<ShapeAndTypeState> shape_and_type_state =
+      plan->shape_and_type;
 
   std::shared_ptr<NodeDef> nodedef_proto = nullptr;
+  // holds the op type and the kernel even if another launch evicts the entry
+  std::shared_ptr<CpuCacheData> cache_data = nullptr;
   auto ctx = GetCpuKernelContext(has_sess_info, kernel_id, nodedef, nodedef_len,
-                                 nodedef_proto);
+                                 async_flag, nodedef_proto, cache_data);
   KERNEL_CHECK_NULLPTR(ctx, KERNEL_STATUS_INNER_ERROR,
                        "Get cpu kernel context from buff failed.")
+  const std::string &op_type = cache_data->op_type;
+  if (KernelTracer::Instance().Enabled()) {
+    KernelTracer::CurrentLaunch().SetOpType(op_type);
+  }
 
-  ret = UpdateTensor(io_addrs, unknown_shape, shape_and_type_state->input_shape_and_type,
-                     shape_and_type_state->output_shape_and_type, *ctx);
+  {
+    TraceScope update_trace("UpdateTensor");
+    ret = UpdateTensor(io_addrs, io_addr_num, unknown_shape,
+                       shape_and_type_state->input_shape_and_type,
+                       shape_and_type_state->output_shape_and_type, *ctx);
+  }
   if (ret != KERNEL_STATUS_OK) {
     return -1;
   }
 
   if (async_flag) {
-    ret = CpuKernelRegister::Instance().RunCpuKernelAsync(*ctx, wait_type, wait_id, [&, ctx, shape_and_type_state](){
+    ret = CpuKernelRegister::Instance().RunCpuKernelAsync(*ctx, op_type, cache_data->kernel, wait_type, wait_id, [&, ctx, shape_and_type_state, unknown_shape](){
       return UpdateFWKOutputShape(unknown_shape, *ctx, shape_and_type_state->output_shape_and_type);
     });
   } else {
-    ret = CpuKernelRegister::Instance().RunCpuKernel(*ctx);
+    ret = CpuKernelRegister::Instance().RunCpuKernel(*ctx, op_type,
+                                                     cache_data->kernel);
     if (ret != KERNEL_STATUS_OK) {
       return -1;
     }
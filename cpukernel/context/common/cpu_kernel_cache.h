@@ -18,10 +18,12 @@
 
 #include <map>
 #include <memory>
+#include <string>
 
 #include "aicpu_task_struct.h"
 #include "cce/fwk_adpt_struct.h"
 #include "cpu_context.h"
+#include "cpu_kernel.h"
 #include "cpu_node_def.h"
 #include "kernel_cache.h"
 
@@ -29,6 +31,10 @@ namespace aicpu {
 struct CpuCacheData {
   std::shared_ptr<NodeDef> proto = nullptr;
   std::shared_ptr<CpuKernelContext> context = nullptr;
+  std::string nodedef;  // serialized nodedef, set when cached by its hash
+  // kernel of the context, looked up once and run by every launch of it
+  std::string op_type;
+  std::shared_ptr<CpuKernel> kernel = nullptr;
   CpuCacheData(std::shared_ptr<NodeDef> proto,
                std::shared_ptr<CpuKernelContext> context)
       : proto(proto), context(context) {}
@@ -39,6 +45,26 @@ struct ShapeAndTypeState {
   std::vector<FWKAdapter::ShapeAndType *> output_shape_and_type;
 };
 
+/*
+ * Parsed layout of the extend info buffer of a task. The framework keeps
+ * that buffer for the life of the task and rewrites the values only, so a
+ * launch with the same buffer reuses the plan while every entry header still
+ * matches, and reads the session, async wait, shape type and bitmap values
+ * in place.
+ */
+struct ExtInfoPlan {
+  uint64_t ext_info_addr = 0;
+  uint32_t ext_info_len = 0;
+  std::vector<uint64_t> heads;  // type and length of every entry, in order
+  bool has_session_info = false;
+  // shape type and bitmap entries in buffer order, the last one decides
+  // whether the launch has unknown shape
+  std::vector<FWKAdapter::ExtInfo *> shape_flags;
+  FWKAdapter::ExtInfo *session_info = nullptr;
+  FWKAdapter::ExtInfo *async_wait = nullptr;
+  std::shared_ptr<ShapeAndTypeState> shape_and_type = nullptr;
+};
+
 class CpuKernelCache : public KernelCache<CpuCacheData> {
  public:
   CpuKernelCache() = default;
@@ -84,7 +110,7 @@ class CpuKernelCache : public KernelCache<CpuCacheData> {
    * @return uint32_t: 0 indicates success, while the others fail
    */
   uint32_t UpdateTensor(
-      const std::vector<uint64_t> &io_addrs, bool unknown_shape,
+      const uint64_t *io_addrs, uint32_t io_addr_num, bool unknown_shape,
       const std::vector<FWKAdapter::ShapeAndType *> &input_shape_and_type,
       const std::vector<FWKAdapter::ShapeAndType *> &output_shape_and_type,
       CpuKernelContext &ctx);
@@ -106,13 +132,14 @@ class CpuKernelCache : public KernelCache<CpuCacheData> {
                           bool &unknown_shape);
 
   /*
-   * parse extend tensor shape and types information.
+   * parse extend tensor shape and types information, kept whether or not the
+   * launch has unknown shape.
    * @param ext_info: extend information
    * @param shape_and_type: shape and types from extend information
    * @return uint32_t: 0 indicates success, while the others fail
    */
   uint32_t ParseExtShapeAndType(
-      bool unknown_shape, FWKAdapter::ExtInfo *ext_info,
+      FWKAdapter::ExtInfo *ext_info,
       std::vector<FWKAdapter::ShapeAndType *> &shape_and_type);
 
   /*
@@ -138,42 +165,62 @@ class CpuKernelCache : public KernelCache<CpuCacheData> {
   /*
    * parse extend information.
    * @param param_head: kernel context
-   * @param has_session_info: whether has session info in extend info
+   * @param plan: layout of the extend information
+   * @return uint32_t: 0 indicates success, while the others fail
+   */
+  uint32_t ParseExtMsg(AicpuParamHead *param_head, ExtInfoPlan &plan);
+
+  /*
+   * get the extend info plan of the launch, parsed on the first launch of
+   * the extend info buffer and cached per thread by its address.
+   * @param param_head: kernel context
+   * @return std::shared_ptr<ExtInfoPlan>: not null->success, null->failed
+   */
+  std::shared_ptr<ExtInfoPlan> GetExtInfoPlan(AicpuParamHead *param_head);
+
+  /*
+   * read the values of the launch that the plan points at.
+   * @param plan: layout of the extend information
    * @param kernel_id: kernel id
+   * @param unknown_shape: whether the launch has unknown shape
+   * @param async_flag: whether the kernel waits for an event
    * @param wait_type: event wait type
    * @param wait_id : event wait id
    * @return uint32_t: 0 indicates success, while the others fail
    */
-  uint32_t ParseExtMsg(
-      AicpuParamHead *param_head, bool &has_session_info, uint64_t &kernel_id,
-      bool &unknown_shape,
-      bool &async_flag,
-      uint8_t &wait_type,
-      uint32_t &wait_id,
-      std::vector<FWKAdapter::ShapeAndType *> &input_shape_and_type,
-      std::vector<FWKAdapter::ShapeAndType *> &output_shape_and_type);
+  uint32_t ParseExtValues(const ExtInfoPlan &plan, uint64_t &kernel_id,
+                          bool &unknown_shape, bool &async_flag,
+                          uint8_t &wait_type, uint32_t &wait_id);
 
   /*
    * parse io address.
    * @param param_head: kernel context
-   * @param io_addrs: kernel inputs and outputs adress
+   * @param io_addrs: kernel inputs and outputs adress, in param_head
+   * @param io_addr_num: number of io_addrs
    * @param nodedef: kernel node def
    * @param nodedef_len: kernel node def length
    * @return uint32_t: 0 indicates success, while the others fail
    */
-  uint32_t ParseIoAddr(AicpuParamHead *param_head,
-                       std::vector<uint64_t> &io_addrs, char *&nodedef,
+  uint32_t ParseIoAddr(AicpuParamHead *param_head, uint64_t *&io_addrs,
+                       uint32_t &io_addr_num, char *&nodedef,
                        uint32_t &nodedef_len);
 
   /*
-   * get cpu kernel context from cache
+   * get cpu kernel context from cache, launches without session info are
+   * cached per thread by the content of their nodedef
    * @param has_sess_info: whether has session info
    * @param kernel_id: kernel id, the key of cache
-   * @return uint32_t: 0 indicates success, while the others fail
+   * @param async_flag: async kernels are not cached by nodedef
+   * @param cache_data: entry of the context with its op type and kernel,
+   * shared so an eviction during the launch does not free it
+   * @return std::shared_ptr<CpuKernelContext>: context, it also keeps
+   * cache_data alive
    */
   std::shared_ptr<CpuKernelContext> GetCpuKernelContext(
       bool has_sess_info, uint64_t kernel_id, const char *nodedef,
-      uint32_t nodedef_len, std::shared_ptr<NodeDef> &nodedef_proto);
+      uint32_t nodedef_len, bool async_flag,
+      std::shared_ptr<NodeDef> &nodedef_proto,
+      std::shared_ptr<CpuCacheData> &cache_data);
 
   /*
    * get bit status on pos
@@ -15,11 +15,14 @@
  */
 #include "cpu_kernel_register.h"
 
+#include <chrono>
 #include <mutex>
 
 #include "aicpu_context.h"
 #include "aicpu_async_event.h"
 #include "cpu_kernel.h"
+#include "kernel_metrics.h"
+#include "kernel_trace.h"
 #include "log.h"
 #include "status.h"
 #include "async_event_util.h"
@@ -29,6 +32,26 @@ namespace {
 #define TYPE_REGISTAR(type, fun) type##Registerar(type, fun)
 // protect creatorMap_
 std::mutex g_mutex;
+
+/*
+ * add a run of a kernel to the metrics of its op type.
+ */
+void RecordKernelMetrics(aicpu::KernelMetricsRegistry &registry,
+                         const std::string &type,
+                         std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end,
+                         uint32_t status) {
+  aicpu::KernelMetrics *metrics = registry.GetKernelMetrics(type);
+  if (metrics == nullptr) {
+    return;
+  }
+  metrics->compute_time.Record(static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count()));
+  if (status != aicpu::KERNEL_STATUS_OK) {
+    metrics->failures.fetch_add(1, std::memory_order_relaxed);
+  }
+}
 }  // namespace
 
 namespace aicpu {
@@ -56,7 +79,25 @@ CpuKernelRegister &CpuKernelRegister::Instance() {
  */
 std::shared_ptr<CpuKernel> CpuKernelRegister::GetCpuKernel(
     const std::string &opType) {
+  const CreatorTable *creators = creators_.load(std::memory_order_acquire);
+  if (creators != nullptr) {
+    auto iter = creators->find(opType);
+    if (iter != creators->end()) {
+      return iter->second();
+    }
+  }
+
+  // not in the published table, publish one with the kernels registered since
   std::unique_lock<std::mutex> lock(g_mutex);
+  creators = creators_.load(std::memory_order_relaxed);
+  if ((creators == nullptr) || (creators->size() != creatorMap_.size())) {
+    CreatorTable *table = new (std::nothrow)
+        CreatorTable(creatorMap_.begin(), creatorMap_.end());
+    if (table != nullptr) {
+      creator_tables_.emplace_back(table);
+      creators_.store(table, std::memory_order_release);
+    }
+  }
   auto iter = creatorMap_.find(opType);
   if (iter != creatorMap_.end()) {
     return iter->second();
@@ -86,11 +127,24 @@ std::vector<std::string> CpuKernelRegister::GetAllRegisteredOpTypes() const {
  */
 uint32_t CpuKernelRegister::RunCpuKernel(CpuKernelContext &ctx) {
   std::string type = ctx.GetOpType();
-  KERNEL_LOG_INFO("RunCpuKernel[%s] begin.", type.c_str());
   auto kernel = GetCpuKernel(type);
   if (kernel == nullptr) {
     return KERNEL_STATUS_INNER_ERROR;
   }
+  return RunCpuKernel(ctx, type, kernel);
+}
+
+/*
+ * run cpu kernel got for the context before.
+ * param ctx: context of kernel
+ * @return uint32_t: 0->success other->failed
+ */
+uint32_t CpuKernelRegister::RunCpuKernel(
+    CpuKernelContext &ctx, const std::string &type,
+    const std::shared_ptr<CpuKernel> &kernel) {
+  KERNEL_LOG_INFO("RunCpuKernel[%s] begin.", type.c_str());
+  KERNEL_CHECK_NULLPTR(kernel, KERNEL_STATUS_INNER_ERROR,
+                       "Kernel[%s] is null.", type.c_str())
   if (aicpu::SetThreadLocalCtx != nullptr) {
     if (aicpu::SetThreadLocalCtx(aicpu::CONTEXT_KEY_OP_NAME, type) !=
         aicpu::AICPU_ERROR_NONE) {
@@ -102,11 +156,24 @@ uint32_t CpuKernelRegister::RunCpuKernel(CpuKernelContext &ctx) {
     (void)aicpu::SetOpname(type);
   }
 
-  auto start = std::chrono::steady_clock::now();
-  uint32_t ret = kernel->Compute(ctx);
-  auto end = std::chrono::steady_clock::now();
-  double dr_us=std::chrono::duration<double,std::micro>(end-start).count();
-  KERNEL_LOG_EVENT("RunCpuKernel[%s], run time is [%lf] us.", type.c_str(), dr_us);
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  bool record = registry.Enabled();
+  std::chrono::steady_clock::time_point start;
+  if (record) {
+    start = std::chrono::steady_clock::now();
+  }
+  if (KernelTracer::Instance().Enabled()) {
+    KernelTracer::CurrentLaunch().SetOpType(type);
+  }
+  uint32_t ret = 0;
+  {
+    TraceScope trace("Compute");
+    ret = kernel->Compute(ctx);
+  }
+  if (record) {
+    RecordKernelMetrics(registry, type, start,
+                        std::chrono::steady_clock::now(), ret);
+  }
   if (ret != KERNEL_STATUS_OK) {
     return ret;
   }
@@ -119,11 +186,22 @@ uint32_t CpuKernelRegister::RunCpuKernelAsync(CpuKernelContext &ctx,
                                               const uint32_t wait_id,
                                               std::function<uint32_t()> cb) {
   std::string type = ctx.GetOpType();
-  KERNEL_LOG_INFO("RunCpuKernelAsync[%s] begin.", type.c_str());
   auto kernel = GetCpuKernel(type);
   if (kernel == nullptr) {
     return KERNEL_STATUS_INNER_ERROR;
   }
+  return RunCpuKernelAsync(ctx, type, kernel, wait_type, wait_id, cb);
+}
+
+uint32_t CpuKernelRegister::RunCpuKernelAsync(
+    CpuKernelContext &ctx, const std::string &op_type,
+    const std::shared_ptr<CpuKernel> &kernel, const uint8_t wait_type,
+    const uint32_t wait_id, std::function<uint32_t()> cb) {
+  // kept by the done callback
+  std::string type = op_type;
+  KERNEL_LOG_INFO("RunCpuKernelAsync[%s] begin.", type.c_str());
+  KERNEL_CHECK_NULLPTR(kernel, KERNEL_STATUS_INNER_ERROR,
+                       "Kernel[%s] is null.", type.c_str())
   AsyncCpuKernel *async_kernel = dynamic_cast<AsyncCpuKernel *>(kernel.get());
   if (async_kernel == nullptr) {
     KERNEL_LOG_ERROR("kernel name[%s] does not hava async impl.", type.c_str());
@@ -157,11 +235,28 @@ uint32_t CpuKernelRegister::RunCpuKernelAsync(CpuKernelContext &ctx,
   notify_info->waitType = wait_type;
   notify_info->waitId = wait_id;
 
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  bool record = registry.Enabled();
+  // the kernel may finish on another thread, its span is recorded there
+  TraceLaunch trace_launch;
+  uint64_t trace_begin_ns = 0;
+  if (KernelTracer::Instance().Enabled()) {
+    trace_launch.task_id = notify_info->taskId;
+    trace_launch.stream_id = notify_info->streamId;
+    trace_launch.SetOpType(type);
+    trace_begin_ns = KernelTracer::NowNs();
+  }
   auto start = std::chrono::steady_clock::now();
-  auto done = [&, notify_info, kernel, type, cb, start](uint32_t status) {
-    auto end = std::chrono::steady_clock::now();
-    double dr_us=std::chrono::duration<double,std::micro>(end-start).count();
-    KERNEL_LOG_EVENT("RunCpuKernel[%s], run time is [%lf] us.", type.c_str(), dr_us);
+  auto done = [&, notify_info, kernel, type, cb, start, record, trace_launch,
+               trace_begin_ns](uint32_t status) {
+    if (record) {
+      RecordKernelMetrics(KernelMetricsRegistry::Instance(), type, start,
+                          std::chrono::steady_clock::now(), status);
+    }
+    if (trace_begin_ns != 0) {
+      KernelTracer::Instance().Record("Compute", trace_launch, trace_begin_ns,
+                                      KernelTracer::NowNs());
+    }
     if (status == KERNEL_STATUS_OK) {
       KERNEL_LOG_INFO("RunCpuKernel[%s] success.", type.c_str());
       status = cb();
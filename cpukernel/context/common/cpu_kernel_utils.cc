@@ -17,6 +17,8 @@
 
 #include "attr_value_impl.h"
 #include "device.h"
+#include "kernel_arena.h"
+#include "kernel_trace.h"
 #include "log.h"
 #include "node_def_impl.h"
 #include "sharder.h"
@@ -24,6 +26,41 @@
 #include "tensor_impl.h"
 #include "tensor_shape_impl.h"
 
+namespace {
+// shards of parallel fors the calling thread is in, outer ones included
+thread_local uint32_t g_shard_depth = 0;
+
+class ShardScope {
+ public:
+  ShardScope() { ++g_shard_depth; }
+  ~ShardScope() { --g_shard_depth; }
+};
+
+/*
+ * launch a shard of a parallel for belongs to, null when not tracing.
+ */
+const aicpu::TraceLaunch *ShardTraceLaunch() {
+  if (!aicpu::KernelTracer::Instance().Enabled()) {
+    return nullptr;
+  }
+  return &aicpu::KernelTracer::CurrentLaunch();
+}
+
+/*
+ * run a parallel for started by a shard inline if the sharder can not
+ * nest them.
+ * @return bool: true->the work is done
+ */
+bool RunNestedInline(const aicpu::Sharder *sharder, int64_t total,
+                     const std::function<void(int64_t, int64_t)> &work) {
+  if ((g_shard_depth == 0) || (total <= 0) || sharder->SupportNested()) {
+    return false;
+  }
+  work(0, total);
+  return true;
+}
+}  // namespace
+
 namespace aicpu {
 /*
  * construct Tensor for memory self-management.
@@ -54,6 +91,12 @@ std::shared_ptr<Tensor> CpuKernelUtils::CreateTensor() {
 std::shared_ptr<Tensor> CpuKernelUtils::CreateTensor(TensorImpl *tensor) {
   KERNEL_CHECK_NULLPTR(tensor, std::shared_ptr<Tensor>(nullptr),
                        "Tensor is null.")
+  KernelArena *arena = tensor->GetArena();
+  if (arena != nullptr) {
+    // the constructor is private, so construct in place here
+    Tensor *class_ptr = new (arena->Allocate(sizeof(Tensor))) Tensor(tensor);
+    return ShareArenaObject(class_ptr, arena);
+  }
   auto class_ptr = new (std::nothrow) Tensor(tensor);
   KERNEL_CHECK_NULLPTR(class_ptr, std::shared_ptr<Tensor>(nullptr),
                        "New Tensor failed.")
@@ -158,6 +201,12 @@ std::shared_ptr<AttrValue> CpuKernelUtils::CreateAttrValue(
     AttrValueImpl *impl) {
   KERNEL_CHECK_NULLPTR(impl, std::shared_ptr<AttrValue>(nullptr),
                        "Impl is null.")
+  KernelArena *arena = impl->GetArena();
+  if (arena != nullptr) {
+    AttrValue *class_ptr =
+        new (arena->Allocate(sizeof(AttrValue))) AttrValue(impl);
+    return ShareArenaObject(class_ptr, arena);
+  }
   auto class_ptr = new (std::nothrow) AttrValue(impl);
   KERNEL_CHECK_NULLPTR(class_ptr, std::shared_ptr<AttrValue>(nullptr),
                        "New AttrValue failed.")
@@ -198,6 +247,31 @@ std::shared_ptr<NodeDef> CpuKernelUtils::CreateNodeDef() {
   return std::shared_ptr<NodeDef>(class_ptr);
 }
 
+/*
+ * construct NodeDef whose proto and wrappers live in its arena.
+ */
+std::shared_ptr<NodeDef> CpuKernelUtils::CreateArenaNodeDef() {
+  std::unique_ptr<KernelArena> arena(new (std::nothrow) KernelArena());
+  KERNEL_CHECK_NULLPTR(arena, std::shared_ptr<NodeDef>(nullptr),
+                       "New KernelArena failed.")
+
+  auto proto_ptr = google::protobuf::Arena::CreateMessage<aicpuops::NodeDef>(
+      arena->GetProtoArena());
+  auto wrapper_ptr =
+      new (std::nothrow) NodeDefImpl(proto_ptr, std::move(arena));
+  KERNEL_CHECK_NULLPTR(wrapper_ptr, std::shared_ptr<NodeDef>(nullptr),
+                       "new NodeDefImpl failed.")
+
+  auto class_ptr = new (std::nothrow) NodeDef(wrapper_ptr);
+  if (class_ptr == nullptr) {
+    KERNEL_LOG_ERROR("new NodeDef failed");
+    delete wrapper_ptr;
+    return std::shared_ptr<NodeDef>(nullptr);
+  }
+
+  return std::shared_ptr<NodeDef>(class_ptr);
+}
+
 /*
  * ParallelFor shards the "total" units of work.
  * @return uint32_t: 0->sucess other->failed
@@ -211,11 +285,93 @@ uint32_t CpuKernelUtils::ParallelFor(
   const Sharder *sharder = ctx.device_->GetSharder();
   KERNEL_CHECK_NULLPTR(sharder, KERNEL_STATUS_INNER_ERROR,
                        "Get sharder is null.")
+  KERNEL_CHECK_NULLPTR(work, KERNEL_STATUS_PARAM_INVALID, "Work is null.")
+
+  if (RunNestedInline(sharder, total, work)) {
+    return KERNEL_STATUS_OK;
+  }
+  const TraceLaunch *launch = ShardTraceLaunch();
+  sharder->ParallelFor(total, perUnitSize,
+                       [&work, launch](int64_t start, int64_t end) {
+                         ShardScope scope;
+                         TraceLaunchScope launch_scope(launch);
+                         TraceScope trace("Shard");
+                         work(start, end);
+                       });
+  return KERNEL_STATUS_OK;
+}
+
+/*
+ * ParallelFor shards the "total" units of work by their expected cost.
+ * @return uint32_t: 0->sucess other->failed
+ */
+uint32_t CpuKernelUtils::ParallelFor(
+    const CpuKernelContext &ctx, int64_t total, const ParallelForCost &cost,
+    const std::function<void(int64_t, int64_t)> &work) {
+  KERNEL_CHECK_NULLPTR(ctx.device_, KERNEL_STATUS_INNER_ERROR,
+                       "Device is null.")
+
+  const Sharder *sharder = ctx.device_->GetSharder();
+  KERNEL_CHECK_NULLPTR(sharder, KERNEL_STATUS_INNER_ERROR,
+                       "Get sharder is null.")
+  KERNEL_CHECK_NULLPTR(work, KERNEL_STATUS_PARAM_INVALID, "Work is null.")
 
-  sharder->ParallelFor(total, perUnitSize, work);
+  if (RunNestedInline(sharder, total, work)) {
+    return KERNEL_STATUS_OK;
+  }
+  const TraceLaunch *launch = ShardTraceLaunch();
+  sharder->ParallelFor(total, cost, [&work, launch](int64_t start, int64_t end) {
+    ShardScope scope;
+    TraceLaunchScope launch_scope(launch);
+    TraceScope trace("Shard");
+    work(start, end);
+  });
   return KERNEL_STATUS_OK;
 }
 
+/*
+ * get attr without building a string of its name.
+ */
+AttrValue *CpuKernelUtils::GetAttr(const CpuKernelContext &ctx,
+                                   const char *name) {
+  int32_t index = GetAttrIndex(ctx, name);
+  return index < 0 ? nullptr : GetAttrByIndex(ctx, index);
+}
+
+/*
+ * get the index of an attr, in name order.
+ */
+int32_t CpuKernelUtils::GetAttrIndex(const CpuKernelContext &ctx,
+                                     const char *name) {
+  KERNEL_CHECK_NULLPTR(name, -1, "Attr name is null.")
+  KERNEL_CHECK_NULLPTR(ctx.device_, -1, "Device is null.")
+  return ctx.device_->GetAttrIndex(name);
+}
+
+/*
+ * get attr by index.
+ */
+AttrValue *CpuKernelUtils::GetAttrByIndex(const CpuKernelContext &ctx,
+                                          int32_t index) {
+  KERNEL_CHECK_NULLPTR(ctx.device_, nullptr, "Device is null.")
+  AttrValue *attr = ctx.device_->GetAttrByIndex(index);
+  if (attr == nullptr) {
+    KERNEL_LOG_WARN("Attr index[%d] should be less than attr size[%zu].",
+                    index, ctx.attrs_.size());
+  }
+  return attr;
+}
+
+/*
+ * get the kernel state of a context, created once.
+ */
+const void *CpuKernelUtils::GetKernelState(const CpuKernelContext &ctx,
+                                           KernelStateCreator create) {
+  KERNEL_CHECK_NULLPTR(create, nullptr, "Kernel state creator is null.")
+  KERNEL_CHECK_NULLPTR(ctx.device_, nullptr, "Device is null.")
+  return ctx.device_->GetKernelState([&ctx, create]() { return create(ctx); });
+}
+
 /*
  * Get CPU number
  * @return CPU number
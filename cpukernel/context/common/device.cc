@@ -15,7 +15,9 @@
  */
 #include "device.h"
 
-#include <new>
+#include <string.h>
+
+#include <algorithm>
 
 #include "device_sharder.h"
 #include "host_sharder.h"
@@ -26,12 +28,6 @@ Device::Device(DeviceType device) {
   sharder_ = InitSharder(device);
 }
 
-Device::~Device() {
-  if (sharder_ != nullptr) {
-    delete sharder_;
-  }
-}
-
 /*
  * get device type.
  * @return DeviceType: HOST/DEVICE
@@ -49,16 +45,57 @@ const Sharder *Device::GetSharder() const {
   return nullptr;
 }
 
+/*
+ * snapshot the attrs of the context in name order.
+ */
+void Device::SetAttrs(
+    const std::map<std::string, std::shared_ptr<AttrValue>> &attrs) {
+  attrs_.clear();
+  attrs_.reserve(attrs.size());
+  for (auto iter = attrs.begin(); iter != attrs.end(); ++iter) {
+    attrs_.emplace_back(iter->first.c_str(), iter->second.get());
+  }
+}
+
+/*
+ * find an attr by binary search.
+ */
+int32_t Device::GetAttrIndex(const char *name) const {
+  // strcmp orders like the std::string keys of the map the snapshot is from
+  auto iter = std::lower_bound(
+      attrs_.begin(), attrs_.end(), name,
+      [](const std::pair<const char *, AttrValue *> &attr, const char *key) {
+        return strcmp(attr.first, key) < 0;
+      });
+  if ((iter == attrs_.end()) || (strcmp(iter->first, name) != 0)) {
+    return -1;
+  }
+  return static_cast<int32_t>(iter - attrs_.begin());
+}
+
+/*
+ * get attr by index.
+ */
+AttrValue *Device::GetAttrByIndex(int32_t index) const {
+  if ((index < 0) || (static_cast<size_t>(index) >= attrs_.size())) {
+    return nullptr;
+  }
+  return attrs_[index].second;
+}
+
 /*
  * init sharder.
  * param device: type of device
- * @return Sharder *: not null->success, null->success
+ * @return Sharder *: sharder shared by all devices of the type
  */
-Sharder *Device::InitSharder(DeviceType device_) {
+const Sharder *Device::InitSharder(DeviceType device_) {
+  // sharders hold no per-context state, so every context of a type shares one
   if (device_ == DEVICE) {
-    return new (std::nothrow) DeviceSharder(device_);
+    static const DeviceSharder device_sharder(DEVICE);
+    return &device_sharder;
   } else {
-    return new (std::nothrow) HostSharder(device_);
+    static const HostSharder host_sharder(HOST);
+    return &host_sharder;
   }
 }
 }  // namespace aicpu
@@ -16,14 +16,29 @@
 #ifndef AICPU_CONTEXT_COMMON_DEVICE_H_
 #define AICPU_CONTEXT_COMMON_DEVICE_H_
 
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "sharder.h"
 
 namespace aicpu {
+class AttrValue;
+
+/*
+ * Per-context state of the context library. CpuKernelContext's layout is
+ * fixed by the SDK header, what it needs beyond that lives here.
+ */
 class Device {
  public:
   explicit Device(DeviceType device);
 
-  ~Device();
+  ~Device() = default;
 
   /*
    * get device type.
@@ -37,6 +52,37 @@ class Device {
    */
   const Sharder *GetSharder() const;
 
+  /*
+   * snapshot the attrs of the context in name order, called by its Init.
+   * @param attrs: attrs of the context, they must outlive the device
+   */
+  void SetAttrs(const std::map<std::string, std::shared_ptr<AttrValue>> &attrs);
+
+  /*
+   * find an attr by binary search.
+   * @param name: attr name
+   * @return int32_t: index, -1 if there is no such attr
+   */
+  int32_t GetAttrIndex(const char *name) const;
+
+  /*
+   * get attr by index.
+   * @param index: index from GetAttrIndex
+   * @return AttrValue *: not null->success, null->index out of range
+   */
+  AttrValue *GetAttrByIndex(int32_t index) const;
+
+  /*
+   * get the kernel state, created by create on the first call only.
+   * @param create: callable returning std::shared_ptr<const void>
+   * @return const void *: state, null->create failed
+   */
+  template <class Creator>
+  const void *GetKernelState(Creator create) {
+    std::call_once(state_once_, [this, &create]() { state_ = create(); });
+    return state_.get();
+  }
+
  private:
   Device(const Device &) = delete;
   Device(Device &&) = delete;
@@ -46,13 +92,17 @@ class Device {
   /*
    * init sharder.
    * param device: type of device
-   * @return Sharder *: not null->success, null->success
+   * @return Sharder *: sharder shared by all devices of the type
    */
-  Sharder *InitSharder(DeviceType device);
+  const Sharder *InitSharder(DeviceType device);
 
  private:
   DeviceType device_;  // type of device
-  Sharder *sharder_;
+  const Sharder *sharder_;
+  // pair<name, attr> in name order, both owned by the context
+  std::vector<std::pair<const char *, AttrValue *>> attrs_;
+  std::once_flag state_once_;
+  std::shared_ptr<const void> state_;  // kernel state, see CpuKernelUtils::GetKernelState
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_COMMON_DEVICE_H_
@@ -15,48 +15,18 @@
  */
 #include "device_sharder.h"
 
-#include <dlfcn.h>
 #include "log.h"
 
 namespace {
-const char *kSharderPath = "/usr/lib64/libaicpu_sharder.so";
 const char *kParallelForFunc = "ParallelFor";
 const char *kGetCPUNumFunc = "GetCPUNum";
 }  // namespace
 
 namespace aicpu {
-DeviceSharder::DeviceSharder(DeviceType device) : Sharder(device) {
-  sharder_ = dlopen(kSharderPath, RTLD_LAZY | RTLD_GLOBAL);
-  if (sharder_ == nullptr) {
-    KERNEL_LOG_WARN("Device sharder dlopen so[%s] failed, error[%s]",
-                    kSharderPath, dlerror());
-    parallel_for_ = nullptr;
-    get_cpu_num_ = nullptr;
-  } else {
-    parallel_for_ =
-        reinterpret_cast<ParallelForFunc>(dlsym(sharder_, kParallelForFunc));
-    if (parallel_for_ == nullptr) {
-      KERNEL_LOG_WARN("Get function[%s] address failed, error[%s]",
-                      kParallelForFunc, dlerror());
-    }
-
-    get_cpu_num_ =
-        reinterpret_cast<GetCPUNumFunc>(dlsym(sharder_, kGetCPUNumFunc));
-    if (get_cpu_num_ == nullptr) {
-      KERNEL_LOG_WARN("Get function[%s] address failed, error[%s]",
-                      kGetCPUNumFunc, dlerror());
-    }
-    KERNEL_LOG_INFO("Device sharder dlopen so[%s] success", kSharderPath);
-  }
-}
-
-DeviceSharder::~DeviceSharder() {
-    if (sharder_ != nullptr) {
-        (void) dlclose(sharder_);
-        sharder_ = nullptr;
-    }
-    parallel_for_ = nullptr;
-}
+DeviceSharder::DeviceSharder(DeviceType device)
+    : Sharder(device),
+      parallel_for_(GetSharderApi().parallel_for),
+      get_cpu_num_(GetSharderApi().get_cpu_num) {}
 
 /*
  * ParallelFor shards the "total" units of work.
@@ -16,17 +16,17 @@
 #ifndef AICPU_CONTEXT_COMMON_DEVICE_SHARDER_H_
 #define AICPU_CONTEXT_COMMON_DEVICE_SHARDER_H_
 #include "sharder.h"
+#include "sharder_api.h"
 
 namespace aicpu {
-typedef void (*ParallelForFunc)(
-    int64_t total, int64_t perUnitSize,
-    const std::function<void(int64_t, int64_t)> &work);
-typedef uint32_t (*GetCPUNumFunc)();
 class DeviceSharder : public Sharder {
  public:
   explicit DeviceSharder(DeviceType device);
 
-  ~DeviceSharder();
+  ~DeviceSharder() = default;
+
+  // the cost overload of Sharder turns the cost into a unit size
+  using Sharder::ParallelFor;
 
   /*
    * ParallelFor shards the "total" units of work.
@@ -51,7 +51,6 @@ class DeviceSharder : public Sharder {
   DeviceSharder &operator=(DeviceSharder &&) = delete;
 
  private:
-  void *sharder_;
   ParallelForFunc parallel_for_;
   GetCPUNumFunc get_cpu_num_;
 };
@@ -15,9 +15,9 @@
  */
 #include "eigen_threadpool.h"
 
-#include <sys/sysinfo.h>
 #include <unistd.h>
 
+#include "host_thread_config.h"
 #include "log.h"
 
 namespace {
@@ -40,8 +40,8 @@ EigenThreadPool *EigenThreadPool::GetInstance() {
   {
     std::unique_lock<std::mutex> lock(mutex_);
     if (!init_flag_) {
-      core_num_ = get_nprocs();  // obtains the number of CPU cores that can be
-                                 // used by users.
+      // cpus of the affinity mask and cgroup quota, or the configured number
+      core_num_ = static_cast<int32_t>(GetHostThreadConfig().thread_num);
       if (core_num_ <= 0) {
         KERNEL_LOG_INFO(
             "Get the number of CPU cores that can be used failed, core "
@@ -110,6 +110,21 @@ void EigenThreadPool::ParallelFor(int64_t total, int64_t per_unit_size,
   KERNEL_LOG_INFO("Eigen threadpool parallel for success");
 }
 
+void EigenThreadPool::ParallelFor(int64_t total, const ParallelForCost &cost,
+                                  const SharderWork &work) {
+  if ((total <= 0) || (work == nullptr)) {
+    KERNEL_LOG_ERROR("Invalid param: total[%lld] <= 0 or work is nullptr",
+                     total);
+    return;
+  }
+
+  threadpool_device_->parallelFor(
+      total,
+      Eigen::TensorOpCost(cost.bytes_loaded, cost.bytes_stored,
+                          cost.compute_cycles),
+      [&work](Eigen::Index first, Eigen::Index last) { work(first, last); });
+}
+
 /*
  * Get CPU number
  */
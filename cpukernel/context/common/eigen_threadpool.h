@@ -19,6 +19,8 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+
+#include "cpu_kernel_utils.h"
 #define EIGEN_USE_THREADS
 #include <unsupported/Eigen/CXX11/Tensor>
 
@@ -34,6 +36,12 @@ class EigenThreadPool {
    */
   void ParallelFor(int64_t total, int64_t perUnitSize, const SharderWork &work);
 
+  /*
+   * ParallelFor shards the "total" units of work by Eigen's cost model.
+   */
+  void ParallelFor(int64_t total, const ParallelForCost &cost,
+                   const SharderWork &work);
+
   /*
    * Get CPU number
    * @return CPU number
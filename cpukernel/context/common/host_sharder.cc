@@ -17,14 +17,23 @@
 
 #include "eigen_threadpool.h"
 #include "log.h"
+#include "work_stealing_pool.h"
 
 namespace aicpu {
+HostSharder::HostSharder(DeviceType device)
+    : Sharder(device), scheduler_(GetHostThreadConfig().scheduler) {}
+
 /*
  * ParallelFor shards the "total" units of work.
  */
 void HostSharder::ParallelFor(
     int64_t total, int64_t perUnitSize,
     const std::function<void(int64_t, int64_t)> &work) const {
+  if (scheduler_ == HOST_SCHEDULER_WORK_STEALING) {
+    WorkStealingPool::GetInstance()->ParallelFor(total, perUnitSize, work);
+    return;
+  }
+
   EigenThreadPool *threadpool = EigenThreadPool::GetInstance();
   if (threadpool == nullptr) {
     KERNEL_LOG_ERROR("Get eigen thread pool failed");
@@ -34,10 +43,35 @@ void HostSharder::ParallelFor(
   threadpool->ParallelFor(total, perUnitSize, work);
 }
 
+/*
+ * ParallelFor shards the "total" units of work by their expected cost.
+ */
+void HostSharder::ParallelFor(
+    int64_t total, const ParallelForCost &cost,
+    const std::function<void(int64_t, int64_t)> &work) const {
+  if (scheduler_ == HOST_SCHEDULER_WORK_STEALING) {
+    WorkStealingPool::GetInstance()->ParallelFor(total, CostToUnitSize(cost),
+                                                 work);
+    return;
+  }
+
+  EigenThreadPool *threadpool = EigenThreadPool::GetInstance();
+  if (threadpool == nullptr) {
+    KERNEL_LOG_ERROR("Get eigen thread pool failed");
+    return;
+  }
+
+  threadpool->ParallelFor(total, cost, work);
+}
+
 /*
  * Get CPU number
  */
 uint32_t HostSharder::GetCPUNum() const {
+  if (scheduler_ == HOST_SCHEDULER_WORK_STEALING) {
+    return WorkStealingPool::GetInstance()->GetCPUNum();
+  }
+
   EigenThreadPool *threadpool = EigenThreadPool::GetInstance();
   if (threadpool == nullptr) {
     KERNEL_LOG_ERROR("Get eigen thread pool failed");
@@ -46,4 +80,14 @@ uint32_t HostSharder::GetCPUNum() const {
 
   return threadpool->GetCPUNum();
 }
+
+/*
+ * whether a shard may start a parallel for of its own on this sharder.
+ */
+bool HostSharder::SupportNested() const {
+  // a thread of the work stealing pool runs a nested parallel for as a new
+  // job other threads can steal from, the Eigen pool would wait on its own
+  // threads
+  return scheduler_ == HOST_SCHEDULER_WORK_STEALING;
+}
 }  // namespace aicpu
@@ -15,12 +15,17 @@
  */
 #ifndef AICPU_CONTEXT_COMMON_HOST_SHARDER_H_
 #define AICPU_CONTEXT_COMMON_HOST_SHARDER_H_
+#include "host_thread_config.h"
 #include "sharder.h"
 
 namespace aicpu {
+/*
+ * Sharder of host kernels. It runs them on the Eigen thread pool, or on the
+ * work stealing pool when AICPU_HOST_SCHEDULER selects it.
+ */
 class HostSharder : public Sharder {
  public:
-  explicit HostSharder(DeviceType device) : Sharder(device){};
+  explicit HostSharder(DeviceType device);
 
   ~HostSharder() = default;
 
@@ -34,17 +39,36 @@ class HostSharder : public Sharder {
       int64_t total, int64_t perUnitSize,
       const std::function<void(int64_t, int64_t)> &work) const override;
 
+  /*
+   * ParallelFor shards the "total" units of work by their expected cost.
+   * @param total: size of total work
+   * @param cost: expected cost of per unit work
+   * @param work: process of per unit work
+   */
+  void ParallelFor(
+      int64_t total, const ParallelForCost &cost,
+      const std::function<void(int64_t, int64_t)> &work) const override;
+
   /*
    * Get CPU number
    * @return CPU number
    */
   uint32_t GetCPUNum() const override;
 
+  /*
+   * whether a shard may start a parallel for of its own on this sharder.
+   * @return bool: true for the work stealing pool
+   */
+  bool SupportNested() const override;
+
  private:
   HostSharder(const HostSharder &) = delete;
   HostSharder(HostSharder &&) = delete;
   HostSharder &operator=(const HostSharder &) = delete;
   HostSharder &operator=(HostSharder &&) = delete;
+
+ private:
+  HostScheduler scheduler_;
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_COMMON_HOST_SHARDER_H_
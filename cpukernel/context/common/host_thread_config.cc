@@ -0,0 +1,144 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "host_thread_config.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sysinfo.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#include "log.h"
+
+namespace {
+const char *kSchedulerEnv = "AICPU_HOST_SCHEDULER";
+const char *kThreadNumEnv = "AICPU_HOST_THREAD_NUM";
+const char *kThreadPinEnv = "AICPU_HOST_THREAD_PIN";
+const char *kWorkStealing = "work_stealing";
+const char *kCgroupV2CpuMax = "/sys/fs/cgroup/cpu.max";
+const char *kCgroupV1Quota = "/sys/fs/cgroup/cpu/cpu.cfs_quota_us";
+const char *kCgroupV1Period = "/sys/fs/cgroup/cpu/cpu.cfs_period_us";
+const uint32_t kMaxThreadNum = 1024;
+
+/*
+ * cpus of a quota over a period, 0 if either is not positive.
+ */
+uint32_t QuotaToCpus(int64_t quota, int64_t period) {
+  if ((quota <= 0) || (period <= 0)) {
+    return 0;
+  }
+  return static_cast<uint32_t>((quota + period - 1) / period);
+}
+}  // namespace
+
+namespace aicpu {
+/*
+ * get the cpus in the affinity mask of the calling thread.
+ */
+std::vector<uint32_t> GetAllowedCpus() {
+  std::vector<uint32_t> cpus;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+    KERNEL_LOG_WARN("Get cpu affinity failed, error[%s]", strerror(errno));
+    return cpus;
+  }
+  for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/*
+ * get the cpus the cgroup cpu quota of the process amounts to.
+ */
+uint32_t GetCgroupCpuLimit() {
+  // cgroup v2: "<quota> <period>", quota "max" for none
+  std::ifstream cpu_max(kCgroupV2CpuMax);
+  if (cpu_max.is_open()) {
+    std::string quota;
+    int64_t period = 0;
+    if ((cpu_max >> quota >> period) && (quota != "max")) {
+      return QuotaToCpus(atoll(quota.c_str()), period);
+    }
+    return 0;
+  }
+
+  // cgroup v1: quota -1 for none
+  std::ifstream quota_file(kCgroupV1Quota);
+  std::ifstream period_file(kCgroupV1Period);
+  int64_t quota = 0;
+  int64_t period = 0;
+  if ((quota_file >> quota) && (period_file >> period)) {
+    return QuotaToCpus(quota, period);
+  }
+  return 0;
+}
+
+/*
+ * read the config from the current environment.
+ */
+HostThreadConfig LoadHostThreadConfig() {
+  HostThreadConfig config;
+  const char *scheduler = getenv(kSchedulerEnv);
+  if ((scheduler != nullptr) && (strcmp(scheduler, kWorkStealing) == 0)) {
+    config.scheduler = HOST_SCHEDULER_WORK_STEALING;
+  }
+  const char *pin = getenv(kThreadPinEnv);
+  config.pin_threads = (pin != nullptr) && (strcmp(pin, "1") == 0);
+
+  config.cpus = GetAllowedCpus();
+  uint32_t cpu_num = config.cpus.empty()
+                         ? static_cast<uint32_t>(std::max(get_nprocs(), 1))
+                         : static_cast<uint32_t>(config.cpus.size());
+  uint32_t cgroup_limit = GetCgroupCpuLimit();
+  if ((cgroup_limit != 0) && (cgroup_limit < cpu_num)) {
+    cpu_num = cgroup_limit;
+  }
+  config.thread_num = cpu_num;
+
+  const char *thread_num = getenv(kThreadNumEnv);
+  if (thread_num != nullptr) {
+    int64_t value = atoll(thread_num);
+    if ((value > 0) && (value <= kMaxThreadNum)) {
+      config.thread_num = static_cast<uint32_t>(value);
+    } else {
+      KERNEL_LOG_WARN("Ignore %s[%s], it must be in [1, %u]", kThreadNumEnv,
+                      thread_num, kMaxThreadNum);
+    }
+  }
+  KERNEL_LOG_INFO(
+      "Host thread config: scheduler[%d], thread number[%u], pin[%d], "
+      "allowed cpus[%zu], cgroup cpu limit[%u]",
+      config.scheduler, config.thread_num, config.pin_threads,
+      config.cpus.size(), cgroup_limit);
+  return config;
+}
+
+/*
+ * get the config of the process.
+ */
+const HostThreadConfig &GetHostThreadConfig() {
+  static const HostThreadConfig config = LoadHostThreadConfig();
+  return config;
+}
+}  // namespace aicpu
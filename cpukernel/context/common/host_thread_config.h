@@ -0,0 +1,68 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_HOST_THREAD_CONFIG_H_
+#define AICPU_CONTEXT_COMMON_HOST_THREAD_CONFIG_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace aicpu {
+enum HostScheduler {
+  HOST_SCHEDULER_EIGEN = 0,
+  HOST_SCHEDULER_WORK_STEALING = 1
+};
+
+/*
+ * Threads used by the host sharder, set by the environment:
+ *   AICPU_HOST_SCHEDULER: "eigen", the default, or "work_stealing"
+ *   AICPU_HOST_THREAD_NUM: threads of a parallel for, its caller included
+ *   AICPU_HOST_THREAD_PIN: "1" binds every pool thread to one allowed cpu
+ * Without a thread number the pool gets one thread per cpu the process may
+ * run on: its affinity mask, capped by the cgroup cpu quota.
+ */
+struct HostThreadConfig {
+  HostScheduler scheduler = HOST_SCHEDULER_EIGEN;
+  uint32_t thread_num = 1;
+  bool pin_threads = false;
+  std::vector<uint32_t> cpus;  // allowed cpus in ascending order
+};
+
+/*
+ * get the config of the process, the environment is read on the first call.
+ * @return const HostThreadConfig &: config shared by all host sharders
+ */
+const HostThreadConfig &GetHostThreadConfig();
+
+/*
+ * read the config from the current environment.
+ * @return HostThreadConfig: config
+ */
+HostThreadConfig LoadHostThreadConfig();
+
+/*
+ * get the cpus in the affinity mask of the calling thread.
+ * @return std::vector<uint32_t>: cpu ids, empty if the mask can not be read
+ */
+std::vector<uint32_t> GetAllowedCpus();
+
+/*
+ * get the cpus the cgroup cpu quota of the process amounts to, rounded up.
+ * @return uint32_t: cpu number, 0 if there is no quota
+ */
+uint32_t GetCgroupCpuLimit();
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_HOST_THREAD_CONFIG_H_
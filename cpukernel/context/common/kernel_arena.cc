@@ -0,0 +1,50 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "kernel_arena.h"
+
+namespace {
+google::protobuf::ArenaOptions InitialBlockOptions(char *block, size_t size) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  return options;
+}
+}  // namespace
+
+namespace aicpu {
+KernelArena::KernelArena()
+    : proto_arena_(InitialBlockOptions(initial_block_, kInitialBlockSize)),
+      cur_(nullptr),
+      left_(0) {}
+
+/*
+ * allocate memory freed with the arena.
+ */
+void *KernelArena::Allocate(size_t size) {
+  size = (size + kAlign - 1) & ~(kAlign - 1);
+  if (size > kBlockSize / 4) {
+    return google::protobuf::Arena::CreateArray<char>(&proto_arena_, size);
+  }
+  if (size > left_) {
+    cur_ = google::protobuf::Arena::CreateArray<char>(&proto_arena_, kBlockSize);
+    left_ = kBlockSize;
+  }
+  void *ptr = cur_;
+  cur_ += size;
+  left_ -= size;
+  return ptr;
+}
+}  // namespace aicpu
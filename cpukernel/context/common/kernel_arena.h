@@ -0,0 +1,126 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_KERNEL_ARENA_H_
+#define AICPU_CONTEXT_COMMON_KERNEL_ARENA_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <google/protobuf/arena.h>
+
+namespace aicpu {
+/*
+ * Memory of one node def and the wrappers of its tensors and attrs. The node
+ * def proto is parsed into a protobuf Arena, wrapper objects and their
+ * shared_ptr control blocks are bumped from blocks of the same arena. All of
+ * it is freed at once with the arena, never piece by piece. Not thread safe.
+ */
+class KernelArena {
+ public:
+  KernelArena();
+  ~KernelArena() = default;
+
+  /*
+   * get protobuf arena.
+   * @return google::protobuf::Arena *: arena for protos
+   */
+  google::protobuf::Arena *GetProtoArena() { return &proto_arena_; }
+
+  /*
+   * allocate memory freed with the arena.
+   * @param size: bytes
+   * @return void *: kAlign aligned memory
+   */
+  void *Allocate(size_t size);
+
+  /*
+   * construct an object in the arena, only its destructor runs on release.
+   * @return T *: object
+   */
+  template <class T, class... Args>
+  T *New(Args &&... args) {
+    static_assert(alignof(T) <= kAlign, "Over aligned arena object.");
+    return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+
+  static const size_t kAlign = 8;
+
+ private:
+  KernelArena(const KernelArena &) = delete;
+  KernelArena(KernelArena &&) = delete;
+  KernelArena &operator=(const KernelArena &) = delete;
+  KernelArena &operator=(KernelArena &&) = delete;
+
+  static const size_t kInitialBlockSize = 4096;
+  static const size_t kBlockSize = 1024;
+
+  alignas(kAlign) char initial_block_[kInitialBlockSize];  // first block of proto_arena_
+  google::protobuf::Arena proto_arena_;
+  char *cur_;
+  size_t left_;
+};
+
+/*
+ * allocator placing shared_ptr control blocks in an arena.
+ */
+template <class T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  explicit ArenaAllocator(KernelArena *arena) : arena_(arena) {}
+
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_) {}
+
+  T *allocate(size_t n) {
+    static_assert(alignof(T) <= KernelArena::kAlign, "Over aligned arena object.");
+    return static_cast<T *>(arena_->Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *, size_t) {}
+
+  KernelArena *arena_;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena_ == b.arena_;
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena_ != b.arena_;
+}
+
+/*
+ * share an object, allocated by arena->New if arena is not null, by new
+ * otherwise.
+ * @return std::shared_ptr<T>: owner of object
+ */
+template <class T>
+std::shared_ptr<T> ShareArenaObject(T *object, KernelArena *arena) {
+  if (arena == nullptr) {
+    return std::shared_ptr<T>(object);
+  }
+  return std::shared_ptr<T>(object, [](T *p) { p->~T(); },
+                            ArenaAllocator<T>(arena));
+}
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_KERNEL_ARENA_H_
@@ -20,10 +20,9 @@
 
 #include <list>
 #include <memory>
-#include <unordered_map>
-#include <mutex>
 
 #include "log.h"
+#include "sharded_cache.h"
 
 namespace aicpu {
 template <class T>
@@ -40,7 +39,11 @@ class KernelCache {
    */
   int32_t Init(bool sess_flag) {
     sess_flag_ = sess_flag;
-    return InitParameter();
+    int32_t ret = InitParameter();
+    if (ret == 0) {
+      kernel_cache_.Init(sess_flag_ ? 0 : capacity_);
+    }
+    return ret;
   }
 
   /*
@@ -51,66 +54,29 @@ class KernelCache {
   virtual int32_t RunKernel(void *param) = 0;
 
   /*
-   * get kernel cache, the lru algorithm is supported in non-session scenarios
+   * get kernel cache without locking, non-session scenarios keep an
+   * approximate lru order
    * @param key: kernel id
-   * @return T *: cache content pointer
+   * @return std::shared_ptr<T>: cache content, nullptr if absent
    */
-  T *GetCache(uint64_t key) {
+  std::shared_ptr<T> GetCache(uint64_t key) {
     KERNEL_LOG_DEBUG("GetCache begin, key[%llu].", key);
-    T *ret = nullptr;
-    std::unique_lock<std::mutex> lock(kernel_mutex_);
-    auto it = kernel_cache_iter_.find(key);
-    if (it != kernel_cache_iter_.end()) {
+    std::shared_ptr<T> ret = kernel_cache_.Get(key);
+    if (ret != nullptr) {
       KERNEL_LOG_DEBUG("GetCache success, key[%llu].", key);
-      ret = it->second->second.get();
-      if (!sess_flag_) {
-        auto pair_iter = it->second;
-        std::pair<uint64_t, std::shared_ptr<T>> pair = *pair_iter;
-        kernel_cache_.erase(pair_iter);
-        kernel_cache_.push_front(pair);
-        kernel_cache_iter_[key] = kernel_cache_.begin();
-      }
     }
     return ret;
   }
 
   /*
-   * set kernel cache, the lru algorithm is supported in non-session scenarios
+   * set kernel cache, non-session scenarios evict beyond the capacity
    * @param key: kernel id
    * @param value: cache content
    */
   void SetCache(uint64_t key, std::shared_ptr<T> value) {
     KERNEL_LOG_DEBUG("SetCache begin, key[%llu].", key);
-    std::unique_lock<std::mutex> lock(kernel_mutex_);
-    auto iter = kernel_cache_iter_.find(key);
-    if (iter != kernel_cache_iter_.end()) {
-      KERNEL_LOG_DEBUG("SetCache update cache, key[%llu].", key);
-      auto pair_iter = iter->second;
-      pair_iter->second = value;
-      if (!sess_flag_) {
-        std::pair<uint64_t, std::shared_ptr<T>> pair = *pair_iter;
-        kernel_cache_.erase(pair_iter);
-        kernel_cache_.push_front(pair);
-        kernel_cache_iter_[key] = kernel_cache_.begin();
-      }
-    } else {
-      std::pair<uint64_t, std::shared_ptr<T>> pair = std::make_pair(key, value);
-      if ((capacity_ < kernel_cache_.size()) && (!sess_flag_)) {
-        uint64_t del_key = kernel_cache_.back().first;
-        KERNEL_LOG_DEBUG(
-            "SetCache is full, pop last element, capacity[%u], delete "
-            "key[%llu].",
-            capacity_, key);
-        kernel_cache_.pop_back();
-        auto del_iter = kernel_cache_iter_.find(del_key);
-        if (del_iter != kernel_cache_iter_.end()) {
-          kernel_cache_iter_.erase(del_iter);
-        }
-      }
-      KERNEL_LOG_DEBUG("SetCache success, key[%llu].", key);
-      kernel_cache_.push_front(pair);
-      kernel_cache_iter_[key] = kernel_cache_.begin();
-    }
+    kernel_cache_.Set(key, value);
+    KERNEL_LOG_DEBUG("SetCache success, key[%llu].", key);
   }
 
   /*
@@ -126,7 +92,7 @@ class KernelCache {
   uint32_t GetCapacity() { return capacity_; }
 
   /*
-   * set kernel cache capacity
+   * set kernel cache capacity, takes effect in Init
    * @param capacity: lru capacity
    */
   void SetCapacity(uint32_t capacity) { capacity_ = capacity; }
@@ -137,7 +103,7 @@ class KernelCache {
    * pair<kernel id, cahce>
    */
   std::list<std::pair<uint64_t, std::shared_ptr<T>>> GetAllKernelCache() {
-    return kernel_cache_;
+    return kernel_cache_.GetAll();
   }
 
  protected:
@@ -151,13 +117,7 @@ class KernelCache {
 
   bool sess_flag_;  // whether it's a session scene, false need to support LRU
   uint32_t capacity_;  // lru capacity
-  std::mutex kernel_mutex_;
-  std::list<std::pair<uint64_t, std::shared_ptr<T>>>
-      kernel_cache_;  // all kernel cache, key is kernel id
-  std::unordered_map<
-      uint64_t, typename std::list<std::pair<uint64_t, std::shared_ptr<T>>>::
-                    iterator>  // iterator of kernel cahce, key is kernel id
-      kernel_cache_iter_;
+  ShardedCache<T> kernel_cache_;  // all kernel cache, key is kernel id
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_COMMON_KERNEL_CACHE_H_
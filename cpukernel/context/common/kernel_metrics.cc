@@ -0,0 +1,371 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "kernel_metrics.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+#include "log.h"
+
+namespace {
+const char *kMetricsEnv = "AICPU_KERNEL_METRICS";
+const char *kMetricsFileEnv = "AICPU_KERNEL_METRICS_FILE";
+const char *kMetricsIntervalEnv = "AICPU_KERNEL_METRICS_INTERVAL_MS";
+const uint32_t kDefaultIntervalMs = 10000;
+const uint32_t kMinIntervalMs = 100;
+const double kNsPerUs = 1000.0;
+
+/*
+ * append printf style text to a string.
+ */
+void Append(std::string &out, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void Append(std::string &out, const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len > 0) {
+    out.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+  }
+}
+
+/*
+ * append a json string, op types are plain names but escape anyway.
+ */
+void AppendJsonString(std::string &out, const std::string &value) {
+  out.push_back('"');
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      Append(out, "\\u%04x", static_cast<unsigned char>(c));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+/*
+ * append the count and the latencies of a histogram as json members.
+ */
+void AppendHistogram(std::string &out, const aicpu::LatencyHistogram &hist) {
+  uint64_t count = hist.Count();
+  double mean = count == 0 ? 0 : static_cast<double>(hist.Sum()) / count;
+  Append(out,
+         "\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,"
+         "\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f",
+         static_cast<unsigned long long>(count), mean / kNsPerUs,
+         hist.Percentile(50) / kNsPerUs, hist.Percentile(90) / kNsPerUs,
+         hist.Percentile(99) / kNsPerUs, hist.Percentile(99.9) / kNsPerUs,
+         hist.Max() / kNsPerUs);
+}
+
+unsigned long long Load(const std::atomic<uint64_t> &value) {
+  return static_cast<unsigned long long>(
+      value.load(std::memory_order_relaxed));
+}
+}  // namespace
+
+namespace aicpu {
+const uint32_t LatencyHistogram::kSubBucketBits;
+const uint32_t LatencyHistogram::kSubBucketNum;
+const uint32_t LatencyHistogram::kMaxValueBits;
+const uint32_t LatencyHistogram::kBucketNum;
+const uint32_t KernelMetricsRegistry::kMaxOpTypeNum;
+
+LatencyHistogram::LatencyHistogram() : sum_(0), max_(0) {
+  for (uint32_t i = 0; i < kBucketNum; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/*
+ * index of the bucket holding value.
+ */
+uint32_t LatencyHistogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketNum) {
+    return static_cast<uint32_t>(value);
+  }
+  uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+  if (exponent >= kMaxValueBits) {
+    return kBucketNum - 1;
+  }
+  uint32_t shift = exponent - kSubBucketBits;
+  uint32_t sub = static_cast<uint32_t>(value >> shift) - kSubBucketNum;
+  return (shift + 1) * kSubBucketNum + sub;
+}
+
+/*
+ * largest value of a bucket.
+ */
+uint64_t LatencyHistogram::BucketUpperBound(uint32_t index) {
+  if (index < kSubBucketNum) {
+    return index;
+  }
+  uint32_t shift = index / kSubBucketNum - 1;
+  uint64_t sub = index % kSubBucketNum;
+  return ((kSubBucketNum + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t LatencyHistogram::Count() const {
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < kBucketNum; ++i) {
+    count += buckets_[i].load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+uint64_t LatencyHistogram::Percentile(double percent) const {
+  uint64_t counts[kBucketNum];
+  uint64_t total = 0;
+  // one pass over the buckets, so a concurrent record can not skew the rank
+  for (uint32_t i = 0; i < kBucketNum; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  percent = std::max(0.0, std::min(100.0, percent));
+  uint64_t rank = static_cast<uint64_t>(percent / 100.0 * total + 0.5);
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < kBucketNum; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), Max());
+    }
+  }
+  return Max();
+}
+
+void LatencyHistogram::Reset() {
+  for (uint32_t i = 0; i < kBucketNum; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+/*
+ * get instance.
+ */
+KernelMetricsRegistry &KernelMetricsRegistry::Instance() {
+  static KernelMetricsRegistry instance;
+  return instance;
+}
+
+KernelMetricsRegistry::KernelMetricsRegistry() : enabled_(true) {
+  for (uint32_t i = 0; i < kMaxOpTypeNum; ++i) {
+    slots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+  const char *enabled = getenv(kMetricsEnv);
+  if ((enabled != nullptr) && (strcmp(enabled, "0") == 0)) {
+    enabled_.store(false, std::memory_order_relaxed);
+  }
+  const char *path = getenv(kMetricsFileEnv);
+  if ((path == nullptr) || (path[0] == '\0')) {
+    return;
+  }
+  uint32_t interval_ms = kDefaultIntervalMs;
+  const char *interval = getenv(kMetricsIntervalEnv);
+  if (interval != nullptr) {
+    char *end = nullptr;
+    unsigned long value = strtoul(interval, &end, 10);
+    if ((end != interval) && (*end == '\0') && (value >= kMinIntervalMs) &&
+        (value <= UINT32_MAX)) {
+      interval_ms = static_cast<uint32_t>(value);
+    } else {
+      KERNEL_LOG_WARN("Invalid %s[%s], use [%u] ms.", kMetricsIntervalEnv,
+                      interval, kDefaultIntervalMs);
+    }
+  }
+  StartSnapshotWriter(path, interval_ms);
+}
+
+KernelMetricsRegistry::~KernelMetricsRegistry() { StopSnapshotWriter(); }
+
+/*
+ * get the metrics of an op type, created on its first use.
+ */
+KernelMetrics *KernelMetricsRegistry::GetKernelMetrics(
+    const std::string &op_type) {
+  uint32_t first = std::hash<std::string>()(op_type) % kMaxOpTypeNum;
+  for (uint32_t probe = 0; probe < kMaxOpTypeNum; ++probe) {
+    KernelMetrics *metrics =
+        slots_[(first + probe) % kMaxOpTypeNum].load(std::memory_order_acquire);
+    if (metrics == nullptr) {
+      break;
+    }
+    if (metrics->op_type == op_type) {
+      return metrics;
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (uint32_t probe = 0; probe < kMaxOpTypeNum; ++probe) {
+    std::atomic<KernelMetrics *> &slot = slots_[(first + probe) % kMaxOpTypeNum];
+    KernelMetrics *metrics = slot.load(std::memory_order_relaxed);
+    if (metrics != nullptr) {
+      if (metrics->op_type == op_type) {
+        return metrics;
+      }
+      continue;
+    }
+    metrics = new (std::nothrow) KernelMetrics(op_type);
+    KERNEL_CHECK_NULLPTR(metrics, nullptr, "Create kernel metrics failed.")
+    metrics_.emplace_back(metrics);
+    slot.store(metrics, std::memory_order_release);
+    return metrics;
+  }
+  KERNEL_LOG_WARN("Kernel metrics of [%u] op types are tracked, drop [%s].",
+                  kMaxOpTypeNum, op_type.c_str());
+  return nullptr;
+}
+
+/*
+ * dump all metrics as json.
+ */
+std::string KernelMetricsRegistry::Dump() const {
+  std::vector<const KernelMetrics *> all;
+  for (uint32_t i = 0; i < kMaxOpTypeNum; ++i) {
+    KernelMetrics *metrics = slots_[i].load(std::memory_order_acquire);
+    if (metrics != nullptr) {
+      all.push_back(metrics);
+    }
+  }
+  std::sort(all.begin(), all.end(),
+            [](const KernelMetrics *a, const KernelMetrics *b) {
+              return a->op_type < b->op_type;
+            });
+
+  std::string out = "{\"kernels\":[";
+  for (size_t i = 0; i < all.size(); ++i) {
+    out.append(i == 0 ? "{\"op_type\":" : ",{\"op_type\":");
+    AppendJsonString(out, all[i]->op_type);
+    Append(out, ",\"failures\":%llu,", Load(all[i]->failures));
+    AppendHistogram(out, all[i]->compute_time);
+    out.push_back('}');
+  }
+  Append(out,
+         "],\"launch\":{\"context_cache_hits\":%llu,"
+         "\"context_cache_misses\":%llu,\"ext_info_plan_hits\":%llu,"
+         "\"ext_info_plan_misses\":%llu,\"ext_info_parse\":{",
+         Load(launch_.context_cache_hits), Load(launch_.context_cache_misses),
+         Load(launch_.ext_info_plan_hits), Load(launch_.ext_info_plan_misses));
+  AppendHistogram(out, launch_.ext_info_parse_time);
+  out.append("}}}\n");
+  return out;
+}
+
+/*
+ * write Dump to a file, replacing it at once.
+ */
+bool KernelMetricsRegistry::WriteSnapshot(const std::string &path) const {
+  std::string content = Dump();
+  std::string tmp_path = path + ".tmp";
+  FILE *file = fopen(tmp_path.c_str(), "w");
+  if (file == nullptr) {
+    KERNEL_LOG_WARN("Open kernel metrics file[%s] failed, error[%s].",
+                    tmp_path.c_str(), strerror(errno));
+    return false;
+  }
+  bool written = fwrite(content.data(), 1, content.size(), file) == content.size();
+  written = (fclose(file) == 0) && written;
+  if (!written || (rename(tmp_path.c_str(), path.c_str()) != 0)) {
+    KERNEL_LOG_WARN("Write kernel metrics file[%s] failed, error[%s].",
+                    path.c_str(), strerror(errno));
+    (void)remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void KernelMetricsRegistry::StartSnapshotWriter(const std::string &path,
+                                                uint32_t interval_ms) {
+  StopSnapshotWriter();
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  writer_stop_ = false;
+  writer_ = std::thread(&KernelMetricsRegistry::SnapshotLoop, this, path,
+                        std::max(interval_ms, 1u));
+  KERNEL_LOG_INFO("Write kernel metrics to [%s] every [%u] ms.", path.c_str(),
+                  interval_ms);
+}
+
+void KernelMetricsRegistry::StopSnapshotWriter() {
+  std::thread writer;
+  {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    writer_stop_ = true;
+    writer.swap(writer_);
+  }
+  writer_cond_.notify_all();
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+void KernelMetricsRegistry::SnapshotLoop(std::string path,
+                                         uint32_t interval_ms) {
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  while (!writer_stop_) {
+    (void)writer_cond_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                                [this]() { return writer_stop_; });
+    lock.unlock();
+    (void)WriteSnapshot(path);
+    lock.lock();
+  }
+}
+
+/*
+ * zero all metrics, op types seen stay tracked.
+ */
+void KernelMetricsRegistry::Reset() {
+  for (uint32_t i = 0; i < kMaxOpTypeNum; ++i) {
+    KernelMetrics *metrics = slots_[i].load(std::memory_order_acquire);
+    if (metrics != nullptr) {
+      metrics->compute_time.Reset();
+      metrics->failures.store(0, std::memory_order_relaxed);
+    }
+  }
+  launch_.context_cache_hits.store(0, std::memory_order_relaxed);
+  launch_.context_cache_misses.store(0, std::memory_order_relaxed);
+  launch_.ext_info_plan_hits.store(0, std::memory_order_relaxed);
+  launch_.ext_info_plan_misses.store(0, std::memory_order_relaxed);
+  launch_.ext_info_parse_time.Reset();
+}
+}  // namespace aicpu
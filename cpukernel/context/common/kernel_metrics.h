@@ -0,0 +1,219 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_KERNEL_METRICS_H_
+#define AICPU_CONTEXT_COMMON_KERNEL_METRICS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aicpu {
+/*
+ * Latency histogram in nanoseconds with log-linear buckets, as HDR histograms
+ * have: every power of two is split into kSubBucketNum equal buckets, so a
+ * percentile is off by at most 1 / kSubBucketNum of its value. Record only
+ * adds to atomics and may run on any number of threads at once.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  ~LatencyHistogram() = default;
+
+  /*
+   * add one value.
+   * @param value: nanoseconds, values beyond the last bucket land in it
+   */
+  void Record(uint64_t value);
+
+  /*
+   * @return uint64_t: values recorded
+   */
+  uint64_t Count() const;
+
+  /*
+   * @return uint64_t: sum of the values recorded
+   */
+  uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+
+  /*
+   * @return uint64_t: largest value recorded
+   */
+  uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+  /*
+   * get the value a percentage of the recorded values do not exceed.
+   * @param percent: in [0, 100]
+   * @return uint64_t: upper bound of the bucket holding it, 0 if empty
+   */
+  uint64_t Percentile(double percent) const;
+
+  /*
+   * drop all values, values recorded meanwhile may be partly kept.
+   */
+  void Reset();
+
+  /*
+   * @param value: nanoseconds
+   * @return uint32_t: index of the bucket holding value
+   */
+  static uint32_t BucketIndex(uint64_t value);
+
+  /*
+   * @param index: bucket index
+   * @return uint64_t: largest value the bucket holds
+   */
+  static uint64_t BucketUpperBound(uint32_t index);
+
+  static const uint32_t kSubBucketBits = 4;
+  static const uint32_t kSubBucketNum = 1u << kSubBucketBits;
+  // values up to 2^40 ns, about 18 minutes
+  static const uint32_t kMaxValueBits = 40;
+  static const uint32_t kBucketNum =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBucketNum;
+
+ private:
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  std::atomic<uint64_t> buckets_[kBucketNum];
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+/*
+ * Metrics of the kernels of one op type.
+ */
+struct KernelMetrics {
+  explicit KernelMetrics(const std::string &type) : op_type(type) {}
+  const std::string op_type;
+  LatencyHistogram compute_time;  // Compute, or ComputeAsync until done
+  std::atomic<uint64_t> failures{0};
+};
+
+/*
+ * Metrics of the launch path in front of the kernels.
+ */
+struct LaunchMetrics {
+  std::atomic<uint64_t> context_cache_hits{0};
+  std::atomic<uint64_t> context_cache_misses{0};
+  std::atomic<uint64_t> ext_info_plan_hits{0};
+  std::atomic<uint64_t> ext_info_plan_misses{0};
+  LatencyHistogram ext_info_parse_time;
+};
+
+/*
+ * Metrics of the process, set by the environment:
+ *   AICPU_KERNEL_METRICS: "0" records nothing
+ *   AICPU_KERNEL_METRICS_FILE: file Dump is written to periodically
+ *   AICPU_KERNEL_METRICS_INTERVAL_MS: period of the file, 10000 by default
+ * Looking up the metrics of an op type takes no lock once it was seen.
+ */
+class KernelMetricsRegistry {
+ public:
+  /*
+   * get instance.
+   * @return KernelMetricsRegistry &: registry of the process
+   */
+  static KernelMetricsRegistry &Instance();
+
+  ~KernelMetricsRegistry();
+
+  /*
+   * @return bool: whether launches record metrics
+   */
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /*
+   * turn recording on or off, metrics recorded so far are kept.
+   * @param enabled: whether launches record metrics
+   */
+  void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /*
+   * get the metrics of an op type, created on its first use.
+   * @param op_type: op type of kernel
+   * @return KernelMetrics *: metrics living as long as the registry, nullptr
+   * if kMaxOpTypeNum op types are already tracked
+   */
+  KernelMetrics *GetKernelMetrics(const std::string &op_type);
+
+  /*
+   * @return LaunchMetrics &: launch path metrics
+   */
+  LaunchMetrics &GetLaunchMetrics() { return launch_; }
+
+  /*
+   * dump all metrics as json, times in microseconds.
+   * @return std::string: json object with "kernels" and "launch"
+   */
+  std::string Dump() const;
+
+  /*
+   * write Dump to a file, replacing it at once.
+   * @param path: file path
+   * @return bool: whether the file was written
+   */
+  bool WriteSnapshot(const std::string &path) const;
+
+  /*
+   * start a thread writing a snapshot every interval and once more on stop,
+   * a running one is stopped first.
+   * @param path: file path
+   * @param interval_ms: period in milliseconds
+   */
+  void StartSnapshotWriter(const std::string &path, uint32_t interval_ms);
+
+  /*
+   * stop the snapshot thread, if any.
+   */
+  void StopSnapshotWriter();
+
+  /*
+   * zero all metrics, op types seen stay tracked.
+   */
+  void Reset();
+
+  static const uint32_t kMaxOpTypeNum = 1024;
+
+ private:
+  KernelMetricsRegistry();
+  KernelMetricsRegistry(const KernelMetricsRegistry &) = delete;
+  KernelMetricsRegistry &operator=(const KernelMetricsRegistry &) = delete;
+
+  void SnapshotLoop(std::string path, uint32_t interval_ms);
+
+  std::atomic<bool> enabled_;
+  // open addressing by the hash of op type, a slot is set once
+  std::atomic<KernelMetrics *> slots_[kMaxOpTypeNum];
+  std::mutex mutex_;  // protects metrics_ and slot insertion
+  std::vector<std::unique_ptr<KernelMetrics>> metrics_;
+  LaunchMetrics launch_;
+
+  std::mutex writer_mutex_;  // protects the snapshot thread and its state
+  std::condition_variable writer_cond_;
+  bool writer_stop_ = false;
+  std::thread writer_;
+};
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_KERNEL_METRICS_H_
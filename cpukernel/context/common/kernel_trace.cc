@@ -0,0 +1,239 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "kernel_trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "aicpu_context.h"
+#include "log.h"
+
+namespace {
+const char *kTraceFileEnv = "AICPU_KERNEL_TRACE_FILE";
+const char *kTraceEventsEnv = "AICPU_KERNEL_TRACE_EVENTS";
+const uint32_t kDefaultEventsPerThread = 16384;
+const uint32_t kMaxEventsPerThread = 1u << 24;
+
+thread_local aicpu::TraceLaunch g_launch;
+}  // namespace
+
+namespace aicpu {
+const uint32_t TraceLaunch::kOpTypeLen;
+
+void TraceLaunch::SetOpType(const std::string &type) {
+  size_t len = std::min(type.size(), static_cast<size_t>(kOpTypeLen - 1));
+  memcpy(op_type, type.data(), len);
+  op_type[len] = '\0';
+}
+
+struct KernelTracer::ThreadTrace {
+  std::mutex mutex;  // the owner records, Dump and Enable read and reset
+  uint32_t tid = 0;
+  uint64_t next = 0;  // events recorded, the ring keeps the last ones
+  std::vector<TraceEvent> events;
+};
+
+thread_local std::shared_ptr<KernelTracer::ThreadTrace>
+    KernelTracer::thread_trace_;
+
+/*
+ * get instance.
+ */
+KernelTracer &KernelTracer::Instance() {
+  static KernelTracer instance;
+  return instance;
+}
+
+KernelTracer::KernelTracer()
+    : enabled_(false), events_per_thread_(kDefaultEventsPerThread) {
+  const char *path = getenv(kTraceFileEnv);
+  if ((path == nullptr) || (path[0] == '\0')) {
+    return;
+  }
+  path_ = path;
+  uint32_t events_per_thread = kDefaultEventsPerThread;
+  const char *events = getenv(kTraceEventsEnv);
+  if (events != nullptr) {
+    char *end = nullptr;
+    unsigned long value = strtoul(events, &end, 10);
+    if ((end != events) && (*end == '\0') && (value > 0) &&
+        (value <= kMaxEventsPerThread)) {
+      events_per_thread = static_cast<uint32_t>(value);
+    } else {
+      KERNEL_LOG_WARN("Invalid %s[%s], use [%u].", kTraceEventsEnv, events,
+                      kDefaultEventsPerThread);
+    }
+  }
+  Enable(events_per_thread);
+  KERNEL_LOG_INFO("Trace [%u] kernel events per thread to [%s].",
+                  events_per_thread, path);
+}
+
+KernelTracer::~KernelTracer() {
+  Disable();
+  if (!path_.empty()) {
+    (void)WriteTrace(path_);
+  }
+}
+
+/*
+ * drop all events and start recording.
+ */
+void KernelTracer::Enable(uint32_t events_per_thread) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  events_per_thread_ = std::max(events_per_thread, 1u);
+  for (auto &thread : threads_) {
+    std::unique_lock<std::mutex> thread_lock(thread->mutex);
+    thread->events.assign(events_per_thread_, TraceEvent());
+    thread->next = 0;
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+KernelTracer::ThreadTrace *KernelTracer::GetThreadTrace() {
+  if (thread_trace_ != nullptr) {
+    return thread_trace_.get();
+  }
+  std::shared_ptr<ThreadTrace> thread = std::make_shared<ThreadTrace>();
+  thread->tid = static_cast<uint32_t>(syscall(SYS_gettid));
+  std::unique_lock<std::mutex> lock(mutex_);
+  thread->events.resize(events_per_thread_);
+  threads_.push_back(thread);
+  // the tracer keeps the events of a thread that exits
+  thread_trace_ = thread;
+  return thread.get();
+}
+
+/*
+ * record an event on the calling thread.
+ */
+void KernelTracer::Record(const char *name, const TraceLaunch &launch,
+                          uint64_t begin_ns, uint64_t end_ns) {
+  if (!Enabled()) {
+    return;
+  }
+  ThreadTrace *thread = GetThreadTrace();
+  std::unique_lock<std::mutex> lock(thread->mutex);
+  TraceEvent &event = thread->events[thread->next % thread->events.size()];
+  event.name = name;
+  event.begin_ns = begin_ns;
+  event.end_ns = end_ns;
+  event.launch = launch;
+  thread->next++;
+}
+
+/*
+ * dump the events of all threads.
+ */
+std::string KernelTracer::Dump() const {
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  char buf[384];
+  int pid = static_cast<int>(getpid());
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const auto &thread : threads_) {
+    std::unique_lock<std::mutex> thread_lock(thread->mutex);
+    uint64_t size = thread->events.size();
+    uint64_t begin = thread->next > size ? thread->next - size : 0;
+    for (uint64_t i = begin; i < thread->next; ++i) {
+      const TraceEvent &event = thread->events[i % size];
+      // ts and dur are microseconds, keep the nanoseconds as decimals
+      int len = snprintf(
+          buf, sizeof(buf),
+          "%s{\"name\":\"%s\",\"cat\":\"aicpu\",\"ph\":\"X\",\"ts\":%llu.%03llu,"
+          "\"dur\":%llu.%03llu,\"pid\":%d,\"tid\":%u,\"args\":{\"op_type\":"
+          "\"%s\",\"stream_id\":%u,\"task_id\":%llu}}",
+          first ? "" : ",", event.name,
+          static_cast<unsigned long long>(event.begin_ns / 1000),
+          static_cast<unsigned long long>(event.begin_ns % 1000),
+          static_cast<unsigned long long>((event.end_ns - event.begin_ns) / 1000),
+          static_cast<unsigned long long>((event.end_ns - event.begin_ns) % 1000),
+          pid, thread->tid, event.launch.op_type, event.launch.stream_id,
+          static_cast<unsigned long long>(event.launch.task_id));
+      if (len > 0) {
+        out.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+        first = false;
+      }
+    }
+  }
+  out.append("]}\n");
+  return out;
+}
+
+/*
+ * write Dump to a file.
+ */
+bool KernelTracer::WriteTrace(const std::string &path) const {
+  std::string content = Dump();
+  FILE *file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    KERNEL_LOG_WARN("Open kernel trace file[%s] failed, error[%s].",
+                    path.c_str(), strerror(errno));
+    return false;
+  }
+  bool written = fwrite(content.data(), 1, content.size(), file) == content.size();
+  if (!((fclose(file) == 0) && written)) {
+    KERNEL_LOG_WARN("Write kernel trace file[%s] failed, error[%s].",
+                    path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+uint64_t KernelTracer::NowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+TraceLaunch &KernelTracer::CurrentLaunch() { return g_launch; }
+
+TraceLaunchScope::TraceLaunchScope() {
+  if (!KernelTracer::Instance().Enabled()) {
+    return;
+  }
+  active_ = true;
+  saved_ = g_launch;
+  g_launch = TraceLaunch();
+  if (aicpu::GetTaskAndStreamId != nullptr) {
+    (void)aicpu::GetTaskAndStreamId(g_launch.task_id, g_launch.stream_id);
+  }
+}
+
+TraceLaunchScope::TraceLaunchScope(const TraceLaunch *launch) {
+  // the thread that started the launch runs some of its shards as well
+  if ((launch == nullptr) || (launch == &g_launch)) {
+    return;
+  }
+  active_ = true;
+  saved_ = g_launch;
+  g_launch = *launch;
+}
+
+TraceLaunchScope::~TraceLaunchScope() {
+  if (active_) {
+    g_launch = saved_;
+  }
+}
+}  // namespace aicpu
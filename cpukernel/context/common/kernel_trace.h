@@ -0,0 +1,178 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_KERNEL_TRACE_H_
+#define AICPU_CONTEXT_COMMON_KERNEL_TRACE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aicpu {
+/*
+ * The launch an event belongs to.
+ */
+struct TraceLaunch {
+  static const uint32_t kOpTypeLen = 32;
+  uint64_t task_id = 0;
+  uint32_t stream_id = 0;
+  char op_type[kOpTypeLen] = {0};  // truncated, always terminated
+
+  void SetOpType(const std::string &type);
+};
+
+/*
+ * One span on the timeline.
+ */
+struct TraceEvent {
+  const char *name = nullptr;  // string literal
+  uint64_t begin_ns = 0;
+  uint64_t end_ns = 0;
+  TraceLaunch launch;
+};
+
+/*
+ * Timeline of kernel launches, written as Chrome trace json for
+ * chrome://tracing or Perfetto. Set by the environment:
+ *   AICPU_KERNEL_TRACE_FILE: turns tracing on, the trace is written there
+ *   when the process exits
+ *   AICPU_KERNEL_TRACE_EVENTS: events kept per thread, 16384 by default
+ * Every thread records into a ring buffer of its own, a full one overwrites
+ * its oldest events.
+ */
+class KernelTracer {
+ public:
+  /*
+   * get instance.
+   * @return KernelTracer &: tracer of the process
+   */
+  static KernelTracer &Instance();
+
+  ~KernelTracer();
+
+  /*
+   * @return bool: whether events are recorded
+   */
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /*
+   * drop all events and start recording.
+   * @param events_per_thread: ring buffer size of every thread
+   */
+  void Enable(uint32_t events_per_thread);
+
+  /*
+   * stop recording, the events recorded are kept.
+   */
+  void Disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+  /*
+   * record an event on the calling thread.
+   * @param name: string literal naming the span
+   * @param launch: launch of the span
+   * @param begin_ns: start, from NowNs
+   * @param end_ns: end, from NowNs
+   */
+  void Record(const char *name, const TraceLaunch &launch, uint64_t begin_ns,
+              uint64_t end_ns);
+
+  /*
+   * dump the events of all threads.
+   * @return std::string: Chrome trace json object
+   */
+  std::string Dump() const;
+
+  /*
+   * write Dump to a file.
+   * @param path: file path
+   * @return bool: whether the file was written
+   */
+  bool WriteTrace(const std::string &path) const;
+
+  /*
+   * @return uint64_t: steady clock in nanoseconds
+   */
+  static uint64_t NowNs();
+
+  /*
+   * get the launch the calling thread works for.
+   * @return TraceLaunch &: launch of the thread
+   */
+  static TraceLaunch &CurrentLaunch();
+
+ private:
+  KernelTracer();
+  KernelTracer(const KernelTracer &) = delete;
+  KernelTracer &operator=(const KernelTracer &) = delete;
+
+  struct ThreadTrace;
+  ThreadTrace *GetThreadTrace();
+
+  std::atomic<bool> enabled_;
+  uint32_t events_per_thread_;
+  std::string path_;  // written at exit, empty for none
+  mutable std::mutex mutex_;  // protects threads_ and events_per_thread_
+  std::vector<std::shared_ptr<ThreadTrace>> threads_;
+  static thread_local std::shared_ptr<ThreadTrace> thread_trace_;
+};
+
+/*
+ * Marks a new launch on the calling thread while it lives, with the task and
+ * stream id of the runtime. Or, given the launch of another thread, makes
+ * the shards of that launch run here belong to it.
+ */
+class TraceLaunchScope {
+ public:
+  TraceLaunchScope();
+  explicit TraceLaunchScope(const TraceLaunch *launch);
+  ~TraceLaunchScope();
+
+ private:
+  TraceLaunchScope(const TraceLaunchScope &) = delete;
+  TraceLaunchScope &operator=(const TraceLaunchScope &) = delete;
+
+  bool active_ = false;
+  TraceLaunch saved_;
+};
+
+/*
+ * Records a span of the current launch from construction to destruction.
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(const char *name)
+      : name_(name),
+        begin_ns_(KernelTracer::Instance().Enabled() ? KernelTracer::NowNs()
+                                                     : 0) {}
+  ~TraceScope() {
+    if (begin_ns_ != 0) {
+      KernelTracer::Instance().Record(name_, KernelTracer::CurrentLaunch(),
+                                      begin_ns_, KernelTracer::NowNs());
+    }
+  }
+
+ private:
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+  const char *name_;
+  uint64_t begin_ns_;
+};
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_KERNEL_TRACE_H_
@@ -16,10 +16,10 @@
 #ifndef AICPU_CONTEXT_COMMON_SESSION_CACHE_H_
 #define AICPU_CONTEXT_COMMON_SESSION_CACHE_H_
 
-#include <map>
 #include <mutex>
 
 #include "kernel_cache.h"
+#include "sharded_cache.h"
 
 namespace aicpu {
 template <class C>
@@ -42,22 +42,20 @@ class SessionCache {
   template <class T>
   int32_t RunKernel(void *param, uint64_t session_id, uint64_t stream_id,
                     bool sess_flag) {
-    std::shared_ptr<KernelCache<C>> kernel = nullptr;
+    std::shared_ptr<KernelCache<C>> kernel;
     if (sess_flag) {
       KERNEL_LOG_DEBUG("SessionCache KernelCache from session, id[%llu].",
                        session_id);
-      std::unique_lock<std::mutex> lock(session_mutex_);
-      int32_t ret = GetOrCreateKernelCache<T>(session_kernel_cache_, session_id,
-                                              sess_flag, kernel);
+      int32_t ret = GetOrCreateKernelCache<T>(
+          session_kernel_cache_, session_mutex_, session_id, sess_flag, kernel);
       if (ret != 0) {
         return ret;
       }
     } else {
       KERNEL_LOG_DEBUG("SessionCache KernelCache from stream, id[%llu].",
                        stream_id);
-      std::unique_lock<std::mutex> lock(stream_mutex_);
-      int32_t ret = GetOrCreateKernelCache<T>(stream_kernel_cache_, stream_id,
-                                              sess_flag, kernel);
+      int32_t ret = GetOrCreateKernelCache<T>(
+          stream_kernel_cache_, stream_mutex_, stream_id, sess_flag, kernel);
       if (ret != 0) {
         return ret;
       }
@@ -73,38 +71,46 @@ class SessionCache {
   SessionCache &operator=(const SessionCache &) = delete;
   SessionCache &operator=(SessionCache &&) = delete;
 
+  /*
+   * lookup takes no lock, only the first launch of an id creates its cache
+   * under create_mutex. Kernel caches are never evicted.
+   */
   template <class T>
-  int32_t GetOrCreateKernelCache(
-      std::map<uint64_t, std::shared_ptr<KernelCache<C>>> &kernel_map,
-      uint64_t id, bool sess_flag, std::shared_ptr<KernelCache<C>> &kernel) {
-    auto iter = kernel_map.find(id);
-    if (iter != kernel_map.end()) {
+  int32_t GetOrCreateKernelCache(ShardedCache<KernelCache<C>> &kernel_map,
+                                 std::mutex &create_mutex, uint64_t id,
+                                 bool sess_flag,
+                                 std::shared_ptr<KernelCache<C>> &kernel) {
+    kernel = kernel_map.Get(id);
+    if (kernel != nullptr) {
       KERNEL_LOG_DEBUG("Get kernel from cache success, id[%llu].", id);
-      kernel = iter->second;
-    } else {
-      KernelCache<C> *cache = new (std::nothrow) T();
-      if (cache == nullptr) {
-        KERNEL_LOG_DEBUG("Create kernel cache failed, id[%llu].", id);
-        return -1;
-      }
-      kernel = std::shared_ptr<KernelCache<C>>(cache);
-      int32_t ret = kernel->Init(sess_flag);
-      if (ret != 0) {
-        return ret;
-      }
-      kernel_map.insert(std::make_pair(id, kernel));
-      KERNEL_LOG_DEBUG("Create kernel cache, id[%llu].", id);
+      return 0;
+    }
+    std::unique_lock<std::mutex> lock(create_mutex);
+    kernel = kernel_map.Get(id);
+    if (kernel != nullptr) {
+      return 0;
+    }
+    KernelCache<C> *cache = new (std::nothrow) T();
+    if (cache == nullptr) {
+      KERNEL_LOG_DEBUG("Create kernel cache failed, id[%llu].", id);
+      return -1;
+    }
+    std::shared_ptr<KernelCache<C>> kernel_shared(cache);
+    int32_t ret = kernel_shared->Init(sess_flag);
+    if (ret != 0) {
+      return ret;
     }
+    kernel_map.Set(id, kernel_shared);
+    kernel = kernel_shared;
+    KERNEL_LOG_DEBUG("Create kernel cache, id[%llu].", id);
     return 0;
   }
 
  private:
-  std::mutex stream_mutex_;
-  std::map<uint64_t, std::shared_ptr<KernelCache<C>>>
-      stream_kernel_cache_;  // key is stream id
-  std::mutex session_mutex_;
-  std::map<uint64_t, std::shared_ptr<KernelCache<C>>>
-      session_kernel_cache_;  // key is session id
+  std::mutex stream_mutex_;  // serializes creation only
+  ShardedCache<KernelCache<C>> stream_kernel_cache_;  // key is stream id
+  std::mutex session_mutex_;  // serializes creation only
+  ShardedCache<KernelCache<C>> session_kernel_cache_;  // key is session id
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_COMMON_SESSION_CACHE_H_
@@ -0,0 +1,263 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_SHARDED_CACHE_H_
+#define AICPU_CONTEXT_COMMON_SHARDED_CACHE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aicpu {
+/*
+ * Concurrent cache from a 64-bit id to a shared object, sharded by id.
+ * Every shard publishes a table of kWayNum-way sets whose slots are read and
+ * written atomically, so Get takes no shard lock. Set locks its own shard
+ * only. With a capacity a full set evicts by CLOCK, an approximate LRU;
+ * without one the shard table grows. A shard allocates its table on its
+ * first Set, an unused cache costs nothing.
+ */
+template <class T>
+class ShardedCache {
+ public:
+  ShardedCache() : capacity_(0), set_num_(1) {
+    for (uint32_t i = 0; i < kShardNum; ++i) {
+      tables_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+  ~ShardedCache() = default;
+
+  /*
+   * drop every entry and size the tables for capacity, not thread safe.
+   * @param capacity: entries kept before evicting, 0 means never evict
+   */
+  void Init(uint32_t capacity) {
+    capacity_ = capacity;
+    set_num_ = 1;
+    // twice the slots, so a set rarely fills up long before the capacity
+    while (capacity != 0 && set_num_ * kShardNum * kWayNum < capacity * 2) {
+      set_num_ *= 2;
+    }
+    for (uint32_t i = 0; i < kShardNum; ++i) {
+      tables_[i].store(nullptr, std::memory_order_release);
+      shards_[i].tables.clear();
+    }
+  }
+
+  /*
+   * look up without taking the shard lock.
+   * @param key: id
+   * @return std::shared_ptr<T>: cached object, nullptr if absent. The caller
+   * shares its ownership, eviction or replacement does not free it.
+   */
+  std::shared_ptr<T> Get(uint64_t key) {
+    uint64_t hash = Mix(key);
+    Table *table = tables_[hash % kShardNum].load(std::memory_order_acquire);
+    if (table == nullptr) {
+      return nullptr;
+    }
+    Slot *set = table->Set(hash);
+    for (uint32_t way = 0; way < kWayNum; ++way) {
+      Slot &slot = set[way];
+      if (slot.key.load(std::memory_order_acquire) != key) {
+        continue;
+      }
+      std::shared_ptr<T> value = std::atomic_load(&slot.value);
+      // a writer reusing the slot clears value before it changes key
+      if (value == nullptr ||
+          slot.key.load(std::memory_order_acquire) != key) {
+        continue;
+      }
+      if (!slot.referenced.load(std::memory_order_relaxed)) {
+        slot.referenced.store(true, std::memory_order_relaxed);
+      }
+      return value;
+    }
+    return nullptr;
+  }
+
+  /*
+   * insert or replace, a nullptr value is ignored.
+   * @param key: id
+   * @param value: object to cache
+   */
+  void Set(uint64_t key, std::shared_ptr<T> value) {
+    if (value == nullptr) {
+      return;
+    }
+    uint64_t hash = Mix(key);
+    uint32_t shard_index = hash % kShardNum;
+    Shard &shard = shards_[shard_index];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    if (shard.tables.empty()) {
+      shard.tables.emplace_back(new Table(set_num_));
+      tables_[shard_index].store(shard.tables.back().get(),
+                                 std::memory_order_release);
+    }
+    Table *table = shard.tables.back().get();
+    while (true) {
+      uint32_t first = table->SetIndex(hash) * kWayNum;
+      int64_t target = -1;
+      for (uint32_t way = 0; way < kWayNum; ++way) {
+        uint32_t pos = first + way;
+        if (table->slots[pos].value != nullptr &&
+            table->slots[pos].key.load(std::memory_order_relaxed) == key) {
+          target = pos;
+          break;
+        }
+        if (target < 0 && table->slots[pos].value == nullptr) {
+          target = pos;
+        }
+      }
+      if (target < 0 && capacity_ != 0) {
+        target = first + Evict(*table, table->SetIndex(hash));
+      }
+      if (target >= 0) {
+        Store(*table, target, key, std::move(value));
+        return;
+      }
+      table = Grow(shard_index);
+    }
+  }
+
+  /*
+   * get all entries, in no particular order.
+   * @return std::list<std::pair<uint64_t, std::shared_ptr<T>>>: pair<id, object>
+   */
+  std::list<std::pair<uint64_t, std::shared_ptr<T>>> GetAll() {
+    std::list<std::pair<uint64_t, std::shared_ptr<T>>> all;
+    for (uint32_t i = 0; i < kShardNum; ++i) {
+      std::unique_lock<std::mutex> lock(shards_[i].mutex);
+      if (shards_[i].tables.empty()) {
+        continue;
+      }
+      Table *table = shards_[i].tables.back().get();
+      for (uint32_t pos = 0; pos < table->slot_num; ++pos) {
+        if (table->slots[pos].value != nullptr) {
+          all.emplace_back(table->slots[pos].key.load(std::memory_order_relaxed),
+                           table->slots[pos].value);
+        }
+      }
+    }
+    return all;
+  }
+
+ private:
+  ShardedCache(const ShardedCache &) = delete;
+  ShardedCache(ShardedCache &&) = delete;
+  ShardedCache &operator=(const ShardedCache &) = delete;
+  ShardedCache &operator=(ShardedCache &&) = delete;
+
+  static const uint32_t kShardNum = 16;
+  static const uint32_t kWayNum = 8;
+
+  // value is loaded with std::atomic_load and stored with std::atomic_store,
+  // writers holding the shard mutex may read it directly
+  struct Slot {
+    std::atomic<uint64_t> key{0};
+    std::shared_ptr<T> value;
+    std::atomic<bool> referenced{false};
+  };
+
+  struct Table {
+    explicit Table(uint32_t set_num)
+        : set_mask(set_num - 1),
+          slot_num(set_num * kWayNum),
+          slots(new Slot[set_num * kWayNum]),
+          hands(new uint32_t[set_num]()) {}
+    uint32_t SetIndex(uint64_t hash) const {
+      return static_cast<uint32_t>(hash >> 32) & set_mask;
+    }
+    Slot *Set(uint64_t hash) const { return &slots[SetIndex(hash) * kWayNum]; }
+
+    uint32_t set_mask;
+    uint32_t slot_num;
+    std::unique_ptr<Slot[]> slots;
+    std::unique_ptr<uint32_t[]> hands;  // CLOCK hand of each set, under the shard mutex
+  };
+
+  struct Shard {
+    std::mutex mutex;  // writers only
+    std::vector<std::unique_ptr<Table>> tables;  // current one last, outgrown ones may still be read
+  };
+
+  // splitmix64 finalizer, kernel ids are often small and sequential
+  static uint64_t Mix(uint64_t key) {
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+  }
+
+  // way of a full set to reuse, skipping the recently referenced ones once
+  uint32_t Evict(Table &table, uint32_t set_index) {
+    Slot *set = &table.slots[set_index * kWayNum];
+    uint32_t &hand = table.hands[set_index];
+    while (set[hand].referenced.exchange(false, std::memory_order_relaxed)) {
+      hand = (hand + 1) % kWayNum;
+    }
+    uint32_t way = hand;
+    hand = (hand + 1) % kWayNum;
+    return way;
+  }
+
+  void Store(Table &table, uint32_t pos, uint64_t key,
+             std::shared_ptr<T> value) {
+    Slot &slot = table.slots[pos];
+    bool same_key = slot.value != nullptr &&
+                    slot.key.load(std::memory_order_relaxed) == key;
+    if (!same_key) {
+      // a new entry earns its reference bit on its first hit
+      std::atomic_store(&slot.value, std::shared_ptr<T>());
+      slot.key.store(key, std::memory_order_release);
+      slot.referenced.store(false, std::memory_order_relaxed);
+    }
+    std::atomic_store(&slot.value, std::move(value));
+  }
+
+  // double the sets of a shard. The old table stays readable until Init and
+  // keeps sharing its objects until then
+  Table *Grow(uint32_t shard_index) {
+    Shard &shard = shards_[shard_index];
+    Table *old_table = shard.tables.back().get();
+    Table *table = new Table((old_table->set_mask + 1) * 2);
+    for (uint32_t pos = 0; pos < old_table->slot_num; ++pos) {
+      if (old_table->slots[pos].value == nullptr) {
+        continue;
+      }
+      uint64_t key = old_table->slots[pos].key.load(std::memory_order_relaxed);
+      uint32_t first = table->SetIndex(Mix(key)) * kWayNum;
+      uint32_t way = 0;
+      // a set splits in two, it always fits
+      while (table->slots[first + way].value != nullptr) {
+        ++way;
+      }
+      Store(*table, first + way, key, old_table->slots[pos].value);
+    }
+    shard.tables.emplace_back(table);
+    tables_[shard_index].store(table, std::memory_order_release);
+    return table;
+  }
+
+  uint32_t capacity_;
+  uint32_t set_num_;  // sets of a new shard table
+  std::atomic<Table *> tables_[kShardNum];  // read by Get, changes only on growth
+  Shard shards_[kShardNum];
+};
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_SHARDED_CACHE_H_
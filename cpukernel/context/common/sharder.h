@@ -17,9 +17,33 @@
 #define AICPU_CONTEXT_COMMON_SHARDER_H_
 #include <functional>
 
+#include "cpu_kernel_utils.h"
 #include "cpu_types.h"
 
 namespace aicpu {
+// cycles a shard should take at least, a shorter one does not pay for
+// handing it to another thread
+constexpr double kMinShardCycles = 20000;
+// cycles charged per byte loaded or stored
+constexpr double kCyclesPerByte = 0.25;
+
+/*
+ * expected cycles of one unit of work.
+ */
+inline double UnitCycles(const ParallelForCost &cost) {
+  double cycles = cost.compute_cycles +
+                  (cost.bytes_loaded + cost.bytes_stored) * kCyclesPerByte;
+  return cycles > 1.0 ? cycles : 1.0;
+}
+
+/*
+ * units of work a shard of kMinShardCycles holds.
+ */
+inline int64_t CostToUnitSize(const ParallelForCost &cost) {
+  double units = kMinShardCycles / UnitCycles(cost);
+  return units > 1.0 ? static_cast<int64_t>(units + 0.5) : 1;
+}
+
 class Sharder {
  public:
   explicit Sharder(DeviceType device) : device_(device) {}
@@ -36,12 +60,33 @@ class Sharder {
       int64_t total, int64_t perUnitSize,
       const std::function<void(int64_t, int64_t)> &work) const = 0;
 
+  /*
+   * ParallelFor shards the "total" units of work by their expected cost.
+   * A sharder without a cost model gets shards of kMinShardCycles.
+   * @param total: size of total work
+   * @param cost: expected cost of per unit work
+   * @param work: process of per unit work
+   */
+  virtual void ParallelFor(
+      int64_t total, const ParallelForCost &cost,
+      const std::function<void(int64_t, int64_t)> &work) const {
+    ParallelFor(total, CostToUnitSize(cost), work);
+  }
+
   /*
    * Get CPU number
    * @return CPU number
    */
   virtual uint32_t GetCPUNum() const = 0;
 
+  /*
+   * whether a shard may start a parallel for of its own on this sharder.
+   * Otherwise such a nested parallel for runs inline on the shard's thread,
+   * as its threads may all be busy with the outer one.
+   * @return bool: true->nested parallel fors are sharded too
+   */
+  virtual bool SupportNested() const { return false; }
+
  private:
   Sharder(const Sharder &) = delete;
   Sharder(Sharder &&) = delete;
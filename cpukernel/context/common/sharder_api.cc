@@ -0,0 +1,64 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sharder_api.h"
+
+#include <dlfcn.h>
+#include "log.h"
+
+namespace {
+const char *kSharderPath = "/usr/lib64/libaicpu_sharder.so";
+const char *kParallelForFunc = "ParallelFor";
+const char *kGetCPUNumFunc = "GetCPUNum";
+const char *kNotifyWaitFunc = "AicpuNotifyWait";
+const char *kRegEventCbFunc = "AicpuRegEventCb";
+
+template <typename Func>
+Func LoadFunc(void *sharder, const char *name) {
+  Func func = reinterpret_cast<Func>(dlsym(sharder, name));
+  if (func == nullptr) {
+    KERNEL_LOG_WARN("Get function[%s] address failed, error[%s]", name,
+                    dlerror());
+  }
+  return func;
+}
+
+aicpu::SharderApi LoadSharderApi() {
+  aicpu::SharderApi api;
+  void *sharder = dlopen(kSharderPath, RTLD_LAZY | RTLD_GLOBAL);
+  if (sharder == nullptr) {
+    KERNEL_LOG_WARN("Device sharder dlopen so[%s] failed, error[%s]",
+                    kSharderPath, dlerror());
+    return api;
+  }
+  api.parallel_for = LoadFunc<aicpu::ParallelForFunc>(sharder, kParallelForFunc);
+  api.get_cpu_num = LoadFunc<aicpu::GetCPUNumFunc>(sharder, kGetCPUNumFunc);
+  api.notify_wait = LoadFunc<aicpu::NotifyWaitFunc>(sharder, kNotifyWaitFunc);
+  api.reg_event_cb = LoadFunc<aicpu::RegEventCbFunc>(sharder, kRegEventCbFunc);
+  KERNEL_LOG_INFO("Device sharder dlopen so[%s] success", kSharderPath);
+  return api;
+}
+}  // namespace
+
+namespace aicpu {
+/*
+ * get the sharder functions of the process.
+ */
+const SharderApi &GetSharderApi() {
+  // initialization of a local static runs once, concurrent callers wait for it
+  static const SharderApi api = LoadSharderApi();
+  return api;
+}
+}  // namespace aicpu
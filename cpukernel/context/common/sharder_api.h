@@ -0,0 +1,50 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_SHARDER_API_H_
+#define AICPU_CONTEXT_COMMON_SHARDER_API_H_
+
+#include <stdint.h>
+
+#include <functional>
+
+namespace aicpu {
+typedef void (*ParallelForFunc)(
+    int64_t total, int64_t perUnitSize,
+    const std::function<void(int64_t, int64_t)> &work);
+typedef uint32_t (*GetCPUNumFunc)();
+typedef void (*NotifyWaitFunc)(void *notify_param, const uint32_t param_len);
+typedef bool (*RegEventCbFunc)(const uint32_t event_id,
+  const uint32_t sub_event_id, const std::function<void(void *)> &cb);
+
+/*
+ * functions exported by libaicpu_sharder.so. A function the so does not
+ * export, or every function if the so can not be loaded, is nullptr.
+ */
+struct SharderApi {
+  ParallelForFunc parallel_for = nullptr;
+  GetCPUNumFunc get_cpu_num = nullptr;
+  NotifyWaitFunc notify_wait = nullptr;
+  RegEventCbFunc reg_event_cb = nullptr;
+};
+
+/*
+ * get the sharder functions of the process. The so is loaded and resolved
+ * by the first caller only, it is never unloaded.
+ * @return const SharderApi &: function table shared by all contexts
+ */
+const SharderApi &GetSharderApi();
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_SHARDER_API_H_
@@ -0,0 +1,298 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "work_stealing_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "host_thread_config.h"
+#include "log.h"
+
+namespace {
+// blocks per thread of a parallel for, more balance the load better
+const int64_t kBlocksPerThread = 4;
+// a range of blocks is packed as begin:24 | end:24 | tag:16 in one word
+const uint32_t kIndexBits = 24;
+const uint32_t kIndexMask = (1u << kIndexBits) - 1;
+const int64_t kMaxBlockNum = kIndexMask;
+// yields of a caller waiting for the last pool threads before it sleeps
+const uint32_t kWaitSpinNum = 64;
+
+uint64_t PackRange(uint32_t begin, uint32_t end, uint32_t tag) {
+  return (static_cast<uint64_t>(tag & 0xffff) << (2 * kIndexBits)) |
+         (static_cast<uint64_t>(end) << kIndexBits) | begin;
+}
+
+uint32_t RangeBegin(uint64_t range) { return range & kIndexMask; }
+
+uint32_t RangeEnd(uint64_t range) { return (range >> kIndexBits) & kIndexMask; }
+
+uint32_t RangeTag(uint64_t range) {
+  return static_cast<uint32_t>(range >> (2 * kIndexBits));
+}
+
+/*
+ * take the first block of a range.
+ */
+bool PopBlock(std::atomic<uint64_t> &range, uint32_t &block) {
+  uint64_t value = range.load(std::memory_order_acquire);
+  while (RangeBegin(value) < RangeEnd(value)) {
+    uint64_t next = PackRange(RangeBegin(value) + 1, RangeEnd(value),
+                              RangeTag(value));
+    if (range.compare_exchange_weak(value, next, std::memory_order_acq_rel)) {
+      block = RangeBegin(value);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * take the second half of a range, all of it if one block is left.
+ */
+bool StealHalf(std::atomic<uint64_t> &range, uint32_t &begin, uint32_t &end) {
+  uint64_t value = range.load(std::memory_order_acquire);
+  while (RangeBegin(value) < RangeEnd(value)) {
+    uint32_t mid = RangeBegin(value) + (RangeEnd(value) - RangeBegin(value)) / 2;
+    uint64_t next = PackRange(RangeBegin(value), mid, RangeTag(value));
+    if (range.compare_exchange_weak(value, next, std::memory_order_acq_rel)) {
+      begin = mid;
+      end = RangeEnd(value);
+      return true;
+    }
+  }
+  return false;
+}
+
+void PinThread(uint32_t cpu) {
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  CPU_SET(cpu, &mask);
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+  if (ret != 0) {
+    KERNEL_LOG_WARN("Bind pool thread to cpu[%u] failed, error[%s]", cpu,
+                    strerror(ret));
+  }
+}
+}  // namespace
+
+namespace aicpu {
+/*
+ * A parallel for in progress, it lives on the stack of its caller. Every
+ * thread taking part owns one slot of block ranges; a slot no thread took
+ * is emptied by the others.
+ */
+struct WorkStealingPool::Job {
+  Job(uint32_t slots, int64_t block_count)
+      : slot_num(slots), block_num(block_count), ranges(slots) {}
+
+  const std::function<void(int64_t, int64_t)> *work = nullptr;
+  int64_t total = 0;
+  int64_t block_size = 1;
+  uint32_t slot_num;
+  int64_t block_num;
+  std::vector<std::atomic<uint64_t>> ranges;
+  uint32_t next_slot = 1;  // slot 0 is the caller's, under the pool mutex
+  std::atomic<bool> exhausted{false};  // every range was found empty
+  std::mutex mutex;  // protects helpers
+  std::condition_variable done_cond;
+  uint32_t helpers = 0;  // pool threads inside the job
+};
+
+WorkStealingPool *WorkStealingPool::GetInstance() {
+  static WorkStealingPool pool(
+      GetHostThreadConfig().thread_num,
+      GetHostThreadConfig().pin_threads ? GetHostThreadConfig().cpus
+                                        : std::vector<uint32_t>());
+  return &pool;
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t thread_num,
+                                   const std::vector<uint32_t> &pin_cpus)
+    : thread_num_(std::max(thread_num, 1u)), pin_cpus_(pin_cpus) {
+  for (uint32_t i = 0; i + 1 < thread_num_; ++i) {
+    threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+  }
+  KERNEL_LOG_INFO("WorkStealingPool init success, thread number[%u], pinned[%d]",
+                  thread_num_, !pin_cpus_.empty());
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  job_cond_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+/*
+ * ParallelFor shards the "total" units of work.
+ */
+void WorkStealingPool::ParallelFor(
+    int64_t total, int64_t per_unit_size,
+    const std::function<void(int64_t, int64_t)> &work) {
+  if ((total <= 0) || (work == nullptr) || (per_unit_size <= 0)) {
+    KERNEL_LOG_ERROR(
+        "Invalid param: total[%lld] <= 0 or per_unit_size[%lld] <= 0 or work "
+        "is nullptr",
+        total, per_unit_size);
+    return;
+  }
+
+  if ((per_unit_size >= total) || (thread_num_ == 1)) {
+    work(0, total);
+    return;
+  }
+
+  // blocks of at least per_unit_size, and few enough per thread that
+  // handing them out costs little
+  int64_t thread_blocks = kBlocksPerThread * thread_num_;
+  int64_t block_size =
+      std::max(per_unit_size, (total + thread_blocks - 1) / thread_blocks);
+  block_size = std::max(block_size, (total + kMaxBlockNum - 1) / kMaxBlockNum);
+  RunBlocks(total, block_size, work);
+}
+
+void WorkStealingPool::RunBlocks(
+    int64_t total, int64_t block_size,
+    const std::function<void(int64_t, int64_t)> &work) {
+  int64_t block_num = (total + block_size - 1) / block_size;
+  if (block_num <= 1) {
+    work(0, total);
+    return;
+  }
+
+  uint32_t slot_num =
+      static_cast<uint32_t>(std::min<int64_t>(thread_num_, block_num));
+  Job job(slot_num, block_num);
+  job.work = &work;
+  job.total = total;
+  job.block_size = block_size;
+  for (uint32_t i = 0; i < slot_num; ++i) {
+    job.ranges[i].store(PackRange(block_num * i / slot_num,
+                                  block_num * (i + 1) / slot_num, 0),
+                        std::memory_order_relaxed);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+  }
+  for (uint32_t i = 1; i < slot_num; ++i) {
+    job_cond_.notify_one();
+  }
+
+  Participate(job, 0);
+
+  // no pool thread may join from now on, wait for those inside
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+  }
+  for (uint32_t i = 0; i < kWaitSpinNum; ++i) {
+    {
+      std::unique_lock<std::mutex> lock(job.mutex);
+      if (job.helpers == 0) {
+        return;
+      }
+    }
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(job.mutex);
+  job.done_cond.wait(lock, [&job]() { return job.helpers == 0; });
+}
+
+/*
+ * run the blocks of a slot, then steal from the others until all are taken.
+ */
+void WorkStealingPool::Participate(Job &job, uint32_t slot) {
+  std::atomic<uint64_t> &own = job.ranges[slot];
+  while (true) {
+    uint32_t block = 0;
+    while (PopBlock(own, block)) {
+      int64_t begin = block * job.block_size;
+      (*job.work)(begin, std::min(job.total, begin + job.block_size));
+    }
+
+    bool stolen = false;
+    for (uint32_t i = 1; (i < job.slot_num) && !stolen; ++i) {
+      uint32_t begin = 0;
+      uint32_t end = 0;
+      if (StealHalf(job.ranges[(slot + i) % job.slot_num], begin, end)) {
+        // the slot is empty, only its owner writes an empty slot. A new tag
+        // fails a thief that read the slot before it was emptied
+        uint64_t value = own.load(std::memory_order_relaxed);
+        own.store(PackRange(begin, end, RangeTag(value) + 1),
+                  std::memory_order_release);
+        stolen = true;
+      }
+    }
+    if (!stolen) {
+      break;
+    }
+  }
+  job.exhausted.store(true, std::memory_order_relaxed);
+}
+
+/*
+ * a job that can take one more pool thread, under the pool mutex.
+ */
+WorkStealingPool::Job *WorkStealingPool::FindJob() {
+  for (Job *job : jobs_) {
+    if ((job->next_slot < job->slot_num) &&
+        !job->exhausted.load(std::memory_order_relaxed)) {
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void WorkStealingPool::WorkerLoop(uint32_t index) {
+  if (!pin_cpus_.empty()) {
+    PinThread(pin_cpus_[index % pin_cpus_.size()]);
+  }
+  while (true) {
+    Job *job = nullptr;
+    uint32_t slot = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      job_cond_.wait(lock, [this, &job]() {
+        return stop_ || ((job = FindJob()) != nullptr);
+      });
+      if (stop_) {
+        return;
+      }
+      slot = job->next_slot++;
+      // the caller waits for helpers after removing the job, so the job
+      // outlives every helper counted here
+      std::unique_lock<std::mutex> job_lock(job->mutex);
+      job->helpers++;
+    }
+
+    Participate(*job, slot);
+
+    std::unique_lock<std::mutex> job_lock(job->mutex);
+    if (--job->helpers == 0) {
+      job->done_cond.notify_one();
+    }
+  }
+}
+}  // namespace aicpu
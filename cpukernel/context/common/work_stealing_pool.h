@@ -0,0 +1,91 @@
+/**
+ * Copyright 2020 Huawei Technologies Co., Ltd
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AICPU_CONTEXT_COMMON_WORK_STEALING_POOL_H_
+#define AICPU_CONTEXT_COMMON_WORK_STEALING_POOL_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aicpu {
+/*
+ * Thread pool for host ParallelFor. A parallel for is cut into blocks and
+ * every thread taking part starts on an even share of them; a thread that
+ * runs out steals half of the blocks another one has left. The caller takes
+ * part too, so a parallel for finishes even if no pool thread is free, and
+ * a thread of the pool may start one itself.
+ */
+class WorkStealingPool {
+ public:
+  /*
+   * get the pool of the process, sized and pinned by GetHostThreadConfig.
+   * @return WorkStealingPool *: pool, never null
+   */
+  static WorkStealingPool *GetInstance();
+
+  /*
+   * start thread_num - 1 threads, the caller of ParallelFor is the last one.
+   * @param thread_num: threads of a parallel for, at least 1
+   * @param pin_cpus: cpus to bind the threads to in turn, empty for none
+   */
+  WorkStealingPool(uint32_t thread_num, const std::vector<uint32_t> &pin_cpus);
+
+  ~WorkStealingPool();
+
+  /*
+   * ParallelFor shards the "total" units of work, returns when all are done.
+   * @param total: size of total work
+   * @param per_unit_size: least units of a block, total or more runs inline
+   * @param work: process of per unit work
+   */
+  void ParallelFor(int64_t total, int64_t per_unit_size,
+                   const std::function<void(int64_t, int64_t)> &work);
+
+  /*
+   * Get CPU number
+   * @return threads of a parallel for
+   */
+  uint32_t GetCPUNum() const { return thread_num_; }
+
+ private:
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool(WorkStealingPool &&) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(WorkStealingPool &&) = delete;
+
+  struct Job;
+
+  void RunBlocks(int64_t total, int64_t block_size,
+                 const std::function<void(int64_t, int64_t)> &work);
+  void Participate(Job &job, uint32_t slot);
+  Job *FindJob();
+  void WorkerLoop(uint32_t index);
+
+  uint32_t thread_num_;
+  std::vector<uint32_t> pin_cpus_;
+  std::mutex mutex_;  // protects jobs_ and stop_
+  std::condition_variable job_cond_;
+  std::vector<Job *> jobs_;  // parallel fors that may take one more thread
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+}  // namespace aicpu
+#endif  // AICPU_CONTEXT_COMMON_WORK_STEALING_POOL_H_
@@ -0,0 +1,92 @@
+# Builds this tree's context library as the static cpu_kernels_context_host, for
+# the host builds that run kernels without a device: the UTs and the host runner.
+# They use classes and CpuKernelUtils entries the prebuilt cpu_kernels_context of
+# the SDK does not have, so they link this one instead of it and put
+# CONTEXT_HOST_INCLUDE ahead of the SDK headers.
+#
+# PROJECT_PATH, ASCEND_CUSTOM_PATH and AICPU_OPP_ENV have to be set before the
+# include, the SDK libraries it links are found through the caller's link_directories.
+
+if (NOT TARGET protobuf_static_build)
+    include(${PROJECT_PATH}/third_party/protobuf_static.cmake)
+endif()
+if (NOT TARGET eigen_headers)
+    include(${PROJECT_PATH}/third_party/eigen.cmake)
+endif()
+
+set(CONTEXT_PATH ${PROJECT_PATH}/cpukernel/context)
+set(CONTEXT_HOST_PROTO_DIR ${CMAKE_CURRENT_BINARY_DIR}/context_host_proto)
+
+# generated with the protoc of the static protobuf, the sources include them as "proto/cpu_xxx.pb.h"
+set(_context_host_proto_files)
+set(_context_host_proto_srcs)
+set(_context_host_proto_hdrs)
+foreach(_proto cpu_attr cpu_node_def cpu_tensor cpu_tensor_shape)
+  list(APPEND _context_host_proto_files ${CONTEXT_PATH}/cpu_proto/proto/${_proto}.proto)
+  list(APPEND _context_host_proto_srcs ${CONTEXT_HOST_PROTO_DIR}/proto/${_proto}.pb.cc)
+  list(APPEND _context_host_proto_hdrs ${CONTEXT_HOST_PROTO_DIR}/proto/${_proto}.pb.h)
+endforeach()
+
+add_custom_command(
+  OUTPUT ${_context_host_proto_srcs} ${_context_host_proto_hdrs}
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${CONTEXT_HOST_PROTO_DIR}/proto
+  COMMAND ${PROTOBUF_STATIC_PKG_DIR}/bin/protoc -I${CONTEXT_PATH}/cpu_proto/proto
+          --cpp_out=${CONTEXT_HOST_PROTO_DIR}/proto ${_context_host_proto_files}
+  DEPENDS protobuf_static_build ${_context_host_proto_files}
+)
+
+# every context source plus the host stub of the sharder, the same files as
+# local_context_src_files in cpukernel/context/CMakeLists.txt and the node def builder
+file(GLOB _context_host_src_files
+  ${CONTEXT_PATH}/cpu_proto/*.cc
+  ${CONTEXT_PATH}/common/*.cc
+  ${CONTEXT_PATH}/common/*.cpp
+)
+list(APPEND _context_host_src_files
+  ${CONTEXT_PATH}/stub/aicpu_sharder.cc
+  ${_context_host_proto_srcs}
+)
+
+set(CONTEXT_HOST_INCLUDE
+  ${CONTEXT_PATH}
+  ${CONTEXT_PATH}/inc
+  ${CONTEXT_PATH}/common
+  ${CONTEXT_PATH}/cpu_proto
+  ${CONTEXT_PATH}/stub
+  ${CONTEXT_HOST_PROTO_DIR}
+  ${CONTEXT_HOST_PROTO_DIR}/proto
+  ${PROTOBUF_STATIC_PKG_DIR}/include
+  ${EIGEN_INCLUDE}
+)
+
+add_library(cpu_kernels_context_host STATIC
+  ${_context_host_src_files}
+)
+
+add_dependencies(cpu_kernels_context_host eigen_headers)
+
+target_include_directories(cpu_kernels_context_host PUBLIC
+  ${CONTEXT_HOST_INCLUDE}
+  ${AICPU_OPP_ENV}/inc
+  ${ASCEND_CUSTOM_PATH}/fwkacllib/include
+  ${ASCEND_CUSTOM_PATH}/fwkacllib/include/aicpu/common
+)
+
+target_compile_definitions(cpu_kernels_context_host PUBLIC
+  google=ascend_private
+  LOG_CPP
+)
+
+target_compile_options(cpu_kernels_context_host PRIVATE
+  -w
+  $<$<COMPILE_LANGUAGE:CXX>:-std=c++11>
+  -fPIC
+)
+
+# the runtime of the SDK, built from the same protobuf release as the protoc above
+target_link_libraries(cpu_kernels_context_host PUBLIC
+  ascend_protobuf
+  alog
+  pthread
+  -ldl
+)
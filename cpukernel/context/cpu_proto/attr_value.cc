@@ -17,7 +17,8 @@
 #include "cpu_attr_value.h"
 
 namespace aicpu {
-AttrValue::AttrValue(AttrValueImpl *impl) : impl_(impl) {}
+AttrValue::AttrValue(AttrValueImpl *impl)
+    : impl_(ShareArenaObject(impl, impl == nullptr ? nullptr : impl->GetArena())) {}
 
 /*
  * get string value of attr.
@@ -22,6 +22,7 @@
 
 #include "cpu_tensor.h"
 #include "cpu_tensor_shape.h"
+#include "kernel_arena.h"
 #include "proto/cpu_attr.pb.h"
 
 namespace aicpu {
@@ -32,9 +33,17 @@ class AttrValueImpl {
   AttrValueImpl(
       aicpuops::AttrValue *attr,
       std::function<void(aicpuops::AttrValue *)> del_func =
-          [](aicpuops::AttrValue *p) {})
+          [](aicpuops::AttrValue *) {})
       : attr_value_(attr, del_func) {}
 
+  /*
+   * wrap an attr proto, the wrapper and its control blocks live in arena.
+   */
+  AttrValueImpl(aicpuops::AttrValue *attr, KernelArena *arena)
+      : attr_value_(attr, [](aicpuops::AttrValue *) {},
+                    ArenaAllocator<aicpuops::AttrValue>(arena)),
+        arena_(arena) {}
+
   ~AttrValueImpl() = default;
   AttrValueImpl(const AttrValueImpl &) = delete;
   AttrValueImpl(AttrValueImpl &&) = delete;
@@ -302,8 +311,15 @@ class AttrValueImpl {
    */
   aicpuops::AttrValue *GetProto() const;
 
+  /*
+   * get arena holding the attr wrapper.
+   * @return KernelArena *: arena, nullptr->allocated by new
+   */
+  KernelArena *GetArena() const { return arena_; }
+
  private:
   std::shared_ptr<aicpuops::AttrValue> attr_value_{nullptr};
+  KernelArena *arena_{nullptr};
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_CPU_PROTO_ATTR_VALUE_IMPL_H_
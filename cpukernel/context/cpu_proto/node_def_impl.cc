@@ -57,13 +57,13 @@ void NodeDefImpl::SetOpType(const std::string &op) { nodedef_->set_op(op); }
 std::string NodeDefImpl::GetOpType() const { return nodedef_->op(); }
 
 /*
- * add input tensor to node def.
+ * wrap a tensor proto of the node def.
  */
-std::shared_ptr<Tensor> NodeDefImpl::AddInputs() {
-  auto tensor = nodedef_->add_inputs();
-  if (tensor == nullptr) {
-    KERNEL_LOG_ERROR("Protobuf node def add tensor is nullptr.");
-    return std::shared_ptr<Tensor>(nullptr);
+std::shared_ptr<Tensor> NodeDefImpl::CreateTensor(
+    aicpuops::Tensor *tensor) const {
+  if (arena_ != nullptr) {
+    return CpuKernelUtils::CreateTensor(
+        arena_->New<TensorImpl>(tensor, arena_.get()));
   }
 
   TensorImpl *impl = new (std::nothrow) TensorImpl(tensor);
@@ -80,26 +80,29 @@ std::shared_ptr<Tensor> NodeDefImpl::AddInputs() {
 }
 
 /*
- * add output tensor to node def.
+ * add input tensor to node def.
  */
-std::shared_ptr<Tensor> NodeDefImpl::AddOutputs() {
-  auto tensor = nodedef_->add_outputs();
+std::shared_ptr<Tensor> NodeDefImpl::AddInputs() {
+  auto tensor = nodedef_->add_inputs();
   if (tensor == nullptr) {
     KERNEL_LOG_ERROR("Protobuf node def add tensor is nullptr.");
     return std::shared_ptr<Tensor>(nullptr);
   }
 
-  TensorImpl *impl = new (std::nothrow) TensorImpl(tensor);
-  if (impl == nullptr) {
-    KERNEL_LOG_ERROR("Create TensorImpl failed.");
+  return CreateTensor(tensor);
+}
+
+/*
+ * add output tensor to node def.
+ */
+std::shared_ptr<Tensor> NodeDefImpl::AddOutputs() {
+  auto tensor = nodedef_->add_outputs();
+  if (tensor == nullptr) {
+    KERNEL_LOG_ERROR("Protobuf node def add tensor is nullptr.");
     return std::shared_ptr<Tensor>(nullptr);
   }
 
-  auto aicpu_tensor = CpuKernelUtils::CreateTensor(impl);
-  if (aicpu_tensor == nullptr) {
-    delete impl;
-  }
-  return aicpu_tensor;
+  return CreateTensor(tensor);
 }
 
 /*
@@ -153,17 +156,7 @@ std::shared_ptr<Tensor> NodeDefImpl::MutableInputs(int32_t index) const {
     return std::shared_ptr<Tensor>(nullptr);
   }
 
-  TensorImpl *impl = new (std::nothrow) TensorImpl(tensor);
-  if (impl == nullptr) {
-    KERNEL_LOG_ERROR("Create TensorImpl failed.");
-    return std::shared_ptr<Tensor>(nullptr);
-  }
-
-  auto aicpu_tensor = CpuKernelUtils::CreateTensor(impl);
-  if (aicpu_tensor == nullptr) {
-    delete impl;
-  }
-  return aicpu_tensor;
+  return CreateTensor(tensor);
 }
 
 /*
@@ -185,17 +178,7 @@ std::shared_ptr<Tensor> NodeDefImpl::MutableOutputs(int32_t index) const {
     return std::shared_ptr<Tensor>(nullptr);
   }
 
-  TensorImpl *impl = new (std::nothrow) TensorImpl(tensor);
-  if (impl == nullptr) {
-    KERNEL_LOG_ERROR("Create TensorImpl failed.");
-    return std::shared_ptr<Tensor>(nullptr);
-  }
-
-  auto aicpu_tensor = CpuKernelUtils::CreateTensor(impl);
-  if (aicpu_tensor == nullptr) {
-    delete impl;
-  }
-  return aicpu_tensor;
+  return CreateTensor(tensor);
 }
 
 /*
@@ -209,13 +192,16 @@ std::unordered_map<std::string, std::shared_ptr<AttrValue>> NodeDefImpl::Attrs()
 
   for (auto it = attrs_map->begin(); it != attrs_map->end(); ++it) {
     aicpuops::AttrValue *attr = &(it->second);
-    AttrValueImpl *impl = new (std::nothrow) AttrValueImpl(attr);
+    AttrValueImpl *impl =
+        (arena_ != nullptr)
+            ? arena_->New<AttrValueImpl>(attr, arena_.get())
+            : new (std::nothrow) AttrValueImpl(attr);
     if (impl == nullptr) {
       KERNEL_LOG_WARN("Create AttrValueImpl failed.");
     }
 
     auto attr_value = CpuKernelUtils::CreateAttrValue(impl);
-    if (attr_value == nullptr) {
+    if ((attr_value == nullptr) && (arena_ == nullptr)) {
       KERNEL_LOG_WARN("Create CreateAttrValue failed.");
       delete impl;
     }
@@ -22,6 +22,7 @@
 
 #include "cpu_attr_value.h"
 #include "cpu_tensor.h"
+#include "kernel_arena.h"
 #include "proto/cpu_node_def.pb.h"
 
 namespace aicpu {
@@ -32,9 +33,17 @@ class NodeDefImpl {
   NodeDefImpl(
       aicpuops::NodeDef *nodedef,
       std::function<void(aicpuops::NodeDef *)> del_func =
-          [](aicpuops::NodeDef *p) {})
+          [](aicpuops::NodeDef *) {})
       : nodedef_(nodedef, del_func) {}
 
+  /*
+   * wrap a node def proto created in arena, the arena is released with the
+   * wrapper. Tensors and attrs got from it are allocated from the arena too.
+   */
+  NodeDefImpl(aicpuops::NodeDef *nodedef, std::unique_ptr<KernelArena> arena)
+      : arena_(std::move(arena)),
+        nodedef_(nodedef, [](aicpuops::NodeDef *) {}) {}
+
   ~NodeDefImpl() = default;
   NodeDefImpl(const NodeDefImpl &) = delete;
   NodeDefImpl(NodeDefImpl &&) = delete;
@@ -119,6 +128,13 @@ class NodeDefImpl {
   std::unordered_map<std::string, std::shared_ptr<AttrValue> > Attrs() const;
 
  private:
+  /*
+   * wrap a tensor proto of the node def.
+   * @return shared_ptr<Tensor>: not null->success, null->failed
+   */
+  std::shared_ptr<Tensor> CreateTensor(aicpuops::Tensor *tensor) const;
+
+  std::unique_ptr<KernelArena> arena_{nullptr};  // released after nodedef_
   std::shared_ptr<aicpuops::NodeDef> nodedef_{nullptr};
 };
 }  // namespace aicpu
@@ -17,7 +17,8 @@
 #include "tensor_impl.h"
 
 namespace aicpu {
-Tensor::Tensor(TensorImpl *impl) : impl_(impl) {}
+Tensor::Tensor(TensorImpl *impl)
+    : impl_(ShareArenaObject(impl, impl == nullptr ? nullptr : impl->GetArena())) {}
 
 /*
  * get tensor shape value of tensor.
@@ -26,6 +26,15 @@ namespace aicpu {
  * get tensor shape value of tensor.
  */
 std::shared_ptr<TensorShape> TensorImpl::GetTensorShape() const {
+  // the shape proto is a field of the tensor proto, its address never changes
+  std::call_once(shape_once_, [this]() { shape_ = CreateTensorShape(); });
+  return shape_;
+}
+
+/*
+ * create a view of the tensor shape proto.
+ */
+std::shared_ptr<TensorShape> TensorImpl::CreateTensorShape() const {
   aicpuops::TensorShape *tensor_shape = tensor_->mutable_tensor_shape();
   if (tensor_shape == nullptr) {
     KERNEL_LOG_ERROR("Protobuf mutable tensor shape is null.");
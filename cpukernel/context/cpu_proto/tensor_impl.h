@@ -17,8 +17,10 @@
 #define AICPU_CONTEXT_CPU_PROTO_TENSOR_IMPL_H_
 #include <functional>
 #include <memory>
+#include <mutex>
 
 #include "cpu_tensor_shape.h"
+#include "kernel_arena.h"
 #include "proto/cpu_tensor.pb.h"
 
 namespace aicpu {
@@ -29,9 +31,17 @@ class TensorImpl {
   TensorImpl(
       aicpuops::Tensor *tensor,
       std::function<void(aicpuops::Tensor *)> delFunc =
-          [](aicpuops::Tensor *p) {})
+          [](aicpuops::Tensor *) {})
       : tensor_(tensor, delFunc) {}
 
+  /*
+   * wrap a tensor proto, the wrapper and its control blocks live in arena.
+   */
+  TensorImpl(aicpuops::Tensor *tensor, KernelArena *arena)
+      : tensor_(tensor, [](aicpuops::Tensor *) {},
+                ArenaAllocator<aicpuops::Tensor>(arena)),
+        arena_(arena) {}
+
   ~TensorImpl() = default;
   TensorImpl(const TensorImpl &) = delete;
   TensorImpl(TensorImpl &&) = delete;
@@ -46,7 +56,8 @@ class TensorImpl {
   bool SetTensorShape(const TensorShape *shape);
 
   /*
-   * get tensor shape value of tensor.
+   * get tensor shape value of tensor. The view is built on the first call
+   * and shared by later ones, it reflects every later change of the shape.
    * @return std::shared_ptr<TensorShape>: tensor shape value of tensor
    */
   std::shared_ptr<TensorShape> GetTensorShape() const;
@@ -116,8 +127,19 @@ class TensorImpl {
    */
   aicpuops::Tensor *GetProto() const;
 
+  /*
+   * get arena holding the tensor wrapper.
+   * @return KernelArena *: arena, nullptr->allocated by new
+   */
+  KernelArena *GetArena() const { return arena_; }
+
  private:
+  std::shared_ptr<TensorShape> CreateTensorShape() const;
+
   std::shared_ptr<aicpuops::Tensor> tensor_{nullptr};
+  KernelArena *arena_{nullptr};
+  mutable std::once_flag shape_once_;
+  mutable std::shared_ptr<TensorShape> shape_{nullptr};
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_CPU_PROTO_TENSOR_IMPL_H_
@@ -16,8 +16,12 @@
 #ifndef AICPU_CONTEXT_INC_REGISTAR_H_
 #define AICPU_CONTEXT_INC_REGISTAR_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "cpu_context.h"
 #include "cpu_kernel.h"
@@ -32,7 +36,8 @@ class AICPU_VISIBILITY CpuKernelRegister {
   static CpuKernelRegister &Instance();
 
   /*
-   * get cpu kernel.
+   * get cpu kernel, a new one from the creator of op type. The lookup takes
+   * no lock, launches of a cached context reuse the kernel it got.
    * param op_type: the op type of kernel
    * @return shared_ptr<CpuKernel>: cpu kernel ptr
    */
@@ -51,6 +56,16 @@ class AICPU_VISIBILITY CpuKernelRegister {
    */
   uint32_t RunCpuKernel(CpuKernelContext &ctx);
 
+  /*
+   * run cpu kernel got for the context before.
+   * param ctx: context of kernel
+   * param op_type: op type of ctx
+   * param kernel: kernel from GetCpuKernel(op_type)
+   * @return uint32_t: 0->success other->failed
+   */
+  uint32_t RunCpuKernel(CpuKernelContext &ctx, const std::string &op_type,
+                        const std::shared_ptr<CpuKernel> &kernel);
+
   /*
    * run async cpu kernel.
    * @param ctx: context of kernel
@@ -64,6 +79,21 @@ class AICPU_VISIBILITY CpuKernelRegister {
                              const uint32_t wait_id,
                              std::function<uint32_t()> cb);
 
+  /*
+   * run async cpu kernel got for the context before.
+   * @param ctx: context of kernel
+   * @param op_type: op type of ctx
+   * @param kernel: kernel from GetCpuKernel(op_type)
+   * @param wait_type : event wait type
+   * @param wait_id : event wait id
+   * @param cb : callback function
+   * @return uint32_t: 0->success other->failed
+   */
+  uint32_t RunCpuKernelAsync(CpuKernelContext &ctx, const std::string &op_type,
+                             const std::shared_ptr<CpuKernel> &kernel,
+                             const uint8_t wait_type, const uint32_t wait_id,
+                             std::function<uint32_t()> cb);
+
   // CpuKernel registration function to register different types of kernel to
   // the factory
   class Registerar {
@@ -90,7 +120,13 @@ class AICPU_VISIBILITY CpuKernelRegister {
   void Register(const std::string &type, const KERNEL_CREATOR_FUN &fun);
 
  private:
+  using CreatorTable = std::unordered_map<std::string, KERNEL_CREATOR_FUN>;
+
   std::map<std::string, KERNEL_CREATOR_FUN> creatorMap_;  // kernel map
+  // copy of creatorMap_ read without lock. A lookup missing it publishes a
+  // new one if kernels were registered since, the old ones stay for readers
+  std::atomic<const CreatorTable *> creators_{nullptr};
+  std::vector<std::unique_ptr<const CreatorTable>> creator_tables_;
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_INC_REGISTAR_H_
@@ -24,6 +24,23 @@
 #include "cpu_tensor.h"
 
 namespace aicpu {
+/*
+ * Expected cost of one unit of ParallelFor work, the sharder sizes its
+ * shards from it: bytes read, bytes written and other cpu cycles.
+ */
+struct ParallelForCost {
+  double bytes_loaded = 0;
+  double bytes_stored = 0;
+  double compute_cycles = 0;
+};
+
+/*
+ * Builds what a kernel derives from the attrs of a context, null means the
+ * attrs are invalid.
+ */
+using KernelStateCreator =
+    std::shared_ptr<const void> (*)(const CpuKernelContext &ctx);
+
 class AICPU_VISIBILITY CpuKernelUtils {
  public:
   /*
@@ -98,6 +115,14 @@ class AICPU_VISIBILITY CpuKernelUtils {
    */
   static std::shared_ptr<NodeDef> CreateNodeDef();
 
+  /*
+   * create node def whose proto and tensor and attr wrappers are allocated
+   * from one arena of the node def. Contexts initialized from it and the
+   * wrappers it returns must be released before it.
+   * @return std::shared_ptr<NodeDef>: node def ptr
+   */
+  static std::shared_ptr<NodeDef> CreateArenaNodeDef();
+
   /*
    * ParallelFor shards the "total" units of work.
    * @param ctx: context info of kernel
@@ -110,12 +135,62 @@ class AICPU_VISIBILITY CpuKernelUtils {
       const CpuKernelContext &ctx, int64_t total, int64_t per_unit_size,
       const std::function<void(int64_t, int64_t)> &work);
 
+  /*
+   * ParallelFor shards the "total" units of work by their expected cost.
+   * @param ctx: context info of kernel
+   * @param total: size of total work
+   * @param cost: expected cost of per unit work
+   * @param work: process of per unit work
+   * @return uint32_t: 0->sucess other->failed
+   */
+  static uint32_t ParallelFor(
+      const CpuKernelContext &ctx, int64_t total, const ParallelForCost &cost,
+      const std::function<void(int64_t, int64_t)> &work);
+
   /*
    * Get CPU number
    * @param ctx: context info of kernel
    * @return CPU number
    */
   static uint32_t GetCPUNum(const CpuKernelContext &ctx);
+
+  /*
+   * get attr without building a string of its name.
+   * @param ctx: context info of kernel
+   * @param name: attr name
+   * @return AttrValue *: not null->success, null->no such attr
+   */
+  static AttrValue *GetAttr(const CpuKernelContext &ctx, const char *name);
+
+  /*
+   * get the index of an attr by binary search over a snapshot taken in Init.
+   * The attrs of a context never change, a kernel may resolve the index once
+   * and read the attr by it afterwards in constant time.
+   * @param ctx: context info of kernel
+   * @param name: attr name
+   * @return int32_t: index, -1 if there is no such attr
+   */
+  static int32_t GetAttrIndex(const CpuKernelContext &ctx, const char *name);
+
+  /*
+   * get attr by index.
+   * @param ctx: context info of kernel
+   * @param index: index from GetAttrIndex
+   * @return AttrValue *: not null->success, null->index out of range
+   */
+  static AttrValue *GetAttrByIndex(const CpuKernelContext &ctx, int32_t index);
+
+  /*
+   * get the state of the kernel of a context. The first call for the context
+   * creates it, every later launch of the context shares it, concurrent
+   * launches wait for the creation. A context runs one kernel, so one
+   * creator per context.
+   * @param ctx: context info of kernel
+   * @param create: builds the state from the attrs of ctx
+   * @return const void *: state valid as long as ctx, null->create failed
+   */
+  static const void *GetKernelState(const CpuKernelContext &ctx,
+                                    KernelStateCreator create);
 };
 }  // namespace aicpu
 #endif  // AICPU_CONTEXT_INC_UTILS_H_
@@ -18,9 +18,15 @@ local_context_src_files := cpu_proto/proto/cpu_attr.proto \
                            common/cpu_kernel_register.cc \
                            common/cpu_kernel_utils.cc \
                            common/host_sharder.cc \
+                           common/host_thread_config.cc \
                            common/device_sharder.cc \
+                           common/sharder_api.cc \
                            common/eigen_threadpool.cc \
+                           common/work_stealing_pool.cc \
                            common/cpu_kernel_cache.cc \
+                           common/kernel_arena.cc \
+                           common/kernel_metrics.cc \
+                           common/kernel_trace.cc \
 
 local_context_stub_files := stub/aicpu_sharder.cc \
 
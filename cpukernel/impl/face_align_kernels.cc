@@ -4,9 +4,138 @@
  * Description: implement of FaceAlign
  */
 #include "face_align_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include "cpu_kernel_utils.h"
+#ifdef FACE_ALIGN_WITH_OPENCV
+#include "opencv2/opencv.hpp"
+using namespace cv;
+#endif
 #define FACE_KEYPOINT_NUM 5
 namespace  {
 const char *FACE_ALIGN = "FaceAlign";
+// cost hint: output pixels a shard should at least warp before it is worth
+// handing to another thread, so a few faces stay on the calling thread
+const int64_t kMinShardPixels = 112 * 112 * 4;
+const std::string kTransformSimilarity = "similarity";
+const std::string kTransformAffine = "affine";
+const std::string kTransformRansac = "ransac";
+const std::string kFormatNhwc = "NHWC";
+const std::string kFormatNchw = "NCHW";
+const std::string kInputBgr = "BGR888_U8";
+const std::string kInputNv12 = "YUV420SP_U8";
+const uint32_t kFaceChannels = 3;
+
+#ifdef FACE_ALIGN_WITH_OPENCV
+// crop sizes (width, height) warped by the hand-written kernel, others go to cv::warpAffine
+bool IsFastWarpSize(int64_t width, int64_t height)
+{
+    return (width == 112 && height == 112) || (width == 96 && height == 112);
+}
+#endif
+
+// attrs of a context, checked and turned into the template side of the solver
+// and the normalization tables of the output once per context, every launch of
+// the context only reads them
+struct FaceAlignAttrs {
+    std::vector<int64_t> face_size;
+    std::vector<int64_t> default_keypoint;
+    aicpu::FaceTransformSolver solver;
+    aicpu::FaceTransformSolver::TransformType solver_type = aicpu::FaceTransformSolver::SIMILARITY;
+    bool zero_unused = false;
+    bool nv12 = false;
+    aicpu::DataType output_dtype = aicpu::DT_UINT8;
+    aicpu::WarpDstFormat dst_format;
+};
+
+// string attr or its default when absent
+std::string GetStringAttr(const aicpu::CpuKernelContext &ctx, const char *name, const std::string &default_value)
+{
+    aicpu::AttrValue* attr = aicpu::CpuKernelUtils::GetAttr(ctx, name);
+    return attr == nullptr ? default_value : attr->GetString();
+}
+
+// output_dtype, output_format, mean and std turned into attrs.dst_format
+bool ParseDstFormat(const aicpu::CpuKernelContext &ctx, FaceAlignAttrs &attrs)
+{
+    aicpu::AttrValue* output_dtype_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "output_dtype");
+    if (output_dtype_attr != nullptr) {
+        attrs.output_dtype = output_dtype_attr->GetDataType();
+    }
+    aicpu::WarpDstType dst_type = aicpu::WARP_DST_U8;
+    if (attrs.output_dtype == aicpu::DT_FLOAT) {
+        dst_type = aicpu::WARP_DST_F32;
+    } else if (attrs.output_dtype == aicpu::DT_FLOAT16) {
+        dst_type = aicpu::WARP_DST_F16;
+    } else if (attrs.output_dtype != aicpu::DT_UINT8) {
+        return false;
+    }
+    std::string output_format = GetStringAttr(ctx, "output_format", kFormatNhwc);
+    if (output_format != kFormatNhwc && output_format != kFormatNchw) {
+        return false;
+    }
+    std::vector<float> mean(kFaceChannels, 0.0f);
+    std::vector<float> std(kFaceChannels, 1.0f);
+    aicpu::AttrValue* mean_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "mean");
+    if (mean_attr != nullptr) {
+        mean = mean_attr->GetListFloat();
+    }
+    aicpu::AttrValue* std_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "std");
+    if (std_attr != nullptr) {
+        std = std_attr->GetListFloat();
+    }
+    if (mean.size() != kFaceChannels || std.size() != kFaceChannels) {
+        return false;
+    }
+    return aicpu::InitWarpDstFormat(attrs.dst_format, dst_type, output_format == kFormatNchw,
+                                    mean.data(), std.data());
+}
+
+std::shared_ptr<const void> ParseFaceAlignAttrs(const aicpu::CpuKernelContext &ctx)
+{
+    aicpu::AttrValue* face_size_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "face_size");
+    aicpu::AttrValue* default_keypoint_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "default_keypoint");
+    if (face_size_attr == nullptr || default_keypoint_attr == nullptr) {
+        return nullptr;
+    }
+    FaceAlignAttrs *attrs_ptr = new (std::nothrow) FaceAlignAttrs();
+    if (attrs_ptr == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<FaceAlignAttrs> attrs(attrs_ptr);
+    attrs->face_size = face_size_attr->GetListInt();
+    if (attrs->face_size.size() != 2 || attrs->face_size[0] <= 0 || attrs->face_size[1] <= 0) {
+        return nullptr;
+    }
+    attrs->default_keypoint = default_keypoint_attr->GetListInt();
+    if (attrs->default_keypoint.size() != 10 ||
+        !attrs->solver.Init(attrs->default_keypoint, FACE_KEYPOINT_NUM)) {
+        return nullptr;
+    }
+    std::string transform_type = GetStringAttr(ctx, "transform_type", kTransformSimilarity);
+    if (transform_type == kTransformAffine) {
+        attrs->solver_type = aicpu::FaceTransformSolver::AFFINE;
+    } else if (transform_type == kTransformRansac) {
+        attrs->solver_type = aicpu::FaceTransformSolver::ROBUST_AFFINE;
+    } else if (transform_type != kTransformSimilarity) {
+        return nullptr;
+    }
+    aicpu::AttrValue* zero_unused_attr = aicpu::CpuKernelUtils::GetAttr(ctx, "zero_unused");
+    if (zero_unused_attr != nullptr) {
+        attrs->zero_unused = zero_unused_attr->GetBool();
+    }
+    std::string input_format = GetStringAttr(ctx, "input_format", kInputBgr);
+    attrs->nv12 = (input_format == kInputNv12);
+    if (!attrs->nv12 && input_format != kInputBgr) {
+        return nullptr;
+    }
+    if (!ParseDstFormat(ctx, *attrs)) {
+        return nullptr;
+    }
+    return attrs;
+}
 }
 
 namespace aicpu  {
@@ -24,29 +153,29 @@ uint32_t FaceAlignCpuKernel::Compute(CpuKernelContext &ctx)
     }
 
     Tensor *face_num_tensor = ctx.Input(2);
-    if (keypoint_tensor == nullptr) {
+    if (face_num_tensor == nullptr) {
         return 1;
     }
     //get attr
-    AttrValue* face_size_attr = ctx.GetAttr("face_size");
-    if ( face_size_attr == nullptr){
-        return 1;
-    }
-    std::vector<int64_t> face_size = face_size_attr->GetListInt();
-    if ( face_size.size() != 2){
+    const FaceAlignAttrs *attrs =
+        static_cast<const FaceAlignAttrs *>(CpuKernelUtils::GetKernelState(ctx, ParseFaceAlignAttrs));
+    if (attrs == nullptr) {
         return 1;
     }
-    AttrValue* default_keypoint_attr = ctx.GetAttr("default_keypoint");
-    if ( default_keypoint_attr == nullptr){
-        return 1;
-    }
-    std::vector<int64_t> default_keypoint = default_keypoint_attr->GetListInt();
-    if ( default_keypoint.size() != 10){
+    const std::vector<int64_t> &face_size = attrs->face_size;
+    FaceTransformSolver::TransformType solver_type = attrs->solver_type;
+    bool nv12 = attrs->nv12;
+    //get output ptr
+    Tensor *output_tensor = ctx.Output(0);
+    if (output_tensor == nullptr || output_tensor->GetData() == nullptr ||
+        output_tensor->GetDataType() != attrs->output_dtype) {
         return 1;
     }
-    //get output ptr
-    uint8_t* output_ptr = (uint8_t*)ctx.Output(0)->GetData();
-    if (output_ptr == nullptr) {
+    uint8_t* output_ptr = (uint8_t*)output_tensor->GetData();
+    //valid_num output: faces actually aligned, the slots past it are unused
+    Tensor *valid_num_tensor = ctx.Output(1);
+    if (valid_num_tensor == nullptr || valid_num_tensor->GetData() == nullptr ||
+        valid_num_tensor->GetDataSize() < sizeof(int32_t)) {
         return 1;
     }
     //get image shape
@@ -55,44 +184,127 @@ uint32_t FaceAlignCpuKernel::Compute(CpuKernelContext &ctx)
     if(image_shapes.size() < 4){
         return -1;
     }
+    //NV12 comes as [N, H * 3 / 2, W, 1], the Y plane then H / 2 rows of interleaved UV
+    if (nv12 && (image_shapes[3] != 1 || image_shapes[1] % 3 != 0 || image_shapes[2] % 2 != 0)) {
+        return 1;
+    }
+    if (!nv12 && image_shapes[3] != 3) {
+        return 1;
+    }
 
+    int64_t image_batch = image_shapes[0];
+    int32_t image_h = static_cast<int32_t>(nv12 ? image_shapes[1] / 3 * 2 : image_shapes[1]);
+    int32_t image_w = static_cast<int32_t>(image_shapes[2]);
+    int64_t image_bytes = image_shapes[1] * image_shapes[2] * image_shapes[3];
     //get image data
-    Mat img = Mat(image_shapes[1], image_shapes[2], CV_8UC3);
-    // Mat img = Mat(480, 480, CV_8UC3);
-    img.data = (uchar*)image_tensor->GetData();
+    uint8_t *image_data = (uint8_t*)image_tensor->GetData();
     //get keypoint data
     float* keypoint_data_ptr = (float*)keypoint_tensor->GetData();
     //get face number data
     int32_t face_num = *(int32_t*)face_num_tensor->GetData();
 
+    //face_num comes from device memory, never align past the keypoints or the output
+    int64_t face_pixels = face_size[0] * face_size[1];
+    const WarpDstFormat &dst_format = attrs->dst_format;
+    int64_t face_bytes = WarpDstBytes(dst_format, face_size[1], face_size[0]);
+    int64_t output_bytes = static_cast<int64_t>(output_tensor->GetDataSize());
+    int64_t face_capacity = std::min<int64_t>(keypoint_tensor->NumElements() / 10, output_bytes / face_bytes);
+    int64_t valid_num = std::max<int64_t>(0, std::min<int64_t>(face_num, face_capacity));
+
+    //optional box_index: image of the batch each face is cut from, image 0 when absent.
+    //checked before any output is written, a rejected launch leaves the outputs as they were
+    int32_t *box_index_ptr = nullptr;
+    Tensor *box_index_tensor = ctx.GetInputsSize() > 3 ? ctx.Input(3) : nullptr;
+    if (box_index_tensor != nullptr && box_index_tensor->GetData() != nullptr) {
+        if (box_index_tensor->NumElements() < valid_num) {
+            return 1;
+        }
+        box_index_ptr = (int32_t*)box_index_tensor->GetData();
+        for (int64_t i = 0; i < valid_num; i++) {
+            if (box_index_ptr[i] < 0 || box_index_ptr[i] >= image_batch) {
+                return 1;
+            }
+        }
+    }
+
+    if (attrs->zero_unused && output_bytes > valid_num * face_bytes) {
+        memset(output_ptr + valid_num * face_bytes, 0, output_bytes - valid_num * face_bytes);
+    }
+    *(int32_t*)valid_num_tensor->GetData() = static_cast<int32_t>(valid_num);
+    if (valid_num == 0) {
+        return 0;
+    }
+
+#ifdef FACE_ALIGN_WITH_OPENCV
     std::vector<Point2f> src_face_keypoints(FACE_KEYPOINT_NUM);
-    std::vector<Point2f> dst_face_keypoints(FACE_KEYPOINT_NUM);
     //warp default keypoint
     for(int i = 0; i < FACE_KEYPOINT_NUM; i++){
-        src_face_keypoints[i].x = (float)default_keypoint[i * 2];
-        src_face_keypoints[i].y = (float)default_keypoint[i * 2 + 1];
-    }
-
-    for(int i = 0; i < face_num; i++){
-        //warp target keypoint
-        dst_face_keypoints[0].x = keypoint_data_ptr[i * 10 + 0];
-        dst_face_keypoints[0].y = keypoint_data_ptr[i * 10 + 1];
-        dst_face_keypoints[1].x = keypoint_data_ptr[i * 10 + 2];
-        dst_face_keypoints[1].y = keypoint_data_ptr[i * 10 + 3];
-        dst_face_keypoints[2].x = keypoint_data_ptr[i * 10 + 4];
-        dst_face_keypoints[2].y = keypoint_data_ptr[i * 10 + 5];
-        dst_face_keypoints[3].x = keypoint_data_ptr[i * 10 + 6];
-        dst_face_keypoints[3].y = keypoint_data_ptr[i * 10 + 7];
-        dst_face_keypoints[4].x = keypoint_data_ptr[i * 10 + 8];
-        dst_face_keypoints[4].y = keypoint_data_ptr[i * 10 + 9];
-
-        Mat M = estimateAffine2D(dst_face_keypoints, src_face_keypoints);
-        Mat face_alinged;
-        warpAffine(img, face_alinged, M, Size(face_size[0],face_size[1]));
-        int image_size = face_alinged.cols * face_alinged.rows * face_alinged.channels();
-        memcpy(output_ptr + i * image_size, face_alinged.data, image_size);
-    }
-    return 0;
+        src_face_keypoints[i].x = (float)attrs->default_keypoint[i * 2];
+        src_face_keypoints[i].y = (float)attrs->default_keypoint[i * 2 + 1];
+    }
+    bool use_ransac = (solver_type == FaceTransformSolver::ROBUST_AFFINE);
+    //cv::warpAffine only writes interleaved uint8
+    bool fast_warp = IsFastWarpSize(face_size[0], face_size[1]) || nv12 ||
+        dst_format.type != WARP_DST_U8 || dst_format.planar;
+#endif
+
+    //each shard aligns faces [start, end) into its own slice of the output
+    auto shard_face_align = [&](int64_t start, int64_t end) {
+#ifdef FACE_ALIGN_WITH_OPENCV
+        std::vector<Point2f> dst_face_keypoints(FACE_KEYPOINT_NUM);
+#endif
+        for (int64_t i = start; i < end; i++) {
+            double matrix[6];
+            bool solved = false;
+#ifdef FACE_ALIGN_WITH_OPENCV
+            if (use_ransac) {
+                //warp target keypoint
+                for (int k = 0; k < FACE_KEYPOINT_NUM; k++) {
+                    dst_face_keypoints[k].x = keypoint_data_ptr[i * 10 + k * 2];
+                    dst_face_keypoints[k].y = keypoint_data_ptr[i * 10 + k * 2 + 1];
+                }
+                Mat M = estimateAffine2D(dst_face_keypoints, src_face_keypoints);
+                solved = !M.empty();
+                if (solved) {
+                    std::copy(M.ptr<double>(0), M.ptr<double>(0) + 6, matrix);
+                }
+            } else {
+                solved = attrs->solver.Solve(solver_type, keypoint_data_ptr + i * 10, matrix);
+            }
+#else
+            solved = attrs->solver.Solve(solver_type, keypoint_data_ptr + i * 10, matrix);
+#endif
+            //warp straight into this face's output slice, no temp buffer
+            uint8_t *face_image = image_data + (box_index_ptr == nullptr ? 0 : box_index_ptr[i] * image_bytes);
+            uint8_t *face_ptr = output_ptr + i * face_bytes;
+            if (!solved) {
+                //degenerate keypoints, output the border value
+                FillWarpDst(face_ptr, dst_format, face_size[1], face_size[0]);
+                continue;
+            }
+#ifdef FACE_ALIGN_WITH_OPENCV
+            if (!fast_warp) {
+                Mat img(image_h, image_w, CV_8UC3, face_image);
+                Mat face_alinged(face_size[1], face_size[0], CV_8UC3, face_ptr);
+                warpAffine(img, face_alinged, Mat(2, 3, CV_64F, matrix), face_alinged.size());
+                continue;
+            }
+#endif
+            bool warped = nv12 ?
+                WarpAffineBilinearNv12(face_image, face_image + static_cast<int64_t>(image_h) * image_w, image_h, image_w,
+                                       image_w, face_ptr, dst_format, face_size[1], face_size[0], matrix) :
+                WarpAffineBilinearC3(face_image, image_h, image_w, image_w * 3, face_ptr, dst_format,
+                                     face_size[1], face_size[0], matrix);
+            if (!warped) {
+                //the face maps beyond any sensible source coordinate, all border
+                FillWarpDst(face_ptr, dst_format, face_size[1], face_size[0]);
+            }
+        }
+    };
+
+    //per-face cost is the warped area, small batches run on one thread
+    int64_t per_unit_size = std::max<int64_t>(1, (kMinShardPixels + face_pixels - 1) / face_pixels);
+    return CpuKernelUtils::ParallelFor(ctx, valid_num, per_unit_size, shard_face_align);
 }
 
 REGISTER_CPU_KERNEL(FACE_ALIGN, FaceAlignCpuKernel);
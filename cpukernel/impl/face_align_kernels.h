@@ -9,8 +9,9 @@
 
 #include "cpu_kernel.h"
 #include <iostream>
-#include "opencv2/opencv.hpp"
-using namespace cv;
+#include <vector>
+#include "face_transform.h"
+#include "face_warp.h"
 namespace aicpu {
 class FaceAlignCpuKernel : public CpuKernel {
 public:
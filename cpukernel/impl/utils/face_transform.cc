@@ -0,0 +1,231 @@
+
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * Description: implement of least-squares face transform solver
+ */
+#include "face_transform.h"
+#include <cmath>
+#include <cstdint>
+
+namespace {
+// squared spread below which the keypoints are treated as a single point
+const double kDegenerateEps = 1e-9;
+// points are selected by the bits of a uint32_t mask
+const int32_t kMaxPointNum = 32;
+// every 3-point sample is tried, which stays cheap up to this many points
+const int32_t kMaxRobustPointNum = 16;
+// reprojection error in pixels, the cv::estimateAffine2D default
+const double kRansacThreshold = 3.0;
+
+uint32_t AllPointsMask(int32_t point_num)
+{
+    return point_num >= kMaxPointNum ? UINT32_MAX : (1u << point_num) - 1;
+}
+}
+
+namespace aicpu {
+bool FaceTransformSolver::Init(const std::vector<int64_t> &template_points, int32_t point_num)
+{
+    if (point_num < 3 || point_num > kMaxPointNum || template_points.size() < static_cast<size_t>(point_num) * 2) {
+        return false;
+    }
+    point_num_ = point_num;
+    mean_x_ = 0.0;
+    mean_y_ = 0.0;
+    for (int32_t i = 0; i < point_num; i++) {
+        mean_x_ += template_points[i * 2];
+        mean_y_ += template_points[i * 2 + 1];
+    }
+    mean_x_ /= point_num;
+    mean_y_ /= point_num;
+
+    centered_.resize(point_num * 2);
+    double spread = 0.0;
+    for (int32_t i = 0; i < point_num; i++) {
+        centered_[i * 2] = template_points[i * 2] - mean_x_;
+        centered_[i * 2 + 1] = template_points[i * 2 + 1] - mean_y_;
+        spread += centered_[i * 2] * centered_[i * 2] + centered_[i * 2 + 1] * centered_[i * 2 + 1];
+    }
+    if (spread < kDegenerateEps) {
+        point_num_ = 0;
+        return false;
+    }
+    return true;
+}
+
+bool FaceTransformSolver::Solve(TransformType type, const float *points, double matrix[6]) const
+{
+    if (point_num_ == 0 || points == nullptr) {
+        return false;
+    }
+    if (type == SIMILARITY) {
+        return SolveSimilarity(points, matrix);
+    }
+    if (type == ROBUST_AFFINE) {
+        return SolveRobustAffine(points, matrix);
+    }
+    return SolveAffine(points, AllPointsMask(point_num_), matrix);
+}
+
+/*
+ * minimize sum |q - [a -b; b a] p - t|^2, q the template and p the image
+ * points. The template is centered, so sum p * q' needs no centering of p.
+ */
+bool FaceTransformSolver::SolveSimilarity(const float *points, double matrix[6]) const
+{
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double sum_sq = 0.0;
+    double num_a = 0.0;
+    double num_b = 0.0;
+    for (int32_t i = 0; i < point_num_; i++) {
+        double px = points[i * 2];
+        double py = points[i * 2 + 1];
+        double qx = centered_[i * 2];
+        double qy = centered_[i * 2 + 1];
+        sum_x += px;
+        sum_y += py;
+        sum_sq += px * px + py * py;
+        num_a += px * qx + py * qy;
+        num_b += px * qy - py * qx;
+    }
+    double mean_px = sum_x / point_num_;
+    double mean_py = sum_y / point_num_;
+    double spread = sum_sq - (sum_x * mean_px + sum_y * mean_py);
+    if (spread < kDegenerateEps) {
+        return false;
+    }
+
+    double a = num_a / spread;
+    double b = num_b / spread;
+    matrix[0] = a;
+    matrix[1] = -b;
+    matrix[2] = mean_x_ - (a * mean_px - b * mean_py);
+    matrix[3] = b;
+    matrix[4] = a;
+    matrix[5] = mean_y_ - (b * mean_px + a * mean_py);
+    return true;
+}
+
+/*
+ * minimize sum |q - A p - t|^2 over the points in mask:
+ * A = (sum q' p'^T) (sum p' p'^T)^-1 and t = mean(q) - A mean(p), where the
+ * primes are deviations from the means over the masked points.
+ */
+bool FaceTransformSolver::SolveAffine(const float *points, uint32_t mask, double matrix[6]) const
+{
+    int32_t n = 0;
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double sum_qx = 0.0;
+    double sum_qy = 0.0;
+    double sxx = 0.0;
+    double sxy = 0.0;
+    double syy = 0.0;
+    double qx_px = 0.0;
+    double qx_py = 0.0;
+    double qy_px = 0.0;
+    double qy_py = 0.0;
+    for (int32_t i = 0; i < point_num_; i++) {
+        if ((mask & (1u << i)) == 0) {
+            continue;
+        }
+        double px = points[i * 2];
+        double py = points[i * 2 + 1];
+        double qx = centered_[i * 2];
+        double qy = centered_[i * 2 + 1];
+        n++;
+        sum_x += px;
+        sum_y += py;
+        sum_qx += qx;
+        sum_qy += qy;
+        sxx += px * px;
+        sxy += px * py;
+        syy += py * py;
+        qx_px += qx * px;
+        qx_py += qx * py;
+        qy_px += qy * px;
+        qy_py += qy * py;
+    }
+    if (n < 3) {
+        return false;
+    }
+    double mean_px = sum_x / n;
+    double mean_py = sum_y / n;
+    sxx -= sum_x * mean_px;
+    sxy -= sum_x * mean_py;
+    syy -= sum_y * mean_py;
+    //the template is centered over all points, sum_q is zero only when all are masked
+    qx_px -= sum_qx * mean_px;
+    qx_py -= sum_qx * mean_py;
+    qy_px -= sum_qy * mean_px;
+    qy_py -= sum_qy * mean_py;
+    double det = sxx * syy - sxy * sxy;
+    if (std::fabs(det) < kDegenerateEps * (sxx + syy + 1.0) * (sxx + syy + 1.0)) {
+        return false;
+    }
+
+    double inv_xx = syy / det;
+    double inv_xy = -sxy / det;
+    double inv_yy = sxx / det;
+    matrix[0] = qx_px * inv_xx + qx_py * inv_xy;
+    matrix[1] = qx_px * inv_xy + qx_py * inv_yy;
+    matrix[3] = qy_px * inv_xx + qy_py * inv_xy;
+    matrix[4] = qy_px * inv_xy + qy_py * inv_yy;
+    matrix[2] = mean_x_ + sum_qx / n - (matrix[0] * mean_px + matrix[1] * mean_py);
+    matrix[5] = mean_y_ + sum_qy / n - (matrix[3] * mean_px + matrix[4] * mean_py);
+    return true;
+}
+
+/*
+ * RANSAC as cv::estimateAffine2D does it, except that with a handful of
+ * keypoints every 3-point sample is tried instead of random ones, so the
+ * result is deterministic. The sample with most inliers, then the smallest
+ * inlier error, is refit by least squares on its inliers.
+ */
+bool FaceTransformSolver::SolveRobustAffine(const float *points, double matrix[6]) const
+{
+    if (point_num_ > kMaxRobustPointNum) {
+        return SolveAffine(points, AllPointsMask(point_num_), matrix);
+    }
+    const double threshold = kRansacThreshold * kRansacThreshold;
+    uint32_t best_mask = 0;
+    int32_t best_count = 0;
+    double best_error = 0.0;
+    double sample[6];
+    for (int32_t i = 0; i < point_num_; i++) {
+        for (int32_t j = i + 1; j < point_num_; j++) {
+            for (int32_t k = j + 1; k < point_num_; k++) {
+                if (!SolveAffine(points, (1u << i) | (1u << j) | (1u << k), sample)) {
+                    continue;
+                }
+                uint32_t mask = 0;
+                int32_t count = 0;
+                double error = 0.0;
+                for (int32_t p = 0; p < point_num_; p++) {
+                    double px = points[p * 2];
+                    double py = points[p * 2 + 1];
+                    double dx = sample[0] * px + sample[1] * py + sample[2] - (centered_[p * 2] + mean_x_);
+                    double dy = sample[3] * px + sample[4] * py + sample[5] - (centered_[p * 2 + 1] + mean_y_);
+                    double err = dx * dx + dy * dy;
+                    if (err <= threshold) {
+                        mask |= 1u << p;
+                        count++;
+                        error += err;
+                    }
+                }
+                if (count > best_count || (count == best_count && error < best_error)) {
+                    best_mask = mask;
+                    best_count = count;
+                    best_error = error;
+                }
+            }
+        }
+    }
+    //an exact 3-point fit is its own inlier set, unless every sample was degenerate
+    if (best_count < 3) {
+        return false;
+    }
+    return SolveAffine(points, best_mask, matrix);
+}
+} // namespace aicpu
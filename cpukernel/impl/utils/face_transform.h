@@ -0,0 +1,59 @@
+
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * Description: api of least-squares face transform solver
+ */
+
+#ifndef _FACE_TRANSFORM_H_
+#define _FACE_TRANSFORM_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace aicpu {
+/*
+ * Closed-form least-squares fit of the 2x3 matrix that maps image keypoints
+ * onto a fixed template. The template side is centered once in Init, so each
+ * Solve only accumulates moments of the image keypoints.
+ */
+class FaceTransformSolver {
+public:
+    enum TransformType {
+        SIMILARITY = 0,     // rotation + uniform scale + translation, 4 dof
+        AFFINE = 1,         // full affine, 6 dof
+        ROBUST_AFFINE = 2   // affine refit on the inliers of the best 3-point sample
+    };
+
+    FaceTransformSolver() = default;
+    ~FaceTransformSolver() = default;
+
+    /*
+     * precompute the template side.
+     * @param template_points: x0, y0, x1, y1, ... of the template keypoints
+     * @param point_num: number of keypoints, 3 to 32
+     * @return bool: true->success false->degenerate template
+     */
+    bool Init(const std::vector<int64_t> &template_points, int32_t point_num);
+
+    /*
+     * solve the matrix mapping image points onto the template.
+     * @param points: x0, y0, x1, y1, ... of point_num image keypoints
+     * @param matrix: row-major 2x3 output, dst = matrix * [x, y, 1]
+     * @return bool: true->success false->degenerate keypoints
+     */
+    bool Solve(TransformType type, const float *points, double matrix[6]) const;
+
+    int32_t PointNum() const { return point_num_; }
+
+private:
+    bool SolveSimilarity(const float *points, double matrix[6]) const;
+    bool SolveAffine(const float *points, uint32_t mask, double matrix[6]) const;
+    bool SolveRobustAffine(const float *points, double matrix[6]) const;
+
+    int32_t point_num_ = 0;
+    double mean_x_ = 0.0;
+    double mean_y_ = 0.0;
+    std::vector<double> centered_;  // template points minus their mean
+};
+} // namespace aicpu
+#endif
@@ -0,0 +1,584 @@
+
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * Description: implement of bilinear affine warp for small 3-channel face crops
+ */
+#include "face_warp.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include "Eigen/Core"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#define FACE_WARP_X86
+#endif
+
+namespace {
+const int32_t kInterBits = 5;
+const int32_t kInterTabSize = 1 << kInterBits;
+const int32_t kAbBits = 10;
+const int32_t kAbScale = 1 << kAbBits;
+const int32_t kRoundDelta = kAbScale / kInterTabSize / 2;
+const int32_t kCoefBits = 15;
+const int32_t kCoefScale = 1 << kCoefBits;
+const int32_t kChannels = 3;
+// dst columns warped per block, the per-row coordinate tables live on the stack
+const int32_t kBlockWidth = 256;
+
+/*
+ * fixed-point bilinear weights indexed by (fy << 5) + fx, built the way
+ * OpenCV builds its INTER_LINEAR table. The (0, 0) entry saturates to 32767
+ * and OpenCV moves the lost unit onto the last tap, so it is {32767, 0, 0, 1}.
+ */
+struct BilinearTab {
+    int16_t w[kInterTabSize * kInterTabSize][4];
+
+    BilinearTab()
+    {
+        for (int32_t fy = 0; fy < kInterTabSize; fy++) {
+            for (int32_t fx = 0; fx < kInterTabSize; fx++) {
+                int16_t *entry = w[fy * kInterTabSize + fx];
+                int32_t scale = kCoefScale / (kInterTabSize * kInterTabSize);
+                entry[0] = static_cast<int16_t>(std::min((kInterTabSize - fx) * (kInterTabSize - fy) * scale,
+                                                         kCoefScale - 1));
+                entry[1] = static_cast<int16_t>(fx * (kInterTabSize - fy) * scale);
+                entry[2] = static_cast<int16_t>((kInterTabSize - fx) * fy * scale);
+                entry[3] = static_cast<int16_t>(fx * fy * scale);
+            }
+        }
+        w[0][3] = 1;
+    }
+};
+
+const BilinearTab &GetBilinearTab()
+{
+    static const BilinearTab tab;
+    return tab;
+}
+
+inline int32_t SaturateRound(double v)
+{
+    if (!(v > INT_MIN)) {
+        return INT_MIN;
+    }
+    if (!(v < INT_MAX)) {
+        return INT_MAX;
+    }
+    return static_cast<int32_t>(std::lrint(v));
+}
+
+inline uint8_t CastCoef(int32_t v)
+{
+    v = (v + (1 << (kCoefBits - 1))) >> kCoefBits;
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > UINT8_MAX ? UINT8_MAX : v));
+}
+
+// source coordinates beyond this many pixels are rejected, so that the
+// fixed-point coordinates with 10 fractional bits never overflow int32
+const double kMaxCoord = 1 << 20;
+
+/*
+ * a run of pixels whose four taps, plus the two bytes an 8-byte load reads
+ * past them, lie inside the source image.
+ */
+typedef void (*BlendRunFunc)(const uint8_t *src, int64_t step, const int32_t *sxs, const int32_t *sys,
+                             const uint16_t *widx, uint8_t *dst, int32_t n);
+
+inline const uint8_t *TapPtr(const uint8_t *src, int64_t step, int32_t sx, int32_t sy)
+{
+    return src + sy * step + sx * kChannels;
+}
+
+void BlendRunScalar(const uint8_t *src, int64_t step, const int32_t *sxs, const int32_t *sys,
+                    const uint16_t *widx, uint8_t *dst, int32_t n)
+{
+    const BilinearTab &tab = GetBilinearTab();
+    for (int32_t i = 0; i < n; i++, dst += kChannels) {
+        const uint8_t *s = TapPtr(src, step, sxs[i], sys[i]);
+        const int16_t *w = tab.w[widx[i]];
+        for (int32_t k = 0; k < kChannels; k++) {
+            dst[k] = CastCoef(s[k] * w[0] + s[k + kChannels] * w[1] +
+                              s[step + k] * w[2] + s[step + k + kChannels] * w[3]);
+        }
+    }
+}
+
+#ifdef FACE_WARP_X86
+/*
+ * pshufb turns the 8 bytes at a tap row into 16-bit pairs (c of pixel 0,
+ * c of pixel 1) per channel, so one pmaddwd applies both horizontal weights.
+ */
+__attribute__((target("ssse3"))) inline __m128i BlendPixelSsse3(const uint8_t *s, int64_t step,
+                                                               const int16_t *w)
+{
+    const __m128i pair_shuffle = _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1);
+    const __m128i delta = _mm_set1_epi32(1 << (kCoefBits - 1));
+    __m128i top = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s)), pair_shuffle);
+    __m128i bottom = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + step)), pair_shuffle);
+    __m128i weights = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(w));
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(top, _mm_shuffle_epi32(weights, 0x00)),
+                                _mm_madd_epi16(bottom, _mm_shuffle_epi32(weights, 0x55)));
+    return _mm_srai_epi32(_mm_add_epi32(sum, delta), kCoefBits);
+}
+
+__attribute__((target("ssse3"))) void BlendRunSsse3(const uint8_t *src, int64_t step, const int32_t *sxs,
+                                                    const int32_t *sys, const uint16_t *widx, uint8_t *dst,
+                                                    int32_t n)
+{
+    const BilinearTab &tab = GetBilinearTab();
+    for (int32_t i = 0; i < n; i++, dst += kChannels) {
+        __m128i sum = BlendPixelSsse3(TapPtr(src, step, sxs[i], sys[i]), step, tab.w[widx[i]]);
+        sum = _mm_packs_epi32(sum, sum);
+        uint32_t pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+        memcpy(dst, &pixel, kChannels);
+    }
+}
+
+/*
+ * two pixels per iteration, one in each 128-bit lane.
+ */
+__attribute__((target("avx2"))) void BlendRunAvx2(const uint8_t *src, int64_t step, const int32_t *sxs,
+                                                  const int32_t *sys, const uint16_t *widx, uint8_t *dst,
+                                                  int32_t n)
+{
+    const BilinearTab &tab = GetBilinearTab();
+    const __m256i pair_shuffle = _mm256_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1,
+                                                  0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1);
+    const __m256i delta = _mm256_set1_epi32(1 << (kCoefBits - 1));
+    const __m128i pack_shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    int32_t i = 0;
+    for (; i + 1 < n; i += 2, dst += kChannels * 2) {
+        const uint8_t *s0 = TapPtr(src, step, sxs[i], sys[i]);
+        const uint8_t *s1 = TapPtr(src, step, sxs[i + 1], sys[i + 1]);
+        __m256i top = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s0))),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s1)), 1);
+        __m256i bottom = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s0 + step))),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s1 + step)), 1);
+        __m256i weights = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(tab.w[widx[i]]))),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(tab.w[widx[i + 1]])), 1);
+        top = _mm256_shuffle_epi8(top, pair_shuffle);
+        bottom = _mm256_shuffle_epi8(bottom, pair_shuffle);
+        __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(top, _mm256_shuffle_epi32(weights, 0x00)),
+                                       _mm256_madd_epi16(bottom, _mm256_shuffle_epi32(weights, 0x55)));
+        sum = _mm256_srai_epi32(_mm256_add_epi32(sum, delta), kCoefBits);
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        packed = _mm_shuffle_epi8(_mm_packus_epi16(packed, packed), pack_shuffle);
+        uint64_t pixels = static_cast<uint64_t>(_mm_cvtsi128_si64(packed));
+        memcpy(dst, &pixels, kChannels * 2);
+    }
+    if (i < n) {
+        BlendRunSsse3(src, step, sxs + i, sys + i, widx + i, dst, n - i);
+    }
+}
+#endif
+
+#if defined(__aarch64__)
+/*
+ * widen both tap rows to u16, vext lines the right tap up with the left one
+ * and vrshrn does the rounding shift of the fixed-point cast.
+ */
+void BlendRunNeon(const uint8_t *src, int64_t step, const int32_t *sxs, const int32_t *sys,
+                  const uint16_t *widx, uint8_t *dst, int32_t n)
+{
+    const BilinearTab &tab = GetBilinearTab();
+    for (int32_t i = 0; i < n; i++, dst += kChannels) {
+        const uint8_t *s = TapPtr(src, step, sxs[i], sys[i]);
+        const int16_t *w = tab.w[widx[i]];
+        uint16x8_t top = vmovl_u8(vld1_u8(s));
+        uint16x8_t bottom = vmovl_u8(vld1_u8(s + step));
+        uint32x4_t sum = vmull_n_u16(vget_low_u16(top), static_cast<uint16_t>(w[0]));
+        sum = vmlal_n_u16(sum, vget_low_u16(vextq_u16(top, top, kChannels)), static_cast<uint16_t>(w[1]));
+        sum = vmlal_n_u16(sum, vget_low_u16(bottom), static_cast<uint16_t>(w[2]));
+        sum = vmlal_n_u16(sum, vget_low_u16(vextq_u16(bottom, bottom, kChannels)), static_cast<uint16_t>(w[3]));
+        uint16x4_t narrowed = vrshrn_n_u32(sum, kCoefBits);
+        uint8x8_t pixel = vqmovn_u16(vcombine_u16(narrowed, narrowed));
+        dst[0] = vget_lane_u8(pixel, 0);
+        dst[1] = vget_lane_u8(pixel, 1);
+        dst[2] = vget_lane_u8(pixel, 2);
+    }
+}
+#endif
+
+BlendRunFunc GetBlendRun(aicpu::WarpIsa isa)
+{
+#ifdef FACE_WARP_X86
+    if (isa == aicpu::WARP_ISA_AVX2) {
+        return BlendRunAvx2;
+    }
+    if (isa == aicpu::WARP_ISA_SSSE3) {
+        return BlendRunSsse3;
+    }
+#endif
+#if defined(__aarch64__)
+    if (isa == aicpu::WARP_ISA_NEON) {
+        return BlendRunNeon;
+    }
+#endif
+    return BlendRunScalar;
+}
+
+/*
+ * pixel with at least one tap outside the source, taps outside read zero.
+ */
+void BlendBorderPixel(const uint8_t *src, int32_t src_h, int32_t src_w, int64_t step,
+                      int32_t sx, int32_t sy, uint16_t widx, uint8_t *dst)
+{
+    if (sx >= src_w || sx + 1 < 0 || sy >= src_h || sy + 1 < 0) {
+        dst[0] = 0;
+        dst[1] = 0;
+        dst[2] = 0;
+        return;
+    }
+    const uint8_t zero[kChannels] = {0, 0, 0};
+    bool x0_in = sx >= 0;
+    bool x1_in = sx + 1 < src_w;
+    bool y0_in = sy >= 0;
+    bool y1_in = sy + 1 < src_h;
+    const uint8_t *row0 = src + sy * step;
+    const uint8_t *row1 = row0 + step;
+    const uint8_t *v0 = (x0_in && y0_in) ? row0 + sx * kChannels : zero;
+    const uint8_t *v1 = (x1_in && y0_in) ? row0 + (sx + 1) * kChannels : zero;
+    const uint8_t *v2 = (x0_in && y1_in) ? row1 + sx * kChannels : zero;
+    const uint8_t *v3 = (x1_in && y1_in) ? row1 + (sx + 1) * kChannels : zero;
+    const int16_t *w = GetBilinearTab().w[widx];
+    for (int32_t k = 0; k < kChannels; k++) {
+        dst[k] = CastCoef(v0[k] * w[0] + v1[k] * w[1] + v2[k] * w[2] + v3[k] * w[3]);
+    }
+}
+
+/*
+ * invert src->dst into dst->src as cv::warpAffine does. False when a source
+ * coordinate of the crop exceeds kMaxCoord, every one lies between those of
+ * the dst corners.
+ */
+bool InvertWarpMatrix(const double matrix[6], int32_t dst_h, int32_t dst_w, double m[6])
+{
+    double det = matrix[0] * matrix[4] - matrix[1] * matrix[3];
+    det = det != 0.0 ? 1.0 / det : 0.0;
+    m[0] = matrix[4] * det;
+    m[1] = -matrix[1] * det;
+    m[3] = -matrix[3] * det;
+    m[4] = matrix[0] * det;
+    m[2] = -m[0] * matrix[2] - m[1] * matrix[5];
+    m[5] = -m[3] * matrix[2] - m[4] * matrix[5];
+
+    for (int32_t corner = 0; corner < 4; corner++) {
+        double cx = (corner & 1) ? dst_w : 0;
+        double cy = (corner & 2) ? dst_h : 0;
+        if (!(std::fabs(m[0] * cx + m[1] * cy + m[2]) <= kMaxCoord) ||
+            !(std::fabs(m[3] * cx + m[4] * cy + m[5]) <= kMaxCoord)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * fixed-point x steps of block_w dst columns starting at block_x.
+ */
+void FillColumnDeltas(const double m[6], int32_t block_x, int32_t block_w, int32_t *adelta, int32_t *bdelta)
+{
+    for (int32_t x = 0; x < block_w; x++) {
+        adelta[x] = SaturateRound(m[0] * (block_x + x) * kAbScale);
+        bdelta[x] = SaturateRound(m[3] * (block_x + x) * kAbScale);
+    }
+}
+
+/*
+ * integer source pixel and bilinear table index of n pixels of dst row y.
+ */
+void FillRowCoords(const double m[6], int32_t y, const int32_t *adelta, const int32_t *bdelta, int32_t n,
+                   int32_t *sxs, int32_t *sys, uint16_t *widx)
+{
+    int32_t x0 = SaturateRound((m[1] * y + m[2]) * kAbScale) + kRoundDelta;
+    int32_t y0 = SaturateRound((m[4] * y + m[5]) * kAbScale) + kRoundDelta;
+    for (int32_t x = 0; x < n; x++) {
+        int32_t fx = (x0 + adelta[x]) >> (kAbBits - kInterBits);
+        int32_t fy = (y0 + bdelta[x]) >> (kAbBits - kInterBits);
+        sxs[x] = fx >> kInterBits;
+        sys[x] = fy >> kInterBits;
+        widx[x] = static_cast<uint16_t>((fy & (kInterTabSize - 1)) * kInterTabSize + (fx & (kInterTabSize - 1)));
+    }
+}
+
+// BT.601 video range YUV to BGR in 20-bit fixed point, the cv::cvtColor NV12 constants
+const int32_t kYuvShift = 20;
+const int32_t kYuvCy = 1220542;
+const int32_t kYuvCub = 2116026;
+const int32_t kYuvCug = -409993;
+const int32_t kYuvCvg = -852492;
+const int32_t kYuvCvr = 1673527;
+// taps outside the image read the YUV of BGR black, so the border stays black
+const uint8_t kYuvBorder[3] = {16, 128, 128};
+
+inline uint8_t YuvDescale(int32_t v)
+{
+    v >>= kYuvShift;
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > UINT8_MAX ? UINT8_MAX : v));
+}
+
+inline void YuvToBgr(int32_t y, int32_t u, int32_t v, uint8_t *bgr)
+{
+    int32_t luma = std::max(0, y - 16) * kYuvCy;
+    u -= 128;
+    v -= 128;
+    bgr[0] = YuvDescale(luma + (1 << (kYuvShift - 1)) + kYuvCub * u);
+    bgr[1] = YuvDescale(luma + (1 << (kYuvShift - 1)) + kYuvCvg * v + kYuvCug * u);
+    bgr[2] = YuvDescale(luma + (1 << (kYuvShift - 1)) + kYuvCvr * v);
+}
+
+/*
+ * bilinear Y, U and V at one dst pixel, then its BGR. Each luma tap reads the
+ * chroma pair of its 2x2 block, which is what warping the output of
+ * cv::cvtColor would blend.
+ */
+void BlendNv12Pixel(const uint8_t *y_plane, const uint8_t *uv_plane, int32_t src_h, int32_t src_w,
+                    int64_t step, int32_t sx, int32_t sy, uint16_t widx, uint8_t *dst)
+{
+    const int16_t *w = GetBilinearTab().w[widx];
+    int32_t sum[3] = {0, 0, 0};
+    for (int32_t tap = 0; tap < 4; tap++) {
+        int32_t tx = sx + (tap & 1);
+        int32_t ty = sy + (tap >> 1);
+        if (tx < 0 || tx >= src_w || ty < 0 || ty >= src_h) {
+            sum[0] += kYuvBorder[0] * w[tap];
+            sum[1] += kYuvBorder[1] * w[tap];
+            sum[2] += kYuvBorder[2] * w[tap];
+            continue;
+        }
+        const uint8_t *uv = uv_plane + (ty >> 1) * step + (tx & ~1);
+        sum[0] += y_plane[ty * step + tx] * w[tap];
+        sum[1] += uv[0] * w[tap];
+        sum[2] += uv[1] * w[tap];
+    }
+    YuvToBgr(CastCoef(sum[0]), CastCoef(sum[1]), CastCoef(sum[2]), dst);
+}
+
+template <typename T>
+void StoreRowLut(const T lut[][256], bool planar, const uint8_t *row, int32_t n, int64_t plane,
+                 T *dst)
+{
+    if (planar) {
+        for (int32_t c = 0; c < kChannels; c++) {
+            T *out = dst + c * plane;
+            for (int32_t x = 0; x < n; x++) {
+                out[x] = lut[c][row[x * kChannels + c]];
+            }
+        }
+        return;
+    }
+    for (int32_t x = 0; x < n; x++) {
+        dst[x * kChannels] = lut[0][row[x * kChannels]];
+        dst[x * kChannels + 1] = lut[1][row[x * kChannels + 1]];
+        dst[x * kChannels + 2] = lut[2][row[x * kChannels + 2]];
+    }
+}
+
+/*
+ * write n warped uint8 pixels, dst pixel offset first, in the dst format.
+ */
+void StoreRow(const aicpu::WarpDstFormat &format, const uint8_t *row, int32_t n, int64_t first,
+              int64_t plane, void *dst)
+{
+    int64_t offset = format.planar ? first : first * kChannels;
+    if (format.type == aicpu::WARP_DST_F32) {
+        StoreRowLut(format.lut_f32, format.planar, row, n, plane, static_cast<float *>(dst) + offset);
+    } else if (format.type == aicpu::WARP_DST_F16) {
+        StoreRowLut(format.lut_f16, format.planar, row, n, plane, static_cast<uint16_t *>(dst) + offset);
+    } else if (format.planar) {
+        uint8_t *out = static_cast<uint8_t *>(dst) + offset;
+        for (int32_t c = 0; c < kChannels; c++) {
+            for (int32_t x = 0; x < n; x++) {
+                out[c * plane + x] = row[x * kChannels + c];
+            }
+        }
+    } else {
+        memcpy(static_cast<uint8_t *>(dst) + offset, row, n * kChannels);
+    }
+}
+}
+
+namespace aicpu {
+bool InitWarpDstFormat(WarpDstFormat &format, WarpDstType type, bool planar,
+                       const float mean[3], const float std[3])
+{
+    for (int32_t c = 0; c < kChannels; c++) {
+        if (!std::isfinite(std[c]) || std[c] == 0.0f || !std::isfinite(mean[c])) {
+            return false;
+        }
+    }
+    format.type = type;
+    format.planar = planar;
+    for (int32_t c = 0; c < kChannels; c++) {
+        for (int32_t v = 0; v < 256; v++) {
+            float value = (static_cast<float>(v) - mean[c]) / std[c];
+            format.lut_f32[c][v] = value;
+            format.lut_f16[c][v] = Eigen::half(value).x;
+        }
+    }
+    return true;
+}
+
+int64_t WarpDstBytes(const WarpDstFormat &format, int32_t dst_h, int32_t dst_w)
+{
+    int64_t elements = static_cast<int64_t>(dst_h) * dst_w * kChannels;
+    if (format.type == WARP_DST_F32) {
+        return elements * sizeof(float);
+    }
+    if (format.type == WARP_DST_F16) {
+        return elements * sizeof(uint16_t);
+    }
+    return elements;
+}
+
+void FillWarpDst(void *dst, const WarpDstFormat &format, int32_t dst_h, int32_t dst_w)
+{
+    if (format.type == WARP_DST_U8) {
+        memset(dst, 0, WarpDstBytes(format, dst_h, dst_w));
+        return;
+    }
+    uint8_t zero_row[kBlockWidth * kChannels] = {0};
+    int64_t plane = static_cast<int64_t>(dst_h) * dst_w;
+    for (int64_t first = 0; first < plane; first += kBlockWidth) {
+        int32_t n = static_cast<int32_t>(std::min<int64_t>(kBlockWidth, plane - first));
+        StoreRow(format, zero_row, n, first, plane, dst);
+    }
+}
+
+WarpIsa GetWarpIsa()
+{
+#if defined(__aarch64__)
+    return WARP_ISA_NEON;
+#elif defined(FACE_WARP_X86)
+    static const WarpIsa isa = __builtin_cpu_supports("avx2") ? WARP_ISA_AVX2 :
+        (__builtin_cpu_supports("ssse3") ? WARP_ISA_SSSE3 : WARP_ISA_SCALAR);
+    return isa;
+#else
+    return WARP_ISA_SCALAR;
+#endif
+}
+
+bool WarpAffineBilinearC3(const uint8_t *src, int32_t src_h, int32_t src_w, int64_t src_step,
+                          uint8_t *dst, int32_t dst_h, int32_t dst_w, const double matrix[6],
+                          WarpIsa isa)
+{
+    static const WarpDstFormat hwc_u8 = WarpDstFormat();
+    return WarpAffineBilinearC3(src, src_h, src_w, src_step, dst, hwc_u8, dst_h, dst_w, matrix, isa);
+}
+
+bool WarpAffineBilinearC3(const uint8_t *src, int32_t src_h, int32_t src_w, int64_t src_step,
+                          void *dst, const WarpDstFormat &format, int32_t dst_h, int32_t dst_w,
+                          const double matrix[6], WarpIsa isa)
+{
+    if (src == nullptr || dst == nullptr || matrix == nullptr || src_h <= 0 || src_w <= 0 ||
+        src_step < src_w * kChannels || dst_h <= 0 || dst_w <= 0) {
+        return false;
+    }
+
+    double m[6];
+    if (!InvertWarpMatrix(matrix, dst_h, dst_w, m)) {
+        return false;
+    }
+
+    BlendRunFunc blend_run = GetBlendRun(isa);
+    int32_t adelta[kBlockWidth];
+    int32_t bdelta[kBlockWidth];
+    int32_t sxs[kBlockWidth];
+    int32_t sys[kBlockWidth];
+    uint16_t widx[kBlockWidth];
+    //rows of any other format are warped here first, then converted from L1
+    bool direct = format.type == WARP_DST_U8 && !format.planar;
+    uint8_t row_buf[kBlockWidth * kChannels];
+    int64_t plane = static_cast<int64_t>(dst_h) * dst_w;
+    //simd taps read 8 bytes, so the pixel right of the right tap must exist
+    auto simd_safe = [&](int32_t x) {
+        return sxs[x] >= 0 && sxs[x] + 3 <= src_w && sys[x] >= 0 && sys[x] + 1 < src_h;
+    };
+    for (int32_t block_x = 0; block_x < dst_w; block_x += kBlockWidth) {
+        int32_t block_w = std::min(kBlockWidth, dst_w - block_x);
+        FillColumnDeltas(m, block_x, block_w, adelta, bdelta);
+        for (int32_t y = 0; y < dst_h; y++) {
+            int64_t first = static_cast<int64_t>(y) * dst_w + block_x;
+            uint8_t *dst_row = direct ? static_cast<uint8_t *>(dst) + first * kChannels : row_buf;
+            FillRowCoords(m, y, adelta, bdelta, block_w, sxs, sys, widx);
+
+            //sx and sy are monotonic along a row, so the simd-safe pixels form one run
+            int32_t run_begin = 0;
+            while (run_begin < block_w && !simd_safe(run_begin)) {
+                run_begin++;
+            }
+            int32_t run_end = block_w;
+            while (run_end > run_begin && !simd_safe(run_end - 1)) {
+                run_end--;
+            }
+            if (run_end > run_begin) {
+                blend_run(src, src_step, sxs + run_begin, sys + run_begin, widx + run_begin,
+                          dst_row + run_begin * kChannels, run_end - run_begin);
+            }
+            for (int32_t x = 0; x < block_w; x++) {
+                if (x == run_begin && run_end > run_begin) {
+                    x = run_end - 1;
+                    continue;
+                }
+                if (sxs[x] >= 0 && sxs[x] + 1 < src_w && sys[x] >= 0 && sys[x] + 1 < src_h) {
+                    BlendRunScalar(src, src_step, sxs + x, sys + x, widx + x, dst_row + x * kChannels, 1);
+                } else {
+                    BlendBorderPixel(src, src_h, src_w, src_step, sxs[x], sys[x], widx[x],
+                                     dst_row + x * kChannels);
+                }
+            }
+            if (!direct) {
+                StoreRow(format, row_buf, block_w, first, plane, dst);
+            }
+        }
+    }
+    return true;
+}
+
+bool WarpAffineBilinearNv12(const uint8_t *y_plane, const uint8_t *uv_plane, int32_t src_h, int32_t src_w,
+                            int64_t src_step, void *dst, const WarpDstFormat &format, int32_t dst_h,
+                            int32_t dst_w, const double matrix[6])
+{
+    if (y_plane == nullptr || uv_plane == nullptr || dst == nullptr || matrix == nullptr || src_h <= 0 ||
+        src_w <= 0 || src_h % 2 != 0 || src_w % 2 != 0 || src_step < src_w || dst_h <= 0 || dst_w <= 0) {
+        return false;
+    }
+    double m[6];
+    if (!InvertWarpMatrix(matrix, dst_h, dst_w, m)) {
+        return false;
+    }
+
+    int32_t adelta[kBlockWidth];
+    int32_t bdelta[kBlockWidth];
+    int32_t sxs[kBlockWidth];
+    int32_t sys[kBlockWidth];
+    uint16_t widx[kBlockWidth];
+    bool direct = format.type == WARP_DST_U8 && !format.planar;
+    uint8_t row_buf[kBlockWidth * kChannels];
+    int64_t plane = static_cast<int64_t>(dst_h) * dst_w;
+    for (int32_t block_x = 0; block_x < dst_w; block_x += kBlockWidth) {
+        int32_t block_w = std::min(kBlockWidth, dst_w - block_x);
+        FillColumnDeltas(m, block_x, block_w, adelta, bdelta);
+        for (int32_t y = 0; y < dst_h; y++) {
+            int64_t first = static_cast<int64_t>(y) * dst_w + block_x;
+            uint8_t *dst_row = direct ? static_cast<uint8_t *>(dst) + first * kChannels : row_buf;
+            FillRowCoords(m, y, adelta, bdelta, block_w, sxs, sys, widx);
+            for (int32_t x = 0; x < block_w; x++) {
+                BlendNv12Pixel(y_plane, uv_plane, src_h, src_w, src_step, sxs[x], sys[x], widx[x],
+                               dst_row + x * kChannels);
+            }
+            if (!direct) {
+                StoreRow(format, row_buf, block_w, first, plane, dst);
+            }
+        }
+    }
+    return true;
+}
+} // namespace aicpu
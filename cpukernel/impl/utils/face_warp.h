@@ -0,0 +1,95 @@
+
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * Description: api of bilinear affine warp for small 3-channel face crops
+ */
+
+#ifndef _FACE_WARP_H_
+#define _FACE_WARP_H_
+
+#include <cstdint>
+
+namespace aicpu {
+enum WarpIsa {
+    WARP_ISA_SCALAR = 0,
+    WARP_ISA_SSSE3 = 1,
+    WARP_ISA_AVX2 = 2,
+    WARP_ISA_NEON = 3
+};
+
+enum WarpDstType {
+    WARP_DST_U8 = 0,
+    WARP_DST_F32 = 1,
+    WARP_DST_F16 = 2
+};
+
+/*
+ * element type and layout of the warp output. Float outputs hold
+ * (v - mean[c]) / std[c] of the warped uint8 value v, read from per-channel
+ * tables, so every instruction set writes the same bits.
+ */
+struct WarpDstFormat {
+    WarpDstType type = WARP_DST_U8;
+    bool planar = false;  // CHW instead of HWC
+    float lut_f32[3][256];
+    uint16_t lut_f16[3][256];  // float16 bits
+};
+
+/*
+ * set type, layout and normalization of a warp output.
+ * @return bool: false->a std value is zero or not finite
+ */
+bool InitWarpDstFormat(WarpDstFormat &format, WarpDstType type, bool planar,
+                       const float mean[3], const float std[3]);
+
+/*
+ * bytes of one dst_h x dst_w crop in the given format.
+ */
+int64_t WarpDstBytes(const WarpDstFormat &format, int32_t dst_h, int32_t dst_w);
+
+/*
+ * fill a crop with the border value, a warp that sees no source pixel.
+ */
+void FillWarpDst(void *dst, const WarpDstFormat &format, int32_t dst_h, int32_t dst_w);
+
+/*
+ * best instruction set the warp can use on this cpu.
+ */
+WarpIsa GetWarpIsa();
+
+/*
+ * inverse-mapping bilinear warp of an HWC uint8 3-channel image with a
+ * constant zero border. Follows the fixed-point scheme of cv::warpAffine
+ * INTER_LINEAR: source coordinates carry 5 fractional bits per axis and
+ * the four tap weights sum to 1 << 15.
+ * @param src: source image, src_h rows of src_step bytes
+ * @param dst: output crop, dst_h * dst_w * 3 bytes, rows packed
+ * @param matrix: row-major 2x3 matrix mapping src to dst, inverted here
+ * @param isa: instruction set to use, must not exceed GetWarpIsa()
+ * @return bool: false->source coordinates out of range or bad params, dst untouched
+ */
+bool WarpAffineBilinearC3(const uint8_t *src, int32_t src_h, int32_t src_w, int64_t src_step,
+                          uint8_t *dst, int32_t dst_h, int32_t dst_w, const double matrix[6],
+                          WarpIsa isa = GetWarpIsa());
+
+/*
+ * same warp, each output row is converted to format while still in cache.
+ */
+bool WarpAffineBilinearC3(const uint8_t *src, int32_t src_h, int32_t src_w, int64_t src_step,
+                          void *dst, const WarpDstFormat &format, int32_t dst_h, int32_t dst_w,
+                          const double matrix[6], WarpIsa isa = GetWarpIsa());
+
+/*
+ * same warp from a YUV420SP (NV12) image: Y, U and V are interpolated at
+ * each output pixel and only those pixels are converted to BGR, with the
+ * BT.601 video range coefficients of cv::cvtColor.
+ * @param y_plane: src_h rows of src_step bytes
+ * @param uv_plane: src_h / 2 rows of src_step bytes, interleaved U and V
+ * @param src_h: image height, even
+ * @param src_w: image width, even
+ */
+bool WarpAffineBilinearNv12(const uint8_t *y_plane, const uint8_t *uv_plane, int32_t src_h, int32_t src_w,
+                            int64_t src_step, void *dst, const WarpDstFormat &format, int32_t dst_h,
+                            int32_t dst_w, const double matrix[6]);
+} // namespace aicpu
+#endif
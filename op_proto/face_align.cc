@@ -1,13 +1,149 @@
 #include "face_align.h"
+#include <string>
+#include <utility>
+#include <vector>
+#include "op_log.h"
 namespace ge {
+namespace {
+const size_t kImageRank = 4;
+const size_t kKeypointRank = 2;
+const int64_t kKeypointValues = 10;
+const int64_t kFaceChannels = 3;
+const char *kFormatNchw = "NCHW";
+const char *kInputBgr = "BGR888_U8";
+const char *kInputNv12 = "YUV420SP_U8";
 
+bool GetFaceSize(const Operator &op, std::vector<int64_t> &face_size)
+{
+    if (op.GetAttr("face_size", face_size) != GRAPH_SUCCESS) {
+        OP_LOGE(op.GetName().c_str(), "get attr face_size failed.");
+        return false;
+    }
+    if (face_size.size() != 2 || face_size[0] <= 0 || face_size[1] <= 0) {
+        OP_LOGE(op.GetName().c_str(), "face_size must be two positive ints, width and height.");
+        return false;
+    }
+    return true;
+}
+}
+
+/*
+ * aligned_image is [keypoints dim0, face_size[1], face_size[0], 3], or its
+ * NCHW order, of type output_dtype. Only the face count can be unknown, its
+ * range follows the keypoints range. valid_num is a single int32.
+ */
 IMPLEMT_COMMON_INFERFUNC(FaceAlignInferShape)
 {
-    return GRAPH_SUCCESS;
+    std::vector<int64_t> face_size;
+    if (!GetFaceSize(op, face_size)) {
+        return GRAPH_FAILED;
+    }
+    TensorDesc keypoints_desc = op.GetInputDesc("keypoints");
+    std::vector<int64_t> keypoints_dims = keypoints_desc.GetShape().GetDims();
+    int64_t face_capacity = UNKNOWN_DIM;
+    std::pair<int64_t, int64_t> face_range(1, -1);
+    if (keypoints_dims.size() == kKeypointRank && keypoints_dims[0] != UNKNOWN_DIM) {
+        face_capacity = keypoints_dims[0];
+    } else if (keypoints_dims.size() == kKeypointRank) {
+        std::vector<std::pair<int64_t, int64_t>> keypoints_range;
+        keypoints_desc.GetShapeRange(keypoints_range);
+        if (keypoints_range.size() == kKeypointRank) {
+            face_range = keypoints_range[0];
+        }
+    }
+
+    DataType output_dtype = DT_UINT8;
+    op.GetAttr("output_dtype", output_dtype);
+    std::string output_format = "NHWC";
+    op.GetAttr("output_format", output_format);
+    bool planar = (output_format == kFormatNchw);
+
+    TensorDesc output_desc = op.GetOutputDesc("aligned_image");
+    std::vector<int64_t> output_dims = {face_capacity, face_size[1], face_size[0], kFaceChannels};
+    std::vector<std::pair<int64_t, int64_t>> output_range = {
+        face_range, {face_size[1], face_size[1]}, {face_size[0], face_size[0]}, {kFaceChannels, kFaceChannels}};
+    if (planar) {
+        output_dims = {face_capacity, kFaceChannels, face_size[1], face_size[0]};
+        output_range = {face_range, {kFaceChannels, kFaceChannels}, {face_size[1], face_size[1]},
+                        {face_size[0], face_size[0]}};
+    }
+    output_desc.SetShape(Shape(output_dims));
+    output_desc.SetOriginShape(Shape(output_dims));
+    output_desc.SetDataType(output_dtype);
+    output_desc.SetFormat(planar ? FORMAT_NCHW : FORMAT_NHWC);
+    output_desc.SetOriginFormat(planar ? FORMAT_NCHW : FORMAT_NHWC);
+    if (face_capacity == UNKNOWN_DIM) {
+        output_desc.SetShapeRange(output_range);
+    }
+    if (op.UpdateOutputDesc("aligned_image", output_desc) != GRAPH_SUCCESS) {
+        return GRAPH_FAILED;
+    }
+
+    TensorDesc valid_num_desc = op.GetOutputDesc("valid_num");
+    valid_num_desc.SetShape(Shape({1}));
+    valid_num_desc.SetOriginShape(Shape({1}));
+    valid_num_desc.SetDataType(DT_INT32);
+    return op.UpdateOutputDesc("valid_num", valid_num_desc);
 }
 
 IMPLEMT_VERIFIER(FaceAlign, FaceAlignVerify)
 {
+    std::vector<int64_t> face_size;
+    if (!GetFaceSize(op, face_size)) {
+        return GRAPH_FAILED;
+    }
+    std::vector<int64_t> default_keypoint;
+    if (op.GetAttr("default_keypoint", default_keypoint) != GRAPH_SUCCESS ||
+        default_keypoint.size() != static_cast<size_t>(kKeypointValues)) {
+        OP_LOGE(op.GetName().c_str(), "default_keypoint must hold %ld ints.", kKeypointValues);
+        return GRAPH_FAILED;
+    }
+    //unknown rank is checked again by the kernel at run time
+    std::vector<int64_t> image_dims = op.GetInputDesc("image").GetShape().GetDims();
+    bool image_unknown_rank = image_dims.size() == 1 && image_dims[0] == UNKNOWN_DIM_NUM;
+    if (!image_unknown_rank && image_dims.size() != kImageRank) {
+        OP_LOGE(op.GetName().c_str(), "image must be NHWC, got rank %zu.", image_dims.size());
+        return GRAPH_FAILED;
+    }
+    std::string input_format = kInputBgr;
+    op.GetAttr("input_format", input_format);
+    if (input_format != kInputBgr && input_format != kInputNv12) {
+        OP_LOGE(op.GetName().c_str(), "input_format must be BGR888_U8 or YUV420SP_U8.");
+        return GRAPH_FAILED;
+    }
+    //NV12 images are [N, H * 3 / 2, W, 1]
+    int64_t image_channels = (input_format == kInputNv12) ? 1 : kFaceChannels;
+    if (!image_unknown_rank && image_dims[3] != UNKNOWN_DIM && image_dims[3] != image_channels) {
+        OP_LOGE(op.GetName().c_str(), "image must have %ld channels.", image_channels);
+        return GRAPH_FAILED;
+    }
+    DataType output_dtype = DT_UINT8;
+    op.GetAttr("output_dtype", output_dtype);
+    if (output_dtype != DT_UINT8 && output_dtype != DT_FLOAT16 && output_dtype != DT_FLOAT) {
+        OP_LOGE(op.GetName().c_str(), "output_dtype must be uint8, float16 or float32.");
+        return GRAPH_FAILED;
+    }
+    std::string output_format = "NHWC";
+    op.GetAttr("output_format", output_format);
+    if (output_format != "NHWC" && output_format != kFormatNchw) {
+        OP_LOGE(op.GetName().c_str(), "output_format must be NHWC or NCHW.");
+        return GRAPH_FAILED;
+    }
+    std::vector<float> mean(kFaceChannels, 0.0f);
+    std::vector<float> std(kFaceChannels, 1.0f);
+    op.GetAttr("mean", mean);
+    op.GetAttr("std", std);
+    if (mean.size() != static_cast<size_t>(kFaceChannels) || std.size() != static_cast<size_t>(kFaceChannels) ||
+        std[0] == 0.0f || std[1] == 0.0f || std[2] == 0.0f) {
+        OP_LOGE(op.GetName().c_str(), "mean and std must hold %ld floats, std nonzero.", kFaceChannels);
+        return GRAPH_FAILED;
+    }
+    std::vector<int64_t> keypoints_dims = op.GetInputDesc("keypoints").GetShape().GetDims();
+    if (keypoints_dims.size() == kKeypointRank && keypoints_dims[1] != UNKNOWN_DIM &&
+        keypoints_dims[1] != kKeypointValues) {
+        OP_LOGE(op.GetName().c_str(), "keypoints must be [N, %ld].", kKeypointValues);
+        return GRAPH_FAILED;
+    }
     return GRAPH_SUCCESS;
 }
 
@@ -21,13 +21,56 @@
 #include "graph/operator_reg.h"
 namespace ge {
 
+/**
+*@brief Warps every face of an image onto a fixed keypoint template.
+
+*@par Inputs:
+*@li image: An NHWC tensor of type uint8, a batch of BGR888 images, or of
+* shape [N, H * 3 / 2, W, 1] holding NV12 images for YUV420SP_U8 input. \n
+*@li keypoints: A float tensor of shape [N, 10], five (x, y) landmarks per face. \n
+*@li face_num: An int32 tensor holding the number of valid faces in keypoints,
+* clamped to the faces keypoints and aligned_image can hold. \n
+*@li box_index: An optional int32 tensor of shape [N], the image in the batch
+* each face is cut from. All faces come from image 0 when it is absent. \n
+
+*@par Attributes:
+*face_size: A required list of two ints, width and height of the output faces. \n
+*default_keypoint: A required list of ten ints, the template landmarks. \n
+*transform_type: An optional string, "similarity" (default) or "affine" for a
+* closed-form least-squares fit, "ransac" for an affine fit that drops
+* outlier keypoints. \n
+*output_dtype: An optional type, uint8 (default), float16 or float32. \n
+*mean: An optional list of three floats subtracted per channel, float outputs only. \n
+*std: An optional list of three floats dividing per channel, float outputs only. \n
+*output_format: An optional string, "NHWC" (default) or "NCHW". \n
+*input_format: An optional string, "BGR888_U8" (default) or "YUV420SP_U8".
+* NV12 is converted to BGR only at the warped output pixels. \n
+*zero_unused: An optional bool, zero the output slots past valid_num when true,
+* leave them untouched when false (default). \n
+
+*@par Outputs:
+*aligned_image: [N, face_size[1], face_size[0], 3] for NHWC or
+* [N, 3, face_size[1], face_size[0]] for NCHW, of type output_dtype. Float
+* outputs hold (pixel - mean) / std.
+*valid_num: An int32 tensor of shape [1], the number of faces aligned. The
+* kernel always writes it and rejects a node built without it. \n
+*/
 REG_OP(FaceAlign)
     .INPUT(image, TensorType({DT_UINT8}))
     .INPUT(keypoints, TensorType({DT_FLOAT32}))
     .INPUT(face_num, TensorType({DT_INT32}))
-    .OUTPUT(aligned_image, TensorType({DT_UINT8}))
+    .OPTIONAL_INPUT(box_index, TensorType({DT_INT32}))
+    .OUTPUT(aligned_image, TensorType({DT_UINT8, DT_FLOAT16, DT_FLOAT}))
+    .OUTPUT(valid_num, TensorType({DT_INT32}))
     .REQUIRED_ATTR(face_size, ListInt)
     .REQUIRED_ATTR(default_keypoint, ListInt)
+    .ATTR(transform_type, String, "similarity")
+    .ATTR(output_dtype, Type, DT_UINT8)
+    .ATTR(mean, ListFloat, {0.0f, 0.0f, 0.0f})
+    .ATTR(std, ListFloat, {1.0f, 1.0f, 1.0f})
+    .ATTR(output_format, String, "NHWC")
+    .ATTR(input_format, String, "BGR888_U8")
+    .ATTR(zero_unused, Bool, false)
     .OP_END_FACTORY_REG(FaceAlign)
 }
 #endif //GE_OP_FACE_ALIGN_H
@@ -0,0 +1,504 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "aicpu_task_struct.h"
+#include "cce/fwk_adpt_struct.h"
+#include "cpu_context.h"
+#include "cpu_kernel.h"
+#include "cpu_kernel_register.h"
+#include "cpu_kernel_utils.h"
+#include "node_def_builder.h"
+
+using namespace std;
+using namespace aicpu;
+
+namespace {
+// heap allocations of the whole process, counted between two reads
+std::atomic<int64_t> g_alloc_num(0);
+
+void *CountedAlloc(size_t size) {
+  g_alloc_num++;
+  return malloc(size == 0 ? 1 : size);
+}
+}  // namespace
+
+void *operator new(size_t size) {
+  void *ptr = CountedAlloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return CountedAlloc(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return CountedAlloc(size);
+}
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+class TEST_CONTEXT_ARENA_UT : public testing::Test {};
+
+namespace {
+const int kLaunchNum = 1000;
+
+// the serialized node def a launch carries
+std::string SerializedNodeDef() {
+  std::vector<int64_t> image_shape = {1, 720, 1280, 3};
+  std::vector<int64_t> keypoints_shape = {1, 4, 10};
+  std::vector<int64_t> output_shape = {4, 112, 112, 3};
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")
+      .Input({"image", DT_UINT8, image_shape, nullptr})
+      .Input({"keypoints", DT_FLOAT, keypoints_shape, nullptr})
+      .Output({"aligned_image", DT_UINT8, output_shape, nullptr})
+      .Attr("face_size", vector<int64_t>({112, 112}))
+      .Attr("zero_unused", true);
+  std::string str;
+  EXPECT_TRUE(node_def->SerializeToString(str));
+  return str;
+}
+
+// what every launch does to the tensors of a cached context
+int64_t Launch(CpuKernelContext &ctx) {
+  int64_t total = 0;
+  for (uint32_t i = 0; i < ctx.GetInputsSize(); ++i) {
+    Tensor *input = ctx.Input(i);
+    input->SetData(&total);
+    input->SetDataSize(input->CalcDataSizeByShape());
+    auto shape = input->GetTensorShape();
+    total += shape->GetDimSize(shape->GetDims() - 1) + input->NumElements();
+  }
+  for (uint32_t i = 0; i < ctx.GetOutputsSize(); ++i) {
+    Tensor *output = ctx.Output(i);
+    output->SetData(&total);
+    output->SetDataSize(output->CalcDataSizeByShape());
+    total += output->GetTensorShape()->NumElements();
+  }
+  return total;
+}
+}  // namespace
+
+TEST_F(TEST_CONTEXT_ARENA_UT, STEADY_STATE_LAUNCH_NO_ALLOC) {
+  std::string str = SerializedNodeDef();
+  auto node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_NE(node_def, nullptr);
+  ASSERT_TRUE(node_def->ParseFromString(str));
+  CpuKernelContext ctx(DEVICE);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+  int64_t expected = Launch(ctx);
+
+  int64_t start = g_alloc_num.load();
+  int64_t wrong = 0;
+  for (int i = 0; i < kLaunchNum; ++i) {
+    wrong += (Launch(ctx) != expected) ? 1 : 0;
+  }
+  EXPECT_EQ(g_alloc_num.load() - start, 0);
+  EXPECT_EQ(wrong, 0);
+}
+
+TEST_F(TEST_CONTEXT_ARENA_UT, ARENA_CONTEXT_MATCHES_HEAP) {
+  std::string str = SerializedNodeDef();
+  int64_t start = g_alloc_num.load();
+  auto heap_node_def = CpuKernelUtils::CreateNodeDef();
+  ASSERT_TRUE(heap_node_def->ParseFromString(str));
+  CpuKernelContext heap_ctx(DEVICE);
+  ASSERT_EQ(heap_ctx.Init(heap_node_def.get()), 0);
+  int64_t heap_alloc_num = g_alloc_num.load() - start;
+
+  start = g_alloc_num.load();
+  auto arena_node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_TRUE(arena_node_def->ParseFromString(str));
+  CpuKernelContext arena_ctx(DEVICE);
+  ASSERT_EQ(arena_ctx.Init(arena_node_def.get()), 0);
+  int64_t arena_alloc_num = g_alloc_num.load() - start;
+  cout << "context init allocations: heap node def " << heap_alloc_num
+       << ", arena node def " << arena_alloc_num << endl;
+  EXPECT_LT(arena_alloc_num, heap_alloc_num);
+
+  ASSERT_EQ(arena_ctx.GetInputsSize(), heap_ctx.GetInputsSize());
+  for (uint32_t i = 0; i < heap_ctx.GetInputsSize(); ++i) {
+    EXPECT_EQ(arena_ctx.Input(i)->GetDataType(),
+              heap_ctx.Input(i)->GetDataType());
+    EXPECT_EQ(arena_ctx.Input(i)->GetTensorShape()->GetDimSizes(),
+              heap_ctx.Input(i)->GetTensorShape()->GetDimSizes());
+  }
+  EXPECT_EQ(arena_ctx.Output(0)->NumElements(), 4 * 112 * 112 * 3);
+  ASSERT_NE(arena_ctx.GetAttr("face_size"), nullptr);
+  EXPECT_EQ(arena_ctx.GetAttr("face_size")->GetListInt(),
+            vector<int64_t>({112, 112}));
+  ASSERT_NE(arena_ctx.GetAttr("zero_unused"), nullptr);
+  EXPECT_TRUE(arena_ctx.GetAttr("zero_unused")->GetBool());
+}
+
+// the shape view is built once and follows every later change of the shape
+TEST_F(TEST_CONTEXT_ARENA_UT, SHAPE_VIEW_TRACKS_CHANGES) {
+  std::string str = SerializedNodeDef();
+  auto node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_TRUE(node_def->ParseFromString(str));
+  CpuKernelContext ctx(DEVICE);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+  Tensor *output = ctx.Output(0);
+  auto shape = output->GetTensorShape();
+  EXPECT_EQ(shape.get(), output->GetTensorShape().get());
+
+  shape->SetDimSizes({2, 112, 112, 3});
+  EXPECT_EQ(output->NumElements(), 2 * 112 * 112 * 3);
+
+  auto new_shape = CpuKernelUtils::CreateTensorShape();
+  new_shape->SetDimSizes({1, 56, 56, 3});
+  ASSERT_TRUE(output->SetTensorShape(new_shape.get()));
+  EXPECT_EQ(shape->GetDimSize(1), 56);
+  EXPECT_EQ(output->CalcDataSizeByShape(), 56 * 56 * 3);
+}
+
+
+TEST_F(TEST_CONTEXT_ARENA_UT, ATTR_BY_INDEX) {
+  std::string str = SerializedNodeDef();
+  auto node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_TRUE(node_def->ParseFromString(str));
+  CpuKernelContext ctx(DEVICE);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+
+  int32_t face_size = CpuKernelUtils::GetAttrIndex(ctx, "face_size");
+  int32_t zero_unused = CpuKernelUtils::GetAttrIndex(ctx, "zero_unused");
+  ASSERT_GE(face_size, 0);
+  ASSERT_GE(zero_unused, 0);
+  EXPECT_NE(face_size, zero_unused);
+  EXPECT_EQ(CpuKernelUtils::GetAttrIndex(ctx, "no_such_attr"), -1);
+  EXPECT_EQ(CpuKernelUtils::GetAttrIndex(ctx, "a"), -1);
+  EXPECT_EQ(CpuKernelUtils::GetAttrIndex(ctx, "zz"), -1);
+  EXPECT_EQ(CpuKernelUtils::GetAttrByIndex(ctx, 2), nullptr);
+  EXPECT_EQ(CpuKernelUtils::GetAttrByIndex(ctx, -1), nullptr);
+  EXPECT_EQ(CpuKernelUtils::GetAttr(ctx, "no_such_attr"), nullptr);
+  EXPECT_EQ(CpuKernelUtils::GetAttrByIndex(ctx, face_size),
+            ctx.GetAttr("face_size"));
+  EXPECT_EQ(CpuKernelUtils::GetAttr(ctx, "zero_unused"),
+            ctx.GetAttr("zero_unused"));
+
+  int64_t start = g_alloc_num.load();
+  int64_t wrong = 0;
+  for (int i = 0; i < kLaunchNum; ++i) {
+    wrong += CpuKernelUtils::GetAttrByIndex(ctx, zero_unused)->GetBool() ? 0 : 1;
+    wrong += CpuKernelUtils::GetAttr(ctx, "face_size") == nullptr ? 1 : 0;
+  }
+  EXPECT_EQ(g_alloc_num.load() - start, 0);
+  EXPECT_EQ(wrong, 0);
+}
+
+namespace {
+std::atomic<int> g_state_creations(0);
+
+std::shared_ptr<const void> CreateFaceSizeState(const CpuKernelContext &ctx) {
+  g_state_creations++;
+  AttrValue *face_size = CpuKernelUtils::GetAttr(ctx, "face_size");
+  if (face_size == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<std::vector<int64_t>>(face_size->GetListInt());
+}
+
+std::shared_ptr<const void> CreateNoState(const CpuKernelContext &ctx) {
+  g_state_creations++;
+  return nullptr;
+}
+}  // namespace
+
+// concurrent launches of a context share one state, created once
+TEST_F(TEST_CONTEXT_ARENA_UT, KERNEL_STATE_CREATED_ONCE) {
+  std::string str = SerializedNodeDef();
+  auto node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_TRUE(node_def->ParseFromString(str));
+  CpuKernelContext ctx(DEVICE);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+
+  g_state_creations = 0;
+  std::atomic<int64_t> wrong(0);
+  const void *first = CpuKernelUtils::GetKernelState(ctx, CreateFaceSizeState);
+  ASSERT_NE(first, nullptr);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&ctx, &wrong, first]() {
+      for (int i = 0; i < kLaunchNum; ++i) {
+        const void *state =
+            CpuKernelUtils::GetKernelState(ctx, CreateFaceSizeState);
+        wrong += (state != first) ? 1 : 0;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(wrong.load(), 0);
+  EXPECT_EQ(g_state_creations.load(), 1);
+  EXPECT_EQ(*static_cast<const std::vector<int64_t> *>(first),
+            vector<int64_t>({112, 112}));
+
+  // a failed creation is not retried, the attrs of a context never change
+  auto failed_node_def = CpuKernelUtils::CreateArenaNodeDef();
+  ASSERT_TRUE(failed_node_def->ParseFromString(str));
+  CpuKernelContext failed_ctx(DEVICE);
+  ASSERT_EQ(failed_ctx.Init(failed_node_def.get()), 0);
+  g_state_creations = 0;
+  EXPECT_EQ(CpuKernelUtils::GetKernelState(failed_ctx, CreateNoState), nullptr);
+  EXPECT_EQ(CpuKernelUtils::GetKernelState(failed_ctx, CreateNoState), nullptr);
+  EXPECT_EQ(g_state_creations.load(), 1);
+}
+
+extern "C" uint32_t RunCpuKernel(void *param);
+
+namespace {
+// output dims written by ExtProbe: the input dims with the last one doubled
+class ExtProbeKernel : public CpuKernel {
+ public:
+  uint32_t Compute(CpuKernelContext &ctx) override {
+    auto input_shape = ctx.Input(0)->GetTensorShape();
+    dims_.clear();
+    for (int32_t i = 0; i < input_shape->GetDims(); ++i) {
+      dims_.push_back(input_shape->GetDimSize(i));
+    }
+    dims_.back() *= 2;
+    input_data = ctx.Input(0)->GetData();
+    output_data = ctx.Output(0)->GetData();
+    ctx.Output(0)->GetTensorShape()->SetDimSizes(dims_);
+    return 0;
+  }
+
+  void *input_data = nullptr;
+  void *output_data = nullptr;
+
+ private:
+  std::vector<int64_t> dims_ = std::vector<int64_t>(FWKAdapter::kMaxShapeDims);
+};
+
+std::atomic<int64_t> g_probe_creations(0);
+
+std::shared_ptr<ExtProbeKernel> ProbeKernel() {
+  static std::shared_ptr<ExtProbeKernel> kernel = [] {
+    auto probe = std::make_shared<ExtProbeKernel>();
+    RegistCpuKernel("ExtProbe", [probe]() -> std::shared_ptr<CpuKernel> {
+      g_probe_creations++;
+      return probe;
+    });
+    return probe;
+  }();
+  return kernel;
+}
+
+// the task arguments of an unknown shape ExtProbe launch without session info,
+// with a bitmap entry the framework can switch it to known shape per launch
+class ProbeTask {
+ public:
+  explicit ProbeTask(const std::vector<int64_t> &dims = {-1, -1},
+                     bool with_bitmap = false) {
+    auto node_def = NodeDefBuilder::CreateNodeDef();
+    NodeDefBuilder(node_def.get(), "ExtProbe", "ExtProbe")
+        .Input({"x", DT_FLOAT, dims, nullptr})
+        .Output({"y", DT_FLOAT, dims, nullptr});
+    std::string str;
+    EXPECT_TRUE(node_def->SerializeToString(str));
+
+    AppendExtInfo(FWKAdapter::FWK_ADPT_EXT_SHAPE_TYPE, sizeof(int32_t));
+    if (with_bitmap) {
+      bitmap_offset_ =
+          AppendExtInfo(FWKAdapter::FWK_ADPT_EXT_BITMAP, sizeof(int64_t));
+    }
+    input_shape_offset_ =
+        AppendExtInfo(FWKAdapter::FWK_ADPT_EXT_INPUT_SHAPE,
+                      sizeof(FWKAdapter::ShapeAndType));
+    output_shape_offset_ =
+        AppendExtInfo(FWKAdapter::FWK_ADPT_EXT_OUTPUT_SHAPE,
+                      sizeof(FWKAdapter::ShapeAndType));
+
+    uint32_t nodedef_len = str.size();
+    param_.resize(sizeof(AicpuParamHead) + kIoNum * sizeof(uint64_t) +
+                  sizeof(uint32_t) + nodedef_len);
+    auto head = reinterpret_cast<AicpuParamHead *>(param_.data());
+    head->length = param_.size();
+    head->ioAddrNum = kIoNum;
+    head->extInfoLength = ext_info_.size();
+    head->extInfoAddr = reinterpret_cast<uintptr_t>(ext_info_.data());
+    memcpy(&param_[sizeof(AicpuParamHead) + kIoNum * sizeof(uint64_t)],
+           &nodedef_len, sizeof(nodedef_len));
+    memcpy(&param_[param_.size() - nodedef_len], str.data(), nodedef_len);
+  }
+
+  // what the framework rewrites before every launch
+  void SetLaunch(int64_t rows, int64_t cols, void *input, void *output) {
+    uint64_t addrs[kIoNum] = {reinterpret_cast<uintptr_t>(input),
+                              reinterpret_cast<uintptr_t>(output)};
+    memcpy(&param_[sizeof(AicpuParamHead)], addrs, sizeof(addrs));
+    FWKAdapter::ShapeAndType *shape = InputShape();
+    shape->dims[0] = rows;
+    shape->dims[1] = cols;
+    shape->dims[2] = LLONG_MIN;
+  }
+
+  // bit 0 set means known shape
+  void SetBitmap(uint64_t bit_map) {
+    memcpy(&ext_info_[bitmap_offset_], &bit_map, sizeof(bit_map));
+  }
+
+  FWKAdapter::ShapeAndType *InputShape() { return ShapeAt(input_shape_offset_); }
+  FWKAdapter::ShapeAndType *OutputShape() {
+    return ShapeAt(output_shape_offset_);
+  }
+  void *Param() { return param_.data(); }
+  std::vector<char> &ExtInfo() { return ext_info_; }
+
+ private:
+  static const uint32_t kIoNum = 2;
+
+  // append a zeroed entry, returns the offset of its message
+  size_t AppendExtInfo(int32_t type, uint32_t len) {
+    size_t offset = ext_info_.size();
+    ext_info_.resize(offset + FWKAdapter::kExtInfoHeadSize + len);
+    memcpy(&ext_info_[offset], &type, sizeof(type));
+    memcpy(&ext_info_[offset + sizeof(type)], &len, sizeof(len));
+    return offset + FWKAdapter::kExtInfoHeadSize;
+  }
+
+  FWKAdapter::ShapeAndType *ShapeAt(size_t offset) {
+    return reinterpret_cast<FWKAdapter::ShapeAndType *>(&ext_info_[offset]);
+  }
+
+  std::vector<char> param_;
+  std::vector<char> ext_info_;
+  size_t input_shape_offset_ = 0;
+  size_t output_shape_offset_ = 0;
+  size_t bitmap_offset_ = 0;
+};
+}  // namespace
+
+// the extend info layout is parsed once, every launch still sees its own values
+TEST_F(TEST_CONTEXT_ARENA_UT, EXT_INFO_PLAN_READS_NEW_VALUES) {
+  auto kernel = ProbeKernel();
+  ProbeTask task;
+  float input = 0;
+  float output = 0;
+  task.SetLaunch(2, 3, &input, &output);
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.OutputShape()->dims[1], 6);
+
+  int64_t start = g_alloc_num.load();
+  int64_t wrong = 0;
+  for (int i = 1; i <= kLaunchNum; ++i) {
+    float *io = (i % 2 == 0) ? &input : &output;
+    task.SetLaunch(i, i % 7 + 1, io, io + 1);
+    wrong += (RunCpuKernel(task.Param()) != 0) ? 1 : 0;
+    wrong += (task.OutputShape()->dims[0] != i) ? 1 : 0;
+    wrong += (task.OutputShape()->dims[1] != (i % 7 + 1) * 2) ? 1 : 0;
+    wrong += (kernel->input_data != io || kernel->output_data != io + 1) ? 1 : 0;
+  }
+  EXPECT_EQ(g_alloc_num.load() - start, 0);
+  EXPECT_EQ(wrong, 0);
+}
+
+// a buffer at the same address with other entries is parsed again
+TEST_F(TEST_CONTEXT_ARENA_UT, EXT_INFO_PLAN_FOLLOWS_LAYOUT) {
+  auto kernel = ProbeKernel();
+  ProbeTask task;
+  float data[2] = {0, 0};
+  task.SetLaunch(4, 5, &data[0], &data[1]);
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.OutputShape()->dims[1], 10);
+
+  // swap the input and output entries, the input shape is then read from
+  // the second one and the output shape written to the first one
+  auto input_head = reinterpret_cast<char *>(task.InputShape()) -
+                    FWKAdapter::kExtInfoHeadSize;
+  auto output_head = reinterpret_cast<char *>(task.OutputShape()) -
+                     FWKAdapter::kExtInfoHeadSize;
+  int32_t input_type = FWKAdapter::FWK_ADPT_EXT_INPUT_SHAPE;
+  int32_t output_type = FWKAdapter::FWK_ADPT_EXT_OUTPUT_SHAPE;
+  memcpy(input_head, &output_type, sizeof(output_type));
+  memcpy(output_head, &input_type, sizeof(input_type));
+  task.SetLaunch(6, 7, &data[0], &data[1]);
+  *task.OutputShape() = *task.InputShape();
+  task.OutputShape()->dims[1] = 8;
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.InputShape()->dims[0], 6);
+  EXPECT_EQ(task.InputShape()->dims[1], 16);
+}
+
+// the bitmap is rewritten in place between launches, the plan must not keep
+// the shape kind of the launch it was parsed on
+TEST_F(TEST_CONTEXT_ARENA_UT, EXT_INFO_PLAN_FOLLOWS_BITMAP) {
+  auto kernel = ProbeKernel();
+  ProbeTask task({2, 3}, true);
+  float data[2] = {0, 0};
+  task.SetBitmap(1);
+  task.SetLaunch(4, 5, &data[0], &data[1]);
+  task.OutputShape()->dims[1] = 0;
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.OutputShape()->dims[1], 0);
+
+  // planned on a known shape launch, the shape entries are still used
+  task.SetBitmap(0);
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.OutputShape()->dims[0], 4);
+  EXPECT_EQ(task.OutputShape()->dims[1], 10);
+
+  task.SetBitmap(1);
+  task.SetLaunch(6, 7, &data[0], &data[1]);
+  task.OutputShape()->dims[1] = 0;
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  EXPECT_EQ(task.OutputShape()->dims[1], 0);
+}
+
+// a cached context runs the kernel it got on its first launch
+TEST_F(TEST_CONTEXT_ARENA_UT, KERNEL_CREATED_ONCE_PER_CONTEXT) {
+  auto kernel = ProbeKernel();
+  ProbeTask task;
+  float data[2] = {0, 0};
+  task.SetLaunch(3, 4, &data[0], &data[1]);
+  ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+
+  int64_t creations = g_probe_creations.load();
+  for (int i = 0; i < kLaunchNum; ++i) {
+    ASSERT_EQ(RunCpuKernel(task.Param()), 0);
+  }
+  EXPECT_EQ(g_probe_creations.load(), creations);
+}
+
+// kernels registered while others are looked up, as a kernel library loaded
+// late does
+TEST_F(TEST_CONTEXT_ARENA_UT, REGISTER_WHILE_LOOKING_UP) {
+  ProbeKernel();
+  const int kTypeNum = 200;
+  std::atomic<bool> done(false);
+  std::atomic<int64_t> wrong(0);
+  std::thread reader([&done, &wrong]() {
+    while (!done.load()) {
+      wrong += CpuKernelRegister::Instance().GetCpuKernel("ExtProbe") == nullptr ? 1 : 0;
+    }
+  });
+  for (int i = 0; i < kTypeNum; ++i) {
+    std::string type = "LateProbe" + std::to_string(i);
+    RegistCpuKernel(type, []() -> std::shared_ptr<CpuKernel> {
+      return std::make_shared<ExtProbeKernel>();
+    });
+    wrong += CpuKernelRegister::Instance().GetCpuKernel(type) == nullptr ? 1 : 0;
+  }
+  done = true;
+  reader.join();
+  EXPECT_EQ(wrong.load(), 0);
+  EXPECT_EQ(CpuKernelRegister::Instance().GetCpuKernel("LateProbe"), nullptr);
+
+  int64_t start = g_alloc_num.load();
+  for (int i = 0; i < kLaunchNum; ++i) {
+    wrong += CpuKernelRegister::Instance().GetCpuKernel("ExtProbe") == nullptr ? 1 : 0;
+  }
+  EXPECT_EQ(g_alloc_num.load() - start, 0);
+  EXPECT_EQ(wrong.load(), 0);
+}
@@ -0,0 +1,81 @@
+# Test setup of the UTs built on this tree's context library (context_host.cmake):
+# gtest, the SDK paths and add_context_ut() for the directories of the UTs that
+# test the context itself (kernel cache, arena, sharders, metrics, trace). The
+# face_align UT includes it for the library and builds its own targets.
+#
+# PROJECT_PATH has to be set before the include.
+
+if ("${ASCEND_CUSTOM_PATH}" STREQUAL "")
+    message(WARNING "ASCEND_CUSTOM_PATH was not set, use env var ASCEND_AICPU_PATH instead.")
+    if ("$ENV{ASCEND_AICPU_PATH}" STREQUAL "")
+        message(FATAL_ERROR "ASCEND_AICPU_PATH was not set, compile failed.")
+        return()
+    endif()
+    set(ASCEND_CUSTOM_PATH $ENV{ASCEND_AICPU_PATH})
+endif()
+
+add_definitions(-D_GLIBCXX_USE_CXX11_ABI=0)
+set(CMAKE_CXX_STANDARD 11)
+set(AICPU_OPP_ENV ${ASCEND_CUSTOM_PATH}/opp/op_impl/built-in/aicpu/aicpu_kernel)
+
+add_library(gtest SHARED IMPORTED)
+set_target_properties(gtest PROPERTIES IMPORTED_LOCATION ${PROJECT_PATH}/testcases/libs/gtest/libgtest.a)
+
+add_library(gtest_main SHARED IMPORTED)
+set_target_properties(gtest_main PROPERTIES IMPORTED_LOCATION ${PROJECT_PATH}/testcases/libs/gtest/libgtest_main.a)
+
+set(GTEST_INCLUDE ${PROJECT_PATH}/testcases/libs/gtest/include)
+
+link_directories(${AICPU_OPP_ENV}/lib/aarch64
+                 ${AICPU_OPP_ENV}/lib/x86
+                 ${ASCEND_CUSTOM_PATH}/compiler/lib64)
+
+include(${PROJECT_PATH}/cpukernel/context/context_host.cmake)
+
+target_compile_options(cpu_kernels_context_host PRIVATE
+  -g
+  -O0
+  $<$<STREQUAL:${ENABLE_ASAN},true>:-fsanitize=address -fno-omit-frame-pointer>
+)
+
+# add_context_ut(<name>): builds the *_impl.cc/cpp tests of the calling directory
+# into aicpu_<name>_ut, written to out/bin/aicpu_<name>_ut_test
+function(add_context_ut name)
+  file(GLOB _test_files
+    ${CMAKE_CURRENT_SOURCE_DIR}/**_impl.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/**_impl.cc
+  )
+
+  add_executable(cpu_kernels_llt
+    ${_test_files}
+  )
+
+  target_include_directories(cpu_kernels_llt PRIVATE
+    ${GTEST_INCLUDE}
+    ${CONTEXT_HOST_INCLUDE}
+  )
+
+  target_link_libraries(cpu_kernels_llt
+    gtest
+    gtest_main
+    gcov
+    pthread
+    cpu_kernels_context_host
+    alog
+    -ldl
+  )
+
+  target_compile_options(cpu_kernels_llt PUBLIC
+    -g
+    -O0
+    --coverage
+    -fprofile-arcs
+    -ftest-coverage
+    -w
+    $<$<COMPILE_LANGUAGE:CXX>:-std=c++11>
+    $<$<STREQUAL:${ENABLE_ASAN},true>:-fsanitize=address -fno-omit-frame-pointer -static-libasan -fsanitize=undefined -static-libubsan>
+    -fPIC
+  )
+  set_target_properties(cpu_kernels_llt PROPERTIES OUTPUT_NAME "aicpu_${name}_ut"
+                        RUNTIME_OUTPUT_DIRECTORY "${PROJECT_PATH}/out/bin/aicpu_${name}_ut_test")
+endfunction()
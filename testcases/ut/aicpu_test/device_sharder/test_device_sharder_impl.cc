@@ -0,0 +1,82 @@
+#include <dlfcn.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cpu_context.h"
+#include "cpu_kernel_utils.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_DEVICE_SHARDER_UT : public testing::Test {};
+
+namespace {
+const char *kSharderPath = "/usr/lib64/libaicpu_sharder.so";
+const int kContextNum = 10000;
+
+double ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start).count();
+}
+
+// what every context paid before the sharder functions were shared
+void OpenSharderPerContext() {
+  void *sharder = dlopen(kSharderPath, RTLD_LAZY | RTLD_GLOBAL);
+  if (sharder != nullptr) {
+    (void)dlsym(sharder, "ParallelFor");
+    (void)dlsym(sharder, "GetCPUNum");
+    (void)dlclose(sharder);
+  }
+}
+}  // namespace
+
+// contexts built concurrently all reach the same sharder
+TEST_F(TEST_DEVICE_SHARDER_UT, CONTEXTS_SHARE_SHARDER) {
+  uint32_t cpu_num = CpuKernelUtils::GetCPUNum(CpuKernelContext(DEVICE));
+  std::atomic<int64_t> wrong(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&wrong, cpu_num]() {
+      for (int i = 0; i < 1000; ++i) {
+        CpuKernelContext ctx(DEVICE);
+        std::atomic<int64_t> done(0);
+        uint32_t ret = CpuKernelUtils::ParallelFor(
+            ctx, 100, 1, [&done](int64_t start, int64_t end) {
+              done += end - start;
+            });
+        if (ret != 0 || done.load() != 100 ||
+            CpuKernelUtils::GetCPUNum(ctx) != cpu_num) {
+          wrong++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(wrong.load(), 0);
+}
+
+// startup latency: the first context resolves the sharder, later ones reuse it
+TEST_F(TEST_DEVICE_SHARDER_UT, BENCHMARK_CONTEXT_STARTUP) {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<CpuKernelContext> first(new CpuKernelContext(DEVICE));
+  double first_ns = ElapsedNs(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kContextNum; ++i) {
+    CpuKernelContext ctx(DEVICE);
+  }
+  double context_ns = ElapsedNs(start) / kContextNum;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kContextNum; ++i) {
+    OpenSharderPerContext();
+  }
+  double dlopen_ns = ElapsedNs(start) / kContextNum;
+  cout << "first context " << first_ns << " ns, next contexts " << context_ns
+       << " ns/context, dlopen per context " << dlopen_ns << " ns" << endl;
+}
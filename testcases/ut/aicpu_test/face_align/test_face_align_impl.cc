@@ -0,0 +1,942 @@
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <random>
+#include "gtest/gtest.h"
+#include "opencv2/opencv.hpp"
+#include "Eigen/Core"
+#ifndef private
+#define private public
+#define protected public
+#endif
+#include "cpu_kernel_utils.h"
+#include "node_def_builder.h"
+#undef private
+#undef protected
+#include "face_align_kernels.h"
+#include "face_transform.h"
+#include "face_warp.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_FACE_ALIGN_UT : public testing::Test {};
+
+class FaceAlignCpuKernelTest : FaceAlignCpuKernel {
+  public :
+  using FaceAlignCpuKernel::Compute;
+};
+
+namespace {
+const int64_t kImageH = 720;
+const int64_t kImageW = 1280;
+const int64_t kFaceW = 112;
+const int64_t kFaceH = 112;
+const vector<int64_t> kDefaultKeypoint = {40, 45, 72, 45, 52, 65, 42, 82, 72, 82};
+
+// counts Mat buffers of one face crop, all other requests go to the std allocator
+class CropCountingAllocator : public cv::MatAllocator {
+ public:
+  CropCountingAllocator(int64_t crop_h = kFaceH, int64_t crop_w = kFaceW)
+      : crop_h_(crop_h), crop_w_(crop_w) {}
+
+  cv::UMatData *allocate(int dims, const int *sizes, int type, void *data,
+                         size_t *step, cv::AccessFlag flags,
+                         cv::UMatUsageFlags usageFlags) const override {
+    if (dims == 2 && sizes[0] == crop_h_ && sizes[1] == crop_w_) {
+      crop_allocs++;
+    }
+    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step,
+                                                flags, usageFlags);
+  }
+
+  bool allocate(cv::UMatData *data, cv::AccessFlag accessflags,
+                cv::UMatUsageFlags usageFlags) const override {
+    return cv::Mat::getStdAllocator()->allocate(data, accessflags, usageFlags);
+  }
+
+  void deallocate(cv::UMatData *data) const override {
+    cv::Mat::getStdAllocator()->deallocate(data);
+  }
+
+  mutable std::atomic<int64_t> crop_allocs{0};
+
+ private:
+  int64_t crop_h_;
+  int64_t crop_w_;
+};
+}
+
+// sum of squared distances between M * points and the template
+double TemplateResidual(const double matrix[6], const float *points) {
+  double residual = 0.0;
+  for (int k = 0; k < 5; ++k) {
+    double x = matrix[0] * points[k * 2] + matrix[1] * points[k * 2 + 1] + matrix[2];
+    double y = matrix[3] * points[k * 2] + matrix[4] * points[k * 2 + 1] + matrix[5];
+    double dx = x - kDefaultKeypoint[k * 2];
+    double dy = y - kDefaultKeypoint[k * 2 + 1];
+    residual += dx * dx + dy * dy;
+  }
+  return residual;
+}
+
+#define CREATE_NODEDEF(shapes, data_types, datas)                  \
+  int32_t node_valid_num = -1;                                     \
+  auto node_def = NodeDefBuilder::CreateNodeDef();                 \
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")         \
+      .Input({"image", data_types[0], shapes[0], datas[0]})        \
+      .Input({"keypoints", data_types[1], shapes[1], datas[1]})    \
+      .Input({"face_num", data_types[2], shapes[2], datas[2]})     \
+      .Output({"aligned_image", data_types[3], shapes[3], datas[3]}) \
+      .Output({"valid_num", DT_INT32, {1}, &node_valid_num})       \
+      .Attr("face_size", vector<int64_t>({kFaceW, kFaceH}))        \
+      .Attr("default_keypoint", kDefaultKeypoint)
+
+#define CREATE_NODEDEF_BOX_INDEX(shapes, data_types, datas)        \
+  int32_t node_valid_num = -1;                                     \
+  auto node_def = NodeDefBuilder::CreateNodeDef();                 \
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")         \
+      .Input({"image", data_types[0], shapes[0], datas[0]})        \
+      .Input({"keypoints", data_types[1], shapes[1], datas[1]})    \
+      .Input({"face_num", data_types[2], shapes[2], datas[2]})     \
+      .Input({"box_index", data_types[3], shapes[3], datas[3]})    \
+      .Output({"aligned_image", data_types[4], shapes[4], datas[4]}) \
+      .Output({"valid_num", DT_INT32, {1}, &node_valid_num})       \
+      .Attr("face_size", vector<int64_t>({kFaceW, kFaceH}))        \
+      .Attr("default_keypoint", kDefaultKeypoint)
+
+#define CREATE_NODEDEF_VALID_NUM(shapes, data_types, datas)          \
+  auto node_def = NodeDefBuilder::CreateNodeDef();                   \
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")           \
+      .Input({"image", data_types[0], shapes[0], datas[0]})          \
+      .Input({"keypoints", data_types[1], shapes[1], datas[1]})      \
+      .Input({"face_num", data_types[2], shapes[2], datas[2]})       \
+      .Output({"aligned_image", data_types[3], shapes[3], datas[3]}) \
+      .Output({"valid_num", data_types[4], shapes[4], datas[4]})     \
+      .Attr("face_size", vector<int64_t>({kFaceW, kFaceH}))          \
+      .Attr("default_keypoint", kDefaultKeypoint)
+
+#define RUN_KERNEL(node_def, HOST, expect_ret)      \
+  CpuKernelContext ctx(DEVICE);                     \
+  EXPECT_EQ(ctx.Init(node_def.get()), 0);           \
+  FaceAlignCpuKernelTest face_align;                \
+  EXPECT_EQ(face_align.Compute(ctx), expect_ret);
+
+void SetRandomImage(vector<uint8_t> &image) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis(0, 255);
+  for (auto &pixel : image) {
+    pixel = static_cast<uint8_t>(dis(gen));
+  }
+}
+
+// keypoints of face i are the template scaled, moved somewhere in the frame
+// and jittered by a landmark detector's worth of noise
+void SetFaceKeypoints(vector<float> &keypoints, int32_t face_num) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> noise(-1.5f, 1.5f);
+  std::uniform_real_distribution<float> scale(0.8f, 2.0f);
+  std::uniform_real_distribution<float> tx(0.0f, kImageW - 2.0f * kFaceW);
+  std::uniform_real_distribution<float> ty(0.0f, kImageH - 2.0f * kFaceH);
+  for (int32_t i = 0; i < face_num; ++i) {
+    float s = scale(gen);
+    float x = tx(gen);
+    float y = ty(gen);
+    for (int k = 0; k < 5; ++k) {
+      keypoints[i * 10 + k * 2] = kDefaultKeypoint[k * 2] * s + x + noise(gen);
+      keypoints[i * 10 + k * 2 + 1] = kDefaultKeypoint[k * 2 + 1] * s + y + noise(gen);
+    }
+  }
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, IDENTITY_KEYPOINT_SUCC) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  // keypoints equal to the template, the crop is the top-left of the image
+  int64_t mismatch = 0;
+  for (int64_t y = 0; y < kFaceH; ++y) {
+    for (int64_t x = 0; x < kFaceW * 3; ++x) {
+      int diff = output[y * kFaceW * 3 + x] - image[y * kImageW * 3 + x];
+      if (diff > 1 || diff < -1) {
+        mismatch++;
+      }
+    }
+  }
+  EXPECT_EQ(mismatch, 0);
+}
+
+// one template keypoint is off by 30 pixels, ransac must leave it out of the fit
+TEST_F(TEST_FACE_ALIGN_UT, RANSAC_OUTLIER_KEYPOINT_SUCC) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  keypoints[4] += 30.0f;
+  keypoints[5] += 30.0f;
+  int32_t face_num = 1;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas).Attr("transform_type", string("ransac"));
+  RUN_KERNEL(node_def, HOST, 0);
+
+  int64_t mismatch = 0;
+  for (int64_t y = 0; y < kFaceH; ++y) {
+    for (int64_t x = 0; x < kFaceW * 3; ++x) {
+      if (output[y * kFaceW * 3 + x] != image[y * kImageW * 3 + x]) {
+        mismatch++;
+      }
+    }
+  }
+  EXPECT_EQ(mismatch, 0);
+}
+
+// two frames in one launch, each face picks its frame through box_index
+TEST_F(TEST_FACE_ALIGN_UT, BATCH_BOX_INDEX_SUCC) {
+  const int64_t kBatch = 2;
+  const int32_t kFaceNum = 3;
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{kBatch, kImageH, kImageW, 3}, {kFaceNum, 10}, {1},
+                                    {kFaceNum}, {kFaceNum, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kBatch * kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints;
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    keypoints.insert(keypoints.end(), kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  }
+  int32_t face_num = kFaceNum;
+  vector<int32_t> box_index = {1, 0, 1};
+  vector<uint8_t> output(kFaceNum * kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(), (void *)&face_num,
+                          (void *)box_index.data(), (void *)output.data()};
+
+  CREATE_NODEDEF_BOX_INDEX(shapes, data_types, datas);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  // keypoints equal to the template, each crop is the top-left of its frame
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    const uint8_t *frame = image.data() + box_index[i] * kImageH * kImageW * 3;
+    const uint8_t *face = output.data() + i * kFaceH * kFaceW * 3;
+    int64_t mismatch = 0;
+    for (int64_t y = 0; y < kFaceH; ++y) {
+      for (int64_t x = 0; x < kFaceW * 3; ++x) {
+        if (face[y * kFaceW * 3 + x] != frame[y * kImageW * 3 + x]) {
+          mismatch++;
+        }
+      }
+    }
+    EXPECT_EQ(mismatch, 0) << "face " << i;
+  }
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, BOX_INDEX_OUT_OF_RANGE_FAILED) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{2, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1}, {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(2 * kImageH * kImageW * 3, 0);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  int32_t box_index = 2;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(), (void *)&face_num,
+                          (void *)&box_index, (void *)output.data()};
+
+  CREATE_NODEDEF_BOX_INDEX(shapes, data_types, datas);
+  RUN_KERNEL(node_def, HOST, 1);
+}
+
+// a launch rejected for its box_index must not touch aligned_image or valid_num
+TEST_F(TEST_FACE_ALIGN_UT, BOX_INDEX_REJECT_KEEPS_OUTPUTS) {
+  const int64_t kSlots = 2;
+  vector<uint8_t> image(2 * kImageH * kImageW * 3, 0);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  int32_t box_index = -1;
+  int32_t valid_num = -1;
+  vector<uint8_t> output(kSlots * kFaceH * kFaceW * 3, 0xab);
+
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")
+      .Input({"image", DT_UINT8, {2, kImageH, kImageW, 3}, image.data()})
+      .Input({"keypoints", DT_FLOAT, {1, 10}, keypoints.data()})
+      .Input({"face_num", DT_INT32, {1}, &face_num})
+      .Input({"box_index", DT_INT32, {1}, &box_index})
+      .Output({"aligned_image", DT_UINT8, {kSlots, kFaceH, kFaceW, 3}, output.data()})
+      .Output({"valid_num", DT_INT32, {1}, &valid_num})
+      .Attr("face_size", vector<int64_t>({kFaceW, kFaceH}))
+      .Attr("default_keypoint", kDefaultKeypoint)
+      .Attr("zero_unused", true);
+  RUN_KERNEL(node_def, HOST, 1);
+
+  EXPECT_EQ(valid_num, -1);
+  int64_t kept_bytes = 0;
+  for (auto value : output) {
+    kept_bytes += value == 0xab ? 1 : 0;
+  }
+  EXPECT_EQ(kept_bytes, static_cast<int64_t>(output.size()));
+}
+
+// valid_num is a required output, a node without it is rejected before aligned_image is touched
+TEST_F(TEST_FACE_ALIGN_UT, VALID_NUM_MISSING_FAILED) {
+  vector<uint8_t> image(kImageH * kImageW * 3, 0);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0xab);
+
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")
+      .Input({"image", DT_UINT8, {1, kImageH, kImageW, 3}, image.data()})
+      .Input({"keypoints", DT_FLOAT, {1, 10}, keypoints.data()})
+      .Input({"face_num", DT_INT32, {1}, &face_num})
+      .Output({"aligned_image", DT_UINT8, {1, kFaceH, kFaceW, 3}, output.data()})
+      .Attr("face_size", vector<int64_t>({kFaceW, kFaceH}))
+      .Attr("default_keypoint", kDefaultKeypoint);
+  RUN_KERNEL(node_def, HOST, 1);
+
+  EXPECT_EQ(output[0], 0xab);
+}
+
+// identity keypoints, the crop is the top-left of the image normalized into planar floats
+TEST_F(TEST_FACE_ALIGN_UT, NORMALIZE_NCHW_FLOAT_SUCC) {
+  const vector<float> kMean = {127.5f, 110.0f, 100.0f};
+  const vector<float> kStd = {128.0f, 60.0f, 0.5f};
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_FLOAT};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, 3, kFaceH, kFaceW}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<float> output(3 * kFaceH * kFaceW, 0.0f);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas)
+      .Attr("output_dtype", DT_FLOAT)
+      .Attr("output_format", string("NCHW"))
+      .Attr("mean", kMean)
+      .Attr("std", kStd);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  int64_t mismatch = 0;
+  for (int64_t c = 0; c < 3; ++c) {
+    for (int64_t y = 0; y < kFaceH; ++y) {
+      for (int64_t x = 0; x < kFaceW; ++x) {
+        float expect = (static_cast<float>(image[(y * kImageW + x) * 3 + c]) - kMean[c]) / kStd[c];
+        if (output[(c * kFaceH + y) * kFaceW + x] != expect) {
+          mismatch++;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(mismatch, 0);
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, NORMALIZE_NHWC_FLOAT16_SUCC) {
+  const vector<float> kMean = {127.5f, 127.5f, 127.5f};
+  const vector<float> kStd = {127.5f, 127.5f, 127.5f};
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_FLOAT16};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<Eigen::half> output(kFaceH * kFaceW * 3);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas)
+      .Attr("output_dtype", DT_FLOAT16)
+      .Attr("mean", kMean)
+      .Attr("std", kStd);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  int64_t mismatch = 0;
+  for (int64_t y = 0; y < kFaceH; ++y) {
+    for (int64_t x = 0; x < kFaceW * 3; ++x) {
+      float value = (static_cast<float>(image[y * kImageW * 3 + x]) - kMean[x % 3]) / kStd[x % 3];
+      if (output[y * kFaceW * 3 + x].x != Eigen::half(value).x) {
+        mismatch++;
+      }
+    }
+  }
+  EXPECT_EQ(mismatch, 0);
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, NORMALIZE_INVALID_ATTR_FAILED) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_FLOAT};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3, 0);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<float> output(kFaceH * kFaceW * 3, 0.0f);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+  {
+    // output tensor is float but output_dtype is left at uint8
+    CREATE_NODEDEF(shapes, data_types, datas);
+    RUN_KERNEL(node_def, HOST, 1);
+  }
+  {
+    CREATE_NODEDEF(shapes, data_types, datas)
+        .Attr("output_dtype", DT_FLOAT)
+        .Attr("std", vector<float>({1.0f, 0.0f, 1.0f}));
+    RUN_KERNEL(node_def, HOST, 1);
+  }
+}
+
+// NV12 input, keypoints equal to the template: the crop is the top-left of cvtColor's BGR
+TEST_F(TEST_FACE_ALIGN_UT, NV12_IDENTITY_KEYPOINT_SUCC) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{1, kImageH * 3 / 2, kImageW, 1}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * 3 / 2 * kImageW);
+  SetRandomImage(image);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas).Attr("input_format", string("YUV420SP_U8"));
+  RUN_KERNEL(node_def, HOST, 0);
+
+  cv::Mat bgr;
+  cv::cvtColor(cv::Mat(kImageH * 3 / 2, kImageW, CV_8UC1, image.data()), bgr, cv::COLOR_YUV2BGR_NV12);
+  int64_t mismatch = 0;
+  for (int64_t y = 0; y < kFaceH; ++y) {
+    for (int64_t x = 0; x < kFaceW * 3; ++x) {
+      int diff = output[y * kFaceW * 3 + x] - bgr.ptr<uint8_t>(y)[x];
+      if (diff > 1 || diff < -1) {
+        mismatch++;
+      }
+    }
+  }
+  EXPECT_EQ(mismatch, 0);
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, NV12_INVALID_SHAPE_FAILED) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<uint8_t> image(kImageH * kImageW * 3, 0);
+  vector<float> keypoints(kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  int32_t face_num = 1;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+  // a BGR shape, rows that are not 3 / 2 of an even height, an odd width
+  const vector<vector<int64_t>> kImageShapes = {
+      {1, kImageH, kImageW, 3}, {1, kImageH * 3 / 2 + 1, kImageW, 1}, {1, 10, kImageW, 1},
+      {1, kImageH * 3 / 2, kImageW - 1, 1}};
+  for (const auto &image_shape : kImageShapes) {
+    vector<vector<int64_t>> shapes = {image_shape, {1, 10}, {1}, {1, kFaceH, kFaceW, 3}};
+    CREATE_NODEDEF(shapes, data_types, datas).Attr("input_format", string("YUV420SP_U8"));
+    RUN_KERNEL(node_def, HOST, 1);
+  }
+  {
+    vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1}, {1, kFaceH, kFaceW, 3}};
+    CREATE_NODEDEF(shapes, data_types, datas).Attr("input_format", string("NV21"));
+    RUN_KERNEL(node_def, HOST, 1);
+  }
+  // an even height with an odd number of UV rows is valid
+  {
+    vector<vector<int64_t>> shapes = {{1, 270 * 3 / 2, kImageW, 1}, {1, 10}, {1}, {1, kFaceH, kFaceW, 3}};
+    CREATE_NODEDEF(shapes, data_types, datas).Attr("input_format", string("YUV420SP_U8"));
+    RUN_KERNEL(node_def, HOST, 0);
+  }
+}
+
+// face_num beyond keypoints is clamped, slots past valid_num are zeroed or left alone
+TEST_F(TEST_FACE_ALIGN_UT, FACE_NUM_CLAMP_UNUSED_SLOTS_SUCC) {
+  const int64_t kKeypointNum = 2;
+  const int64_t kSlots = 3;
+  const int64_t kFaceBytes = kFaceH * kFaceW * 3;
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8, DT_INT32};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {kKeypointNum, 10}, {1},
+                                    {kSlots, kFaceH, kFaceW, 3}, {1}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints;
+  for (int64_t i = 0; i < kKeypointNum; ++i) {
+    keypoints.insert(keypoints.end(), kDefaultKeypoint.begin(), kDefaultKeypoint.end());
+  }
+  const int32_t kFaceNums[2] = {1000, 1};
+  const int32_t kValidNums[2] = {2, 1};
+  for (int32_t zero_unused = 0; zero_unused < 2; ++zero_unused) {
+    int32_t face_num = kFaceNums[zero_unused];
+    int32_t valid_num = -1;
+    vector<uint8_t> output(kSlots * kFaceBytes, 0xab);
+    vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                            (void *)&face_num, (void *)output.data(), (void *)&valid_num};
+
+    CREATE_NODEDEF_VALID_NUM(shapes, data_types, datas).Attr("zero_unused", zero_unused == 1);
+    RUN_KERNEL(node_def, HOST, 0);
+
+    EXPECT_EQ(valid_num, kValidNums[zero_unused]);
+    EXPECT_EQ(output[0], image[0]);
+    int64_t unused_bytes = 0;
+    uint8_t unused_value = zero_unused == 1 ? 0 : 0xab;
+    for (int64_t k = valid_num * kFaceBytes; k < kSlots * kFaceBytes; ++k) {
+      unused_bytes += output[k] == unused_value ? 1 : 0;
+    }
+    EXPECT_EQ(unused_bytes, (kSlots - valid_num) * kFaceBytes);
+  }
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, ZERO_FACE_SUCC) {
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {1, 10}, {1},
+                                    {1, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3, 0);
+  vector<float> keypoints(10, 0.0f);
+  int32_t face_num = 0;
+  vector<uint8_t> output(kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas);
+  RUN_KERNEL(node_def, HOST, 0);
+}
+
+// warping must not allocate a crop buffer per face
+TEST_F(TEST_FACE_ALIGN_UT, NO_CROP_ALLOCATION) {
+  const int32_t kFaceNum = 40;
+  const int kLoops = 3;
+  vector<DataType> data_types = {DT_UINT8, DT_FLOAT, DT_INT32, DT_UINT8};
+  vector<vector<int64_t>> shapes = {{1, kImageH, kImageW, 3}, {kFaceNum, 10},
+                                    {1}, {kFaceNum, kFaceH, kFaceW, 3}};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kFaceNum * 10);
+  SetFaceKeypoints(keypoints, kFaceNum);
+  int32_t face_num = kFaceNum;
+  vector<uint8_t> output(kFaceNum * kFaceH * kFaceW * 3, 0);
+  vector<void *> datas = {(void *)image.data(), (void *)keypoints.data(),
+                          (void *)&face_num, (void *)output.data()};
+
+  CREATE_NODEDEF(shapes, data_types, datas);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  CropCountingAllocator allocator;
+  cv::MatAllocator *default_allocator = cv::Mat::getDefaultAllocator();
+  cv::Mat::setDefaultAllocator(&allocator);
+  for (int i = 0; i < kLoops; ++i) {
+    EXPECT_EQ(face_align.Compute(ctx), 0);
+  }
+  cv::Mat::setDefaultAllocator(default_allocator);
+  EXPECT_EQ(allocator.crop_allocs.load(), 0);
+}
+
+#ifdef FACE_ALIGN_WITH_OPENCV
+// crop sizes the hand-written warp does not take go to cv::warpAffine, which
+// has to write the output slice in place and match a plain warpAffine
+TEST_F(TEST_FACE_ALIGN_UT, OPENCV_WARP_NO_CROP_ALLOCATION) {
+  const int32_t kFaceNum = 8;
+  const int64_t kCropW = 128;
+  const int64_t kCropH = 128;
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<float> keypoints(kFaceNum * 10);
+  SetFaceKeypoints(keypoints, kFaceNum);
+  int32_t face_num = kFaceNum;
+  int32_t valid_num = -1;
+  vector<uint8_t> output(kFaceNum * kCropH * kCropW * 3, 0);
+
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "FaceAlign", "FaceAlign")
+      .Input({"image", DT_UINT8, {1, kImageH, kImageW, 3}, image.data()})
+      .Input({"keypoints", DT_FLOAT, {kFaceNum, 10}, keypoints.data()})
+      .Input({"face_num", DT_INT32, {1}, &face_num})
+      .Output({"aligned_image", DT_UINT8, {kFaceNum, kCropH, kCropW, 3}, output.data()})
+      .Output({"valid_num", DT_INT32, {1}, &valid_num})
+      .Attr("face_size", vector<int64_t>({kCropW, kCropH}))
+      .Attr("default_keypoint", kDefaultKeypoint);
+  RUN_KERNEL(node_def, HOST, 0);
+
+  CropCountingAllocator allocator(kCropH, kCropW);
+  cv::MatAllocator *default_allocator = cv::Mat::getDefaultAllocator();
+  cv::Mat::setDefaultAllocator(&allocator);
+  EXPECT_EQ(face_align.Compute(ctx), 0);
+  cv::Mat::setDefaultAllocator(default_allocator);
+  EXPECT_EQ(allocator.crop_allocs.load(), 0);
+
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  cv::Mat img(kImageH, kImageW, CV_8UC3, image.data());
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    double matrix[6];
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::SIMILARITY, &keypoints[i * 10], matrix));
+    cv::Mat expect;
+    cv::warpAffine(img, expect, cv::Mat(2, 3, CV_64F, matrix), cv::Size(kCropW, kCropH));
+    EXPECT_EQ(memcmp(expect.data, &output[i * kCropH * kCropW * 3], kCropH * kCropW * 3), 0);
+  }
+}
+#endif
+
+TEST_F(TEST_FACE_ALIGN_UT, SOLVER_SIMILARITY_EXACT) {
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  // image keypoints are the template rotated by 30 degrees, scaled and moved
+  const double kCos = std::cos(M_PI / 6) * 1.5;
+  const double kSin = std::sin(M_PI / 6) * 1.5;
+  float points[10];
+  for (int k = 0; k < 5; ++k) {
+    double qx = kDefaultKeypoint[k * 2];
+    double qy = kDefaultKeypoint[k * 2 + 1];
+    points[k * 2] = static_cast<float>(kCos * qx - kSin * qy + 300.0);
+    points[k * 2 + 1] = static_cast<float>(kSin * qx + kCos * qy + 200.0);
+  }
+  double matrix[6];
+  ASSERT_TRUE(solver.Solve(FaceTransformSolver::SIMILARITY, points, matrix));
+  EXPECT_LT(TemplateResidual(matrix, points), 1e-6);
+  EXPECT_NEAR(matrix[0], matrix[4], 1e-9);
+  EXPECT_NEAR(matrix[1], -matrix[3], 1e-9);
+  ASSERT_TRUE(solver.Solve(FaceTransformSolver::AFFINE, points, matrix));
+  EXPECT_LT(TemplateResidual(matrix, points), 1e-6);
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, SOLVER_DEGENERATE_KEYPOINT) {
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  float collinear[10] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4};
+  float same[10] = {5, 5, 5, 5, 5, 5, 5, 5, 5, 5};
+  double matrix[6];
+  EXPECT_FALSE(solver.Solve(FaceTransformSolver::AFFINE, collinear, matrix));
+  EXPECT_FALSE(solver.Solve(FaceTransformSolver::SIMILARITY, same, matrix));
+  EXPECT_FALSE(solver.Init(vector<int64_t>(10, 7), 5));
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, SOLVER_ROBUST_AFFINE_OUTLIER) {
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  // template moved by (100, 50), then the nose pulled 20 pixels away
+  float points[10];
+  for (int k = 0; k < 5; ++k) {
+    points[k * 2] = kDefaultKeypoint[k * 2] + 100.0f;
+    points[k * 2 + 1] = kDefaultKeypoint[k * 2 + 1] + 50.0f;
+  }
+  points[4] += 20.0f;
+  double matrix[6];
+  ASSERT_TRUE(solver.Solve(FaceTransformSolver::ROBUST_AFFINE, points, matrix));
+  const double kExpect[6] = {1, 0, -100, 0, 1, -50};
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_NEAR(matrix[i], kExpect[i], 1e-6);
+  }
+  float collinear[10] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4};
+  EXPECT_FALSE(solver.Solve(FaceTransformSolver::ROBUST_AFFINE, collinear, matrix));
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, SOLVER_AFFINE_FITS_LIKE_RANSAC) {
+  const int32_t kFaceNum = 100;
+  vector<float> keypoints(kFaceNum * 10);
+  SetFaceKeypoints(keypoints, kFaceNum);
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  vector<cv::Point2f> dst_points(5);
+  vector<cv::Point2f> src_points(5);
+  for (int k = 0; k < 5; ++k) {
+    src_points[k] = cv::Point2f(kDefaultKeypoint[k * 2], kDefaultKeypoint[k * 2 + 1]);
+  }
+
+  double matrix[6];
+  double affine_residual = 0.0;
+  double ransac_residual = 0.0;
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::AFFINE, &keypoints[i * 10], matrix));
+    affine_residual += TemplateResidual(matrix, &keypoints[i * 10]);
+    for (int k = 0; k < 5; ++k) {
+      dst_points[k] = cv::Point2f(keypoints[i * 10 + k * 2], keypoints[i * 10 + k * 2 + 1]);
+    }
+    cv::Mat M = cv::estimateAffine2D(dst_points, src_points);
+    ASSERT_FALSE(M.empty());
+    ransac_residual += TemplateResidual(M.ptr<double>(), &keypoints[i * 10]);
+  }
+  // least squares can not fit the template worse than RANSAC does
+  EXPECT_LE(affine_residual, ransac_residual + 1e-6);
+}
+
+// microbenchmark: closed-form solver against the RANSAC estimateAffine2D path,
+// run it with --gtest_also_run_disabled_tests
+TEST_F(TEST_FACE_ALIGN_UT, DISABLED_BENCHMARK_SOLVER_VS_RANSAC) {
+  const int32_t kFaceNum = 1000;
+  vector<float> keypoints(kFaceNum * 10);
+  SetFaceKeypoints(keypoints, kFaceNum);
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  vector<cv::Point2f> dst_points(5);
+  vector<cv::Point2f> src_points(5);
+  for (int k = 0; k < 5; ++k) {
+    src_points[k] = cv::Point2f(kDefaultKeypoint[k * 2], kDefaultKeypoint[k * 2 + 1]);
+  }
+
+  double matrix[6];
+  auto start = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::SIMILARITY, &keypoints[i * 10], matrix));
+  }
+  auto similarity_end = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::AFFINE, &keypoints[i * 10], matrix));
+  }
+  auto affine_end = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::ROBUST_AFFINE, &keypoints[i * 10], matrix));
+  }
+  auto robust_end = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kFaceNum; ++i) {
+    for (int k = 0; k < 5; ++k) {
+      dst_points[k] = cv::Point2f(keypoints[i * 10 + k * 2], keypoints[i * 10 + k * 2 + 1]);
+    }
+    cv::Mat M = cv::estimateAffine2D(dst_points, src_points);
+    ASSERT_FALSE(M.empty());
+  }
+  auto ransac_end = std::chrono::steady_clock::now();
+
+  auto us_per_face = [kFaceNum](std::chrono::steady_clock::time_point a,
+                                std::chrono::steady_clock::time_point b) {
+    return std::chrono::duration<double, std::micro>(b - a).count() / kFaceNum;
+  };
+  cout << "similarity: " << us_per_face(start, similarity_end)
+       << " us/face, affine: " << us_per_face(similarity_end, affine_end)
+       << " us/face, robust affine: " << us_per_face(affine_end, robust_end)
+       << " us/face, estimateAffine2D: " << us_per_face(robust_end, ransac_end)
+       << " us/face" << endl;
+}
+
+// similarity transforms of a random frame, some of them pushing the crop
+// over the image border
+void SetWarpMatrices(vector<double> &matrices, int32_t count) {
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<double> angle(-0.6, 0.6);
+  std::uniform_real_distribution<double> scale(0.3, 1.5);
+  std::uniform_real_distribution<double> tx(-kImageW * 0.6, 0.2 * kImageW);
+  std::uniform_real_distribution<double> ty(-kImageH * 0.6, 0.2 * kImageH);
+  for (int32_t i = 0; i < count; ++i) {
+    double s = scale(gen);
+    double a = angle(gen);
+    double *m = &matrices[i * 6];
+    m[0] = s * std::cos(a);
+    m[1] = -s * std::sin(a);
+    m[2] = i % 4 == 0 ? -m[0] * 2.5 : tx(gen) * s;
+    m[3] = s * std::sin(a);
+    m[4] = s * std::cos(a);
+    m[5] = i % 4 == 1 ? -m[4] * (kImageH - 30.7) : ty(gen) * s;
+  }
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, WARP_MATCHES_OPENCV) {
+  const int32_t kCount = 64;
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  cv::Mat img(kImageH, kImageW, CV_8UC3, image.data());
+  vector<double> matrices(kCount * 6);
+  SetWarpMatrices(matrices, kCount);
+  const int kSizes[2][2] = {{112, 112}, {96, 112}};
+  for (auto &size : kSizes) {
+    vector<uint8_t> face(size[0] * size[1] * 3);
+    for (int32_t i = 0; i < kCount; ++i) {
+      ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(),
+                                       size[1], size[0], &matrices[i * 6]));
+      cv::Mat expect;
+      cv::warpAffine(img, expect, cv::Mat(2, 3, CV_64F, &matrices[i * 6]), cv::Size(size[0], size[1]));
+      int max_diff = 0;
+      for (size_t k = 0; k < face.size(); ++k) {
+        max_diff = std::max(max_diff, std::abs(face[k] - expect.data[k]));
+      }
+      EXPECT_LE(max_diff, 1) << "matrix " << i << " size " << size[0] << "x" << size[1];
+    }
+  }
+}
+
+// every simd path must give exactly the scalar result, border pixels included
+TEST_F(TEST_FACE_ALIGN_UT, WARP_SIMD_MATCHES_SCALAR) {
+  const int32_t kCount = 64;
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<double> matrices(kCount * 6);
+  SetWarpMatrices(matrices, kCount);
+  vector<WarpIsa> isas = {WARP_ISA_SCALAR};
+  if (GetWarpIsa() == WARP_ISA_NEON) {
+    isas.push_back(WARP_ISA_NEON);
+  } else {
+    for (int isa = WARP_ISA_SSSE3; isa <= GetWarpIsa(); ++isa) {
+      isas.push_back(static_cast<WarpIsa>(isa));
+    }
+  }
+  vector<uint8_t> expect(kFaceW * kFaceH * 3);
+  vector<uint8_t> face(kFaceW * kFaceH * 3);
+  for (int32_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, expect.data(),
+                                     kFaceH, kFaceW, &matrices[i * 6], WARP_ISA_SCALAR));
+    for (WarpIsa isa : isas) {
+      ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(),
+                                       kFaceH, kFaceW, &matrices[i * 6], isa));
+      EXPECT_EQ(face, expect) << "matrix " << i << " isa " << isa;
+    }
+  }
+}
+
+// crops wider than one 256-column block of the warp
+TEST_F(TEST_FACE_ALIGN_UT, WARP_WIDE_CROP_MATCHES_OPENCV) {
+  const int32_t kCount = 8;
+  const int kWideW = 600;
+  const int kWideH = 40;
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  cv::Mat img(kImageH, kImageW, CV_8UC3, image.data());
+  vector<double> matrices(kCount * 6);
+  SetWarpMatrices(matrices, kCount);
+  vector<uint8_t> face(kWideW * kWideH * 3);
+  for (int32_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(),
+                                     kWideH, kWideW, &matrices[i * 6]));
+    cv::Mat expect;
+    cv::warpAffine(img, expect, cv::Mat(2, 3, CV_64F, &matrices[i * 6]), cv::Size(kWideW, kWideH));
+    int max_diff = 0;
+    for (size_t k = 0; k < face.size(); ++k) {
+      max_diff = std::max(max_diff, std::abs(face[k] - expect.data[k]));
+    }
+    EXPECT_LE(max_diff, 1) << "matrix " << i;
+  }
+}
+
+TEST_F(TEST_FACE_ALIGN_UT, WARP_REJECT_OUT_OF_RANGE) {
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  vector<uint8_t> face(kFaceW * kFaceH * 3);
+  double far_away[6] = {1, 0, -1e9, 0, 1, 0};
+  double singular[6] = {0, 0, 0, 0, 0, 0};
+  EXPECT_FALSE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(),
+                                    kFaceH, kFaceW, far_away));
+  EXPECT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(),
+                                   kFaceH, kFaceW, singular));
+}
+
+// a fused float output must equal the uint8 warp looked up in the tables, border included
+TEST_F(TEST_FACE_ALIGN_UT, WARP_DST_FORMAT_MATCHES_U8) {
+  const int32_t kCount = 16;
+  const float kMean[3] = {1.0f, 2.0f, 3.0f};
+  const float kStd[3] = {0.5f, 2.0f, 100.0f};
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  vector<double> matrices(kCount * 6);
+  SetWarpMatrices(matrices, kCount);
+  WarpDstFormat chw_f32;
+  ASSERT_TRUE(InitWarpDstFormat(chw_f32, WARP_DST_F32, true, kMean, kStd));
+  WarpDstFormat hwc_f16;
+  ASSERT_TRUE(InitWarpDstFormat(hwc_f16, WARP_DST_F16, false, kMean, kStd));
+  EXPECT_EQ(WarpDstBytes(chw_f32, kFaceH, kFaceW), kFaceH * kFaceW * 3 * 4);
+  vector<uint8_t> expect(kFaceW * kFaceH * 3);
+  vector<float> planar(kFaceW * kFaceH * 3);
+  vector<uint16_t> half(kFaceW * kFaceH * 3);
+  for (int32_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, expect.data(),
+                                     kFaceH, kFaceW, &matrices[i * 6]));
+    ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, planar.data(),
+                                     chw_f32, kFaceH, kFaceW, &matrices[i * 6]));
+    ASSERT_TRUE(WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, half.data(),
+                                     hwc_f16, kFaceH, kFaceW, &matrices[i * 6]));
+    int64_t mismatch = 0;
+    for (int64_t p = 0; p < kFaceH * kFaceW; ++p) {
+      for (int64_t c = 0; c < 3; ++c) {
+        uint8_t v = expect[p * 3 + c];
+        if (planar[c * kFaceH * kFaceW + p] != chw_f32.lut_f32[c][v] ||
+            half[p * 3 + c] != hwc_f16.lut_f16[c][v]) {
+          mismatch++;
+        }
+      }
+    }
+    EXPECT_EQ(mismatch, 0) << "matrix " << i;
+  }
+  FillWarpDst(planar.data(), chw_f32, kFaceH, kFaceW);
+  EXPECT_EQ(planar[0], -2.0f);
+  EXPECT_EQ(planar[kFaceH * kFaceW * 3 - 1], -0.03f);
+  const float kZeroStd[3] = {1.0f, 0.0f, 1.0f};
+  EXPECT_FALSE(InitWarpDstFormat(chw_f32, WARP_DST_F32, true, kMean, kZeroStd));
+}
+
+// sampling NV12 directly must stay close to cvtColor followed by warpAffine
+TEST_F(TEST_FACE_ALIGN_UT, WARP_NV12_MATCHES_OPENCV) {
+  const int32_t kCount = 32;
+  // smooth content, interpolating before or after the conversion only differs in rounding
+  vector<uint8_t> image(kImageH * 3 / 2 * kImageW);
+  for (int64_t y = 0; y < kImageH; ++y) {
+    for (int64_t x = 0; x < kImageW; ++x) {
+      image[y * kImageW + x] = static_cast<uint8_t>(128 + 100 * std::sin(x * 0.05) * std::cos(y * 0.03));
+    }
+  }
+  uint8_t *uv = image.data() + kImageH * kImageW;
+  for (int64_t y = 0; y < kImageH / 2; ++y) {
+    for (int64_t x = 0; x < kImageW; x += 2) {
+      uv[y * kImageW + x] = static_cast<uint8_t>(128 + 60 * std::sin(y * 0.04));
+      uv[y * kImageW + x + 1] = static_cast<uint8_t>(128 + 60 * std::cos(x * 0.03));
+    }
+  }
+  cv::Mat bgr;
+  cv::cvtColor(cv::Mat(kImageH * 3 / 2, kImageW, CV_8UC1, image.data()), bgr, cv::COLOR_YUV2BGR_NV12);
+  vector<double> matrices(kCount * 6);
+  SetWarpMatrices(matrices, kCount);
+  WarpDstFormat hwc_u8 = WarpDstFormat();
+  vector<uint8_t> face(kFaceW * kFaceH * 3);
+  for (int32_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(WarpAffineBilinearNv12(image.data(), uv, kImageH, kImageW, kImageW, face.data(), hwc_u8,
+                                       kFaceH, kFaceW, &matrices[i * 6]));
+    cv::Mat expect;
+    cv::warpAffine(bgr, expect, cv::Mat(2, 3, CV_64F, &matrices[i * 6]), cv::Size(kFaceW, kFaceH));
+    int64_t total_diff = 0;
+    for (size_t k = 0; k < face.size(); ++k) {
+      total_diff += std::abs(face[k] - expect.data[k]);
+    }
+    EXPECT_LT(static_cast<double>(total_diff) / face.size(), 1.0) << "matrix " << i;
+  }
+}
+
+// microbenchmark: hand-written warp against cv::warpAffine on 112x112 crops,
+// run it with --gtest_also_run_disabled_tests
+TEST_F(TEST_FACE_ALIGN_UT, DISABLED_BENCHMARK_WARP_VS_OPENCV) {
+  const int32_t kCount = 400;
+  vector<uint8_t> image(kImageH * kImageW * 3);
+  SetRandomImage(image);
+  cv::Mat img(kImageH, kImageW, CV_8UC3, image.data());
+  vector<float> keypoints(kCount * 10);
+  SetFaceKeypoints(keypoints, kCount);
+  FaceTransformSolver solver;
+  ASSERT_TRUE(solver.Init(kDefaultKeypoint, 5));
+  vector<double> matrices(kCount * 6);
+  for (int32_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(solver.Solve(FaceTransformSolver::SIMILARITY, &keypoints[i * 10], &matrices[i * 6]));
+  }
+  vector<uint8_t> face(kFaceW * kFaceH * 3);
+  auto start = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kCount; ++i) {
+    WarpAffineBilinearC3(image.data(), kImageH, kImageW, kImageW * 3, face.data(), kFaceH, kFaceW,
+                         &matrices[i * 6]);
+  }
+  auto warp_end = std::chrono::steady_clock::now();
+  cv::Mat crop(kFaceH, kFaceW, CV_8UC3, face.data());
+  for (int32_t i = 0; i < kCount; ++i) {
+    cv::warpAffine(img, crop, cv::Mat(2, 3, CV_64F, &matrices[i * 6]), crop.size());
+  }
+  auto opencv_end = std::chrono::steady_clock::now();
+  cout << "warp isa " << GetWarpIsa() << ": "
+       << std::chrono::duration<double, std::micro>(warp_end - start).count() / kCount
+       << " us/face, cv::warpAffine: "
+       << std::chrono::duration<double, std::micro>(opencv_end - warp_end).count() / kCount
+       << " us/face" << endl;
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+#include "face_align.h"
+
+using namespace std;
+
+class TEST_FACE_ALIGN_PROTO_UT : public testing::Test {};
+
+namespace {
+const vector<int64_t> kDefaultKeypoint = {40, 45, 72, 45, 52, 65, 42, 82, 72, 82};
+
+ge::TensorDesc CreateDesc(const vector<int64_t> &dims, ge::DataType data_type,
+                          ge::Format format = ge::FORMAT_ND) {
+  ge::TensorDesc desc(ge::Shape(dims), format, data_type);
+  desc.SetOriginShape(ge::Shape(dims));
+  desc.SetOriginFormat(format);
+  return desc;
+}
+
+// 96x112 faces so width and height can not be swapped unnoticed
+void InitFaceAlign(ge::op::FaceAlign &op, const vector<int64_t> &image_dims,
+                   const vector<int64_t> &keypoints_dims) {
+  op.UpdateInputDesc("image", CreateDesc(image_dims, ge::DT_UINT8, ge::FORMAT_NHWC));
+  op.UpdateInputDesc("keypoints", CreateDesc(keypoints_dims, ge::DT_FLOAT));
+  op.UpdateInputDesc("face_num", CreateDesc({1}, ge::DT_INT32));
+  op.set_attr_face_size({96, 112});
+  op.set_attr_default_keypoint(kDefaultKeypoint);
+}
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, INFER_SHAPE_NHWC_SUCC) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {1, 720, 1280, 3}, {4, 10});
+  EXPECT_EQ(op.InferShapeAndType(), ge::GRAPH_SUCCESS);
+
+  ge::TensorDesc output_desc = op.GetOutputDesc("aligned_image");
+  EXPECT_EQ(output_desc.GetShape().GetDims(), vector<int64_t>({4, 112, 96, 3}));
+  EXPECT_EQ(output_desc.GetDataType(), ge::DT_UINT8);
+  EXPECT_EQ(output_desc.GetFormat(), ge::FORMAT_NHWC);
+  ge::TensorDesc valid_num_desc = op.GetOutputDesc("valid_num");
+  EXPECT_EQ(valid_num_desc.GetShape().GetDims(), vector<int64_t>({1}));
+  EXPECT_EQ(valid_num_desc.GetDataType(), ge::DT_INT32);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, INFER_SHAPE_NCHW_FLOAT_SUCC) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {2, 720, 1280, 3}, {8, 10});
+  op.set_attr_output_format("NCHW");
+  op.set_attr_output_dtype(ge::DT_FLOAT);
+  EXPECT_EQ(op.InferShapeAndType(), ge::GRAPH_SUCCESS);
+
+  ge::TensorDesc output_desc = op.GetOutputDesc("aligned_image");
+  EXPECT_EQ(output_desc.GetShape().GetDims(), vector<int64_t>({8, 3, 112, 96}));
+  EXPECT_EQ(output_desc.GetDataType(), ge::DT_FLOAT);
+  EXPECT_EQ(output_desc.GetFormat(), ge::FORMAT_NCHW);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, INFER_SHAPE_UNKNOWN_FACE_NUM_SUCC) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {1, 720, 1280, 3}, {1, 10});
+  ge::TensorDesc keypoints_desc = CreateDesc({-1, 10}, ge::DT_FLOAT);
+  keypoints_desc.SetShapeRange({{1, 64}, {10, 10}});
+  op.UpdateInputDesc("keypoints", keypoints_desc);
+  EXPECT_EQ(op.InferShapeAndType(), ge::GRAPH_SUCCESS);
+
+  ge::TensorDesc output_desc = op.GetOutputDesc("aligned_image");
+  EXPECT_EQ(output_desc.GetShape().GetDims(), vector<int64_t>({-1, 112, 96, 3}));
+  vector<pair<int64_t, int64_t>> output_range;
+  output_desc.GetShapeRange(output_range);
+  vector<pair<int64_t, int64_t>> expect_range = {{1, 64}, {112, 112}, {96, 96}, {3, 3}};
+  EXPECT_EQ(output_range, expect_range);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, INFER_SHAPE_INVALID_FACE_SIZE_FAILED) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {1, 720, 1280, 3}, {4, 10});
+  op.set_attr_face_size({112});
+  EXPECT_EQ(op.InferShapeAndType(), ge::GRAPH_FAILED);
+  op.set_attr_face_size({0, 112});
+  EXPECT_EQ(op.InferShapeAndType(), ge::GRAPH_FAILED);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, VERIFY_SUCC) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {1, 720, 1280, 3}, {4, 10});
+  EXPECT_EQ(op.VerifyAllAttr(true), ge::GRAPH_SUCCESS);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, VERIFY_NV12_CHANNELS) {
+  ge::op::FaceAlign nv12_op;
+  InitFaceAlign(nv12_op, {1, 1080, 1280, 1}, {4, 10});
+  nv12_op.set_attr_input_format("YUV420SP_U8");
+  EXPECT_EQ(nv12_op.VerifyAllAttr(true), ge::GRAPH_SUCCESS);
+
+  ge::op::FaceAlign nv12_bgr_op;
+  InitFaceAlign(nv12_bgr_op, {1, 1080, 1280, 3}, {4, 10});
+  nv12_bgr_op.set_attr_input_format("YUV420SP_U8");
+  EXPECT_EQ(nv12_bgr_op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+
+  ge::op::FaceAlign bgr_op;
+  InitFaceAlign(bgr_op, {1, 1080, 1280, 1}, {4, 10});
+  EXPECT_EQ(bgr_op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, VERIFY_INVALID_DEFAULT_KEYPOINT_FAILED) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {1, 720, 1280, 3}, {4, 10});
+  op.set_attr_default_keypoint({40, 45, 72, 45, 52, 65, 42, 82});
+  EXPECT_EQ(op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, VERIFY_INVALID_IMAGE_RANK_FAILED) {
+  ge::op::FaceAlign op;
+  InitFaceAlign(op, {720, 1280, 3}, {4, 10});
+  EXPECT_EQ(op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+
+  // unknown rank is left to the kernel
+  ge::op::FaceAlign unknown_rank_op;
+  InitFaceAlign(unknown_rank_op, {-2}, {4, 10});
+  EXPECT_EQ(unknown_rank_op.VerifyAllAttr(true), ge::GRAPH_SUCCESS);
+}
+
+TEST_F(TEST_FACE_ALIGN_PROTO_UT, VERIFY_INVALID_OUTPUT_FAILED) {
+  ge::op::FaceAlign dtype_op;
+  InitFaceAlign(dtype_op, {1, 720, 1280, 3}, {4, 10});
+  dtype_op.set_attr_output_dtype(ge::DT_INT32);
+  EXPECT_EQ(dtype_op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+
+  ge::op::FaceAlign format_op;
+  InitFaceAlign(format_op, {1, 720, 1280, 3}, {4, 10});
+  format_op.set_attr_output_format("NC1HWC0");
+  EXPECT_EQ(format_op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+
+  ge::op::FaceAlign keypoints_op;
+  InitFaceAlign(keypoints_op, {1, 720, 1280, 3}, {4, 8});
+  EXPECT_EQ(keypoints_op.VerifyAllAttr(true), ge::GRAPH_FAILED);
+}
@@ -0,0 +1,368 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cpu_context.h"
+#include "cpu_kernel_utils.h"
+#include "eigen_threadpool.h"
+#include "host_thread_config.h"
+#include "sharder.h"
+#include "work_stealing_pool.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_HOST_SHARDER_UT : public testing::Test {};
+
+namespace {
+const uint32_t kThreadNum = 4;
+
+// every unit of [0, total) must be visited exactly once
+bool CoversOnce(WorkStealingPool &pool, int64_t total, int64_t per_unit_size) {
+  std::vector<std::atomic<int32_t>> visits(total);
+  for (auto &visit : visits) {
+    visit.store(0);
+  }
+  pool.ParallelFor(total, per_unit_size, [&visits](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; ++i) {
+      visits[i]++;
+    }
+  });
+  for (auto &visit : visits) {
+    if (visit.load() != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// restores an environment variable when the test ends
+class ScopedEnv {
+ public:
+  ScopedEnv(const char *name, const char *value) : name_(name) {
+    const char *old = getenv(name);
+    had_value_ = old != nullptr;
+    old_value_ = had_value_ ? old : "";
+    setenv(name, value, 1);
+  }
+  ~ScopedEnv() {
+    if (had_value_) {
+      setenv(name_.c_str(), old_value_.c_str(), 1);
+    } else {
+      unsetenv(name_.c_str());
+    }
+  }
+
+ private:
+  std::string name_;
+  bool had_value_;
+  std::string old_value_;
+};
+
+// dense units of a few hundred cycles each, the shape of most host kernels
+void CheapWork(std::vector<float> &data, int64_t start, int64_t end) {
+  for (int64_t i = start; i < end; ++i) {
+    data[i] = data[i] * 0.5f + 1.0f;
+  }
+}
+
+// units whose cost grows with the index, a static split leaves threads idle
+void UnevenWork(std::vector<float> &data, int64_t start, int64_t end) {
+  for (int64_t i = start; i < end; ++i) {
+    float value = data[i];
+    for (int64_t k = 0; k < i / 8; ++k) {
+      value = value * 0.999f + 0.001f;
+    }
+    data[i] = value;
+  }
+}
+
+template <class Pool>
+double RunParallelFors(Pool *pool, int caller_num, int repeat, int64_t total,
+                       int64_t per_unit_size, bool uneven) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> callers;
+  for (int c = 0; c < caller_num; ++c) {
+    callers.emplace_back([=]() {
+      std::vector<float> data(total, 1.0f);
+      for (int r = 0; r < repeat; ++r) {
+        pool->ParallelFor(total, per_unit_size,
+                          [&data, uneven](int64_t first, int64_t last) {
+                            uneven ? UnevenWork(data, first, last)
+                                   : CheapWork(data, first, last);
+                          });
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         (static_cast<double>(caller_num) * repeat);
+}
+// the caller holds its first block until every other unit is done, so the
+// others run on pool threads only
+void HoldFirstBlock(WorkStealingPool &pool, int64_t total,
+                    const std::function<void(int64_t, int64_t)> &work,
+                    bool &timed_out) {
+  std::atomic<int64_t> done(0);
+  std::thread::id caller = std::this_thread::get_id();
+  timed_out = false;
+  pool.ParallelFor(total, 1, [&](int64_t start, int64_t end) {
+    if ((start == 0) && (std::this_thread::get_id() == caller)) {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+      while (done.load() < total - (end - start)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+          timed_out = true;
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    work(start, end);
+    done += end - start;
+  });
+}
+}  // namespace
+
+TEST_F(TEST_HOST_SHARDER_UT, WORK_STEALING_COVERS_EVERY_UNIT) {
+  WorkStealingPool pool(kThreadNum, {});
+  EXPECT_EQ(pool.GetCPUNum(), kThreadNum);
+  for (int64_t total : {1, 2, 7, 100, 4096, 100003}) {
+    for (int64_t per_unit_size : {1, 3, 1000, 200000}) {
+      EXPECT_TRUE(CoversOnce(pool, total, per_unit_size))
+          << "total " << total << ", per unit size " << per_unit_size;
+    }
+  }
+  WorkStealingPool single(1, {});
+  EXPECT_TRUE(CoversOnce(single, 1000, 1));
+}
+
+TEST_F(TEST_HOST_SHARDER_UT, CONCURRENT_PARALLEL_FOR) {
+  WorkStealingPool pool(kThreadNum, {});
+  std::atomic<int64_t> wrong(0);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 8; ++c) {
+    callers.emplace_back([&pool, &wrong, c]() {
+      for (int r = 0; r < 200; ++r) {
+        int64_t total = 100 + c * 37 + r;
+        std::atomic<int64_t> sum(0);
+        pool.ParallelFor(total, 1, [&sum](int64_t start, int64_t end) {
+          for (int64_t i = start; i < end; ++i) {
+            sum += i;
+          }
+        });
+        wrong += (sum.load() != total * (total - 1) / 2) ? 1 : 0;
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(wrong.load(), 0);
+}
+
+// the rest of the caller's share can only finish if other threads steal it
+TEST_F(TEST_HOST_SHARDER_UT, BLOCKED_SHARE_IS_STOLEN) {
+  WorkStealingPool pool(kThreadNum, {});
+  std::atomic<int64_t> units(0);
+  bool timed_out = false;
+  HoldFirstBlock(pool, 64, [&units](int64_t start, int64_t end) {
+    units += end - start;
+  }, timed_out);
+  EXPECT_FALSE(timed_out);
+  EXPECT_EQ(units.load(), 64);
+}
+
+TEST_F(TEST_HOST_SHARDER_UT, PINNED_THREADS_STAY_ON_CPU) {
+  std::vector<uint32_t> cpus = GetAllowedCpus();
+  ASSERT_FALSE(cpus.empty());
+  WorkStealingPool pool(kThreadNum, {cpus.back()});
+  std::atomic<int64_t> wrong_cpu(0);
+  bool timed_out = false;
+  HoldFirstBlock(pool, 64, [&wrong_cpu, &cpus](int64_t start, int64_t end) {
+    if (start != 0) {
+      wrong_cpu += (sched_getcpu() != static_cast<int>(cpus.back())) ? 1 : 0;
+    }
+  }, timed_out);
+  EXPECT_FALSE(timed_out);
+  EXPECT_EQ(wrong_cpu.load(), 0);
+}
+
+TEST_F(TEST_HOST_SHARDER_UT, THREAD_CONFIG_FROM_ENV) {
+  HostThreadConfig config = LoadHostThreadConfig();
+  std::vector<uint32_t> cpus = GetAllowedCpus();
+  EXPECT_EQ(config.cpus, cpus);
+  EXPECT_GE(config.thread_num, 1u);
+  EXPECT_LE(config.thread_num, cpus.size());
+  uint32_t cgroup_limit = GetCgroupCpuLimit();
+  if (cgroup_limit != 0) {
+    EXPECT_LE(config.thread_num, cgroup_limit);
+  }
+
+  {
+    ScopedEnv scheduler("AICPU_HOST_SCHEDULER", "work_stealing");
+    ScopedEnv thread_num("AICPU_HOST_THREAD_NUM", "3");
+    ScopedEnv pin("AICPU_HOST_THREAD_PIN", "1");
+    config = LoadHostThreadConfig();
+    EXPECT_EQ(config.scheduler, HOST_SCHEDULER_WORK_STEALING);
+    EXPECT_EQ(config.thread_num, 3u);
+    EXPECT_TRUE(config.pin_threads);
+  }
+  {
+    ScopedEnv scheduler("AICPU_HOST_SCHEDULER", "unknown");
+    ScopedEnv thread_num("AICPU_HOST_THREAD_NUM", "0");
+    config = LoadHostThreadConfig();
+    EXPECT_EQ(config.scheduler, HOST_SCHEDULER_EIGEN);
+    EXPECT_EQ(config.thread_num, LoadHostThreadConfig().thread_num);
+    EXPECT_FALSE(config.pin_threads);
+  }
+}
+
+TEST_F(TEST_HOST_SHARDER_UT, COST_HINT_SIZES_SHARDS) {
+  CpuKernelContext ctx(HOST);
+  std::atomic<int64_t> shards(0);
+  std::atomic<int64_t> units(0);
+  auto work = [&shards, &units](int64_t start, int64_t end) {
+    shards++;
+    units += end - start;
+  };
+
+  // a few cycles per unit, not worth a second thread
+  ParallelForCost cheap;
+  cheap.compute_cycles = 1;
+  ASSERT_EQ(CpuKernelUtils::ParallelFor(ctx, 1000, cheap, work), 0);
+  EXPECT_EQ(shards.load(), 1);
+  EXPECT_EQ(units.load(), 1000);
+
+  shards = 0;
+  units = 0;
+  ParallelForCost heavy;
+  heavy.bytes_loaded = 112 * 112 * 3;
+  heavy.bytes_stored = 112 * 112 * 3;
+  heavy.compute_cycles = 112 * 112 * 20;
+  ASSERT_EQ(CpuKernelUtils::ParallelFor(ctx, 64, heavy, work), 0);
+  EXPECT_EQ(units.load(), 64);
+  if (CpuKernelUtils::GetCPUNum(ctx) > 1) {
+    EXPECT_GT(shards.load(), 1);
+  }
+
+  // without a cost model the unit size comes from the cost
+  EXPECT_EQ(CostToUnitSize(cheap), static_cast<int64_t>(kMinShardCycles));
+  EXPECT_EQ(CostToUnitSize(heavy), 1);
+}
+
+// a shard starting a parallel for on the Eigen pool runs it inline on its
+// own thread, the pool threads may all be busy with the outer one
+TEST_F(TEST_HOST_SHARDER_UT, NESTED_PARALLEL_FOR_RUNS_INLINE) {
+  CpuKernelContext ctx(HOST);
+  const int64_t kOuter = 16;
+  const int64_t kInner = 1000;
+  std::atomic<int64_t> inner_shards(0);
+  std::atomic<int64_t> inner_units(0);
+  std::atomic<int64_t> other_thread(0);
+  uint32_t ret = CpuKernelUtils::ParallelFor(
+      ctx, kOuter, 1, [&](int64_t start, int64_t end) {
+        std::thread::id outer_thread = std::this_thread::get_id();
+        for (int64_t i = start; i < end; ++i) {
+          (void)CpuKernelUtils::ParallelFor(
+              ctx, kInner, 1, [&](int64_t first, int64_t last) {
+                inner_shards++;
+                inner_units += last - first;
+                other_thread +=
+                    (std::this_thread::get_id() != outer_thread) ? 1 : 0;
+              });
+        }
+      });
+  EXPECT_EQ(ret, 0);
+  EXPECT_EQ(inner_shards.load(), kOuter);
+  EXPECT_EQ(inner_units.load(), kOuter * kInner);
+  EXPECT_EQ(other_thread.load(), 0);
+
+  // a parallel for after the nested ones is sharded again
+  std::atomic<int64_t> units(0);
+  ret = CpuKernelUtils::ParallelFor(ctx, kInner, 1,
+                                    [&units](int64_t first, int64_t last) {
+                                      units += last - first;
+                                    });
+  EXPECT_EQ(ret, 0);
+  EXPECT_EQ(units.load(), kInner);
+  EXPECT_NE(CpuKernelUtils::ParallelFor(ctx, kInner, 1, nullptr), 0);
+}
+
+// every thread of the work stealing pool starts a nested parallel for at
+// once, each is a job of its own and no thread waits on a busy one
+TEST_F(TEST_HOST_SHARDER_UT, WORK_STEALING_NESTED_PARALLEL_FOR) {
+  WorkStealingPool pool(kThreadNum, {});
+  const int64_t kInner = 257;
+  std::vector<std::atomic<int32_t>> visits(kThreadNum * kInner);
+  for (auto &visit : visits) {
+    visit.store(0);
+  }
+  std::atomic<uint32_t> started(0);
+  std::atomic<bool> timed_out(false);
+  pool.ParallelFor(kThreadNum, 1, [&](int64_t start, int64_t end) {
+    // hold every outer shard until all of them run, each on its own thread
+    started++;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started.load() < kThreadNum) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        timed_out = true;
+        break;
+      }
+      std::this_thread::yield();
+    }
+    for (int64_t i = start; i < end; ++i) {
+      pool.ParallelFor(kInner, 1, [&visits, i, kInner](int64_t first,
+                                                       int64_t last) {
+        for (int64_t j = first; j < last; ++j) {
+          visits[i * kInner + j]++;
+        }
+      });
+    }
+  });
+  EXPECT_FALSE(timed_out.load());
+  int64_t wrong = 0;
+  for (auto &visit : visits) {
+    wrong += (visit.load() != 1) ? 1 : 0;
+  }
+  EXPECT_EQ(wrong, 0);
+}
+
+// per parallel for latency of both pools, one caller and as many callers
+// as threads, on cheap even units and on units of growing cost
+TEST_F(TEST_HOST_SHARDER_UT, BENCHMARK_AGAINST_EIGEN) {
+  EigenThreadPool *eigen = EigenThreadPool::GetInstance();
+  ASSERT_NE(eigen, nullptr);
+  WorkStealingPool *stealing = WorkStealingPool::GetInstance();
+  int caller_max = static_cast<int>(stealing->GetCPUNum());
+  cout << "threads " << stealing->GetCPUNum() << endl;
+  struct Case {
+    const char *name;
+    int64_t total;
+    int64_t per_unit_size;
+    bool uneven;
+    int repeat;
+  };
+  const Case kCases[] = {{"small even", 4096, 256, false, 2000},
+                         {"large even", 1 << 20, 4096, false, 50},
+                         {"uneven", 4096, 16, true, 50}};
+  for (const Case &c : kCases) {
+    for (int callers = 1; callers <= caller_max;
+         callers = (callers == caller_max) ? callers + 1 : caller_max) {
+      double eigen_us = RunParallelFors(eigen, callers, c.repeat, c.total,
+                                        c.per_unit_size, c.uneven);
+      double stealing_us = RunParallelFors(stealing, callers, c.repeat,
+                                           c.total, c.per_unit_size, c.uneven);
+      cout << c.name << ", " << callers << " callers: eigen " << eigen_us
+           << " us, work stealing " << stealing_us << " us" << endl;
+    }
+  }
+}
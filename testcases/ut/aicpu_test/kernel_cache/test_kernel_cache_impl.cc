@@ -0,0 +1,208 @@
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "kernel_cache.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_KERNEL_CACHE_UT : public testing::Test {};
+
+namespace {
+const uint32_t kLruCapacity = 256;
+
+struct CacheData {
+  explicit CacheData(uint64_t id) : id(id) {}
+  uint64_t id;
+};
+
+class TestKernelCache : public KernelCache<CacheData> {
+ public:
+  int32_t RunKernel(void *param) override { return 0; }
+
+ protected:
+  int32_t InitParameter() override {
+    if (!GetSessionFlag()) {
+      SetCapacity(kLruCapacity);
+    }
+    return 0;
+  }
+};
+
+// the cache before sharding: one mutex, exact lru by list splicing
+class MutexLruCache {
+ public:
+  std::shared_ptr<CacheData> GetCache(uint64_t key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = iters_.find(key);
+    if (it == iters_.end()) {
+      return nullptr;
+    }
+    auto pair = *it->second;
+    list_.erase(it->second);
+    list_.push_front(pair);
+    it->second = list_.begin();
+    return pair.second;
+  }
+
+  void SetCache(uint64_t key, std::shared_ptr<CacheData> value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = iters_.find(key);
+    if (it != iters_.end()) {
+      list_.erase(it->second);
+      iters_.erase(it);
+    }
+    if (list_.size() > kLruCapacity) {
+      iters_.erase(list_.back().first);
+      list_.pop_back();
+    }
+    list_.emplace_front(key, value);
+    iters_[key] = list_.begin();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::list<std::pair<uint64_t, std::shared_ptr<CacheData>>> list_;
+  std::unordered_map<
+      uint64_t,
+      std::list<std::pair<uint64_t, std::shared_ptr<CacheData>>>::iterator>
+      iters_;
+};
+
+// launches per thread: mostly hits on a hot working set, a miss every 64
+template <class Cache>
+double RunLaunches(Cache &cache, int thread_num, int launches) {
+  std::atomic<int64_t> found(0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&cache, &found, t, launches]() {
+      int64_t local_found = 0;
+      for (int i = 0; i < launches; ++i) {
+        uint64_t key = (i % 64 == 63) ? 100000 + t * launches + i : (i * 7 + t) % 128;
+        std::shared_ptr<CacheData> data = cache.GetCache(key);
+        if (data == nullptr) {
+          cache.SetCache(key, std::make_shared<CacheData>(key));
+        } else {
+          local_found++;
+        }
+      }
+      found += local_found;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_GT(found.load(), 0);
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         (static_cast<double>(thread_num) * launches);
+}
+}  // namespace
+
+TEST_F(TEST_KERNEL_CACHE_UT, SESSION_CACHE_NEVER_EVICTS) {
+  TestKernelCache cache;
+  ASSERT_EQ(cache.Init(true), 0);
+  const uint64_t kKernelNum = 5000;
+  for (uint64_t id = 0; id < kKernelNum; ++id) {
+    cache.SetCache(id, std::make_shared<CacheData>(id));
+  }
+  int64_t missing = 0;
+  for (uint64_t id = 0; id < kKernelNum; ++id) {
+    std::shared_ptr<CacheData> data = cache.GetCache(id);
+    missing += (data == nullptr || data->id != id) ? 1 : 0;
+  }
+  EXPECT_EQ(missing, 0);
+  EXPECT_EQ(cache.GetAllKernelCache().size(), kKernelNum);
+  EXPECT_EQ(cache.GetCache(kKernelNum), nullptr);
+}
+
+TEST_F(TEST_KERNEL_CACHE_UT, SET_CACHE_REPLACES_VALUE) {
+  TestKernelCache cache;
+  ASSERT_EQ(cache.Init(false), 0);
+  cache.SetCache(0, std::make_shared<CacheData>(1));
+  cache.SetCache(0, std::make_shared<CacheData>(2));
+  ASSERT_NE(cache.GetCache(0), nullptr);
+  EXPECT_EQ(cache.GetCache(0)->id, 2);
+  EXPECT_EQ(cache.GetAllKernelCache().size(), 1);
+}
+
+// kernels launched between misses survive a stream of one-off kernels
+TEST_F(TEST_KERNEL_CACHE_UT, LRU_CACHE_KEEPS_HOT_KERNELS) {
+  TestKernelCache cache;
+  ASSERT_EQ(cache.Init(false), 0);
+  const uint64_t kHotNum = 64;
+  for (uint64_t id = 0; id < kHotNum; ++id) {
+    cache.SetCache(id, std::make_shared<CacheData>(id));
+  }
+  int64_t hot_misses = 0;
+  for (uint64_t cold = 1000; cold < 20000; ++cold) {
+    cache.SetCache(cold, std::make_shared<CacheData>(cold));
+    for (uint64_t id = 0; id < kHotNum; ++id) {
+      hot_misses += cache.GetCache(id) == nullptr ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(hot_misses, 0);
+  EXPECT_LE(cache.GetAllKernelCache().size(), kLruCapacity * 2);
+}
+
+// an entry handed out by GetCache outlives its eviction
+TEST_F(TEST_KERNEL_CACHE_UT, EVICTED_ENTRY_STAYS_VALID) {
+  TestKernelCache cache;
+  ASSERT_EQ(cache.Init(false), 0);
+  cache.SetCache(0, std::make_shared<CacheData>(0));
+  std::shared_ptr<CacheData> data = cache.GetCache(0);
+  ASSERT_NE(data, nullptr);
+  cache.SetCache(0, std::make_shared<CacheData>(1));
+  for (uint64_t id = 1; id < 20000; ++id) {
+    cache.SetCache(id, std::make_shared<CacheData>(id));
+  }
+  EXPECT_EQ(data.use_count(), 1);
+  EXPECT_EQ(data->id, 0);
+}
+
+// a working set within the capacity, every thread must only see its own kernel ids
+TEST_F(TEST_KERNEL_CACHE_UT, CONCURRENT_GET_SET) {
+  TestKernelCache cache;
+  ASSERT_EQ(cache.Init(false), 0);
+  std::atomic<int64_t> wrong(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&cache, &wrong, t]() {
+      for (uint64_t i = 0; i < 20000; ++i) {
+        uint64_t key = (i * 31 + t) % 128;
+        std::shared_ptr<CacheData> data = cache.GetCache(key);
+        if (data == nullptr) {
+          cache.SetCache(key, std::make_shared<CacheData>(key));
+        } else if (data->id != key) {
+          wrong++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(wrong.load(), 0);
+}
+
+// contention benchmark: sharded lock-free lookups against the single mutex lru
+TEST_F(TEST_KERNEL_CACHE_UT, BENCHMARK_CONTENTION) {
+  const int kLaunches = 200000;
+  int max_threads = std::max(4u, std::thread::hardware_concurrency());
+  for (int thread_num = 1; thread_num <= max_threads; thread_num *= 2) {
+    TestKernelCache sharded;
+    ASSERT_EQ(sharded.Init(false), 0);
+    MutexLruCache mutex_lru;
+    double sharded_ns = RunLaunches(sharded, thread_num, kLaunches);
+    double mutex_ns = RunLaunches(mutex_lru, thread_num, kLaunches);
+    cout << thread_num << " threads: sharded " << sharded_ns
+         << " ns/launch, mutex lru " << mutex_ns << " ns/launch" << endl;
+  }
+}
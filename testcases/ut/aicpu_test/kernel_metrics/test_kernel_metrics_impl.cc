@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cpu_context.h"
+#include "cpu_kernel.h"
+#include "cpu_kernel_register.h"
+#include "kernel_metrics.h"
+#include "node_def_builder.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_KERNEL_METRICS_UT : public testing::Test {};
+
+namespace {
+const uint32_t kThreadNum = 8;
+
+// spins for g_compute_ns, fails while g_fail is set
+std::atomic<uint64_t> g_compute_ns(0);
+std::atomic<bool> g_fail(false);
+
+class MetricsProbeKernel : public CpuKernel {
+ public:
+  uint32_t Compute(CpuKernelContext &ctx) override {
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::nanoseconds(g_compute_ns.load());
+    while (std::chrono::steady_clock::now() < end) {
+    }
+    return g_fail.load() ? KERNEL_STATUS_INNER_ERROR : KERNEL_STATUS_OK;
+  }
+};
+
+void RegisterProbe() {
+  static bool registered = RegistCpuKernel("MetricsProbe", []() {
+    return std::shared_ptr<CpuKernel>(new MetricsProbeKernel());
+  });
+  (void)registered;
+}
+
+// value of a numeric member in the first object after "after" in json
+double JsonNumber(const std::string &json, const std::string &after,
+                  const std::string &key) {
+  size_t pos = json.find(after);
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  pos = json.find("\"" + key + "\":", pos);
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  return atof(json.c_str() + pos + key.size() + 3);
+}
+}  // namespace
+
+// every value lands in a bucket whose upper bound is within 1/16 above it
+TEST_F(TEST_KERNEL_METRICS_UT, HISTOGRAM_BUCKETS_BOUND_VALUES) {
+  int64_t wrong = 0;
+  uint32_t last_index = 0;
+  for (uint64_t value = 0; value < (1ULL << 40); value = value * 17 / 16 + 1) {
+    uint32_t index = LatencyHistogram::BucketIndex(value);
+    uint64_t upper = LatencyHistogram::BucketUpperBound(index);
+    wrong += (index < last_index || index >= LatencyHistogram::kBucketNum) ? 1 : 0;
+    wrong += (upper < value || upper - value > value / 16) ? 1 : 0;
+    wrong += (index > 0 &&
+              LatencyHistogram::BucketUpperBound(index - 1) >= value) ? 1 : 0;
+    last_index = index;
+  }
+  EXPECT_EQ(wrong, 0);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(~0ULL), LatencyHistogram::kBucketNum - 1);
+}
+
+TEST_F(TEST_KERNEL_METRICS_UT, HISTOGRAM_PERCENTILES) {
+  LatencyHistogram hist;
+  EXPECT_EQ(hist.Percentile(99), 0);
+  for (uint64_t value = 1; value <= 100000; ++value) {
+    hist.Record(value);
+  }
+  EXPECT_EQ(hist.Count(), 100000);
+  EXPECT_EQ(hist.Max(), 100000);
+  EXPECT_EQ(hist.Sum(), 100000ULL * 100001 / 2);
+  EXPECT_NEAR(hist.Percentile(50), 50000, 50000 / 16);
+  EXPECT_NEAR(hist.Percentile(90), 90000, 90000 / 16);
+  EXPECT_NEAR(hist.Percentile(99), 99000, 99000 / 16);
+  EXPECT_EQ(hist.Percentile(100), 100000);
+
+  // a slow tail the mean hides
+  LatencyHistogram tail;
+  for (int i = 0; i < 990; ++i) {
+    tail.Record(1000);
+  }
+  for (int i = 0; i < 10; ++i) {
+    tail.Record(1000000);
+  }
+  EXPECT_LE(tail.Percentile(50), 1000 + 1000 / 16);
+  EXPECT_LE(tail.Percentile(99), 1000 + 1000 / 16);
+  EXPECT_GE(tail.Percentile(99.5), 1000000);
+  tail.Reset();
+  EXPECT_EQ(tail.Count(), 0);
+  EXPECT_EQ(tail.Max(), 0);
+}
+
+TEST_F(TEST_KERNEL_METRICS_UT, CONCURRENT_RECORD) {
+  LatencyHistogram hist;
+  const uint64_t kRecordNum = 100000;
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kThreadNum; ++t) {
+    threads.emplace_back([&hist, t, kRecordNum]() {
+      for (uint64_t i = 0; i < kRecordNum; ++i) {
+        hist.Record(i + t);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(hist.Count(), kThreadNum * kRecordNum);
+  EXPECT_EQ(hist.Max(), kRecordNum - 1 + kThreadNum - 1);
+}
+
+// an op type gets one metrics object, whichever thread sees it first
+TEST_F(TEST_KERNEL_METRICS_UT, REGISTRY_TRACKS_OP_TYPES) {
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  const int kTypeNum = 64;
+  std::vector<std::vector<KernelMetrics *>> seen(kThreadNum);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kThreadNum; ++t) {
+    threads.emplace_back([&registry, &seen, t, kTypeNum]() {
+      for (int i = 0; i < kTypeNum; ++i) {
+        seen[t].push_back(registry.GetKernelMetrics("Type" + std::to_string(i)));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int64_t wrong = 0;
+  for (int i = 0; i < kTypeNum; ++i) {
+    KernelMetrics *metrics = seen[0][i];
+    wrong += (metrics == nullptr ||
+              metrics->op_type != "Type" + std::to_string(i)) ? 1 : 0;
+    for (uint32_t t = 1; t < kThreadNum; ++t) {
+      wrong += seen[t][i] != metrics ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(wrong, 0);
+}
+
+TEST_F(TEST_KERNEL_METRICS_UT, RUN_CPU_KERNEL_RECORDS_COMPUTE_TIME) {
+  RegisterProbe();
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  registry.Reset();
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "MetricsProbe", "MetricsProbe");
+  CpuKernelContext ctx(HOST);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+
+  g_compute_ns = 200000;
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(CpuKernelRegister::Instance().RunCpuKernel(ctx), KERNEL_STATUS_OK);
+  }
+  g_fail = true;
+  EXPECT_NE(CpuKernelRegister::Instance().RunCpuKernel(ctx), KERNEL_STATUS_OK);
+  g_fail = false;
+
+  KernelMetrics *metrics = registry.GetKernelMetrics("MetricsProbe");
+  ASSERT_NE(metrics, nullptr);
+  EXPECT_EQ(metrics->compute_time.Count(), 21);
+  EXPECT_EQ(metrics->failures.load(), 1);
+  EXPECT_GE(metrics->compute_time.Percentile(50), 200000);
+
+  registry.SetEnabled(false);
+  EXPECT_EQ(CpuKernelRegister::Instance().RunCpuKernel(ctx), KERNEL_STATUS_OK);
+  registry.SetEnabled(true);
+  EXPECT_EQ(metrics->compute_time.Count(), 21);
+
+  std::string json = registry.Dump();
+  EXPECT_NE(json.find("\"op_type\":\"MetricsProbe\""), std::string::npos);
+  EXPECT_EQ(JsonNumber(json, "\"MetricsProbe\"", "count"), 21);
+  EXPECT_EQ(JsonNumber(json, "\"MetricsProbe\"", "failures"), 1);
+  EXPECT_GE(JsonNumber(json, "\"MetricsProbe\"", "p99_us"), 200);
+  EXPECT_GE(JsonNumber(json, "\"launch\"", "context_cache_hits"), 0);
+  EXPECT_GE(JsonNumber(json, "\"ext_info_parse\"", "p99_us"), 0);
+  g_compute_ns = 0;
+}
+
+TEST_F(TEST_KERNEL_METRICS_UT, SNAPSHOT_WRITER) {
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  registry.GetKernelMetrics("SnapshotProbe")->compute_time.Record(5000);
+  std::string path = "kernel_metrics_" + std::to_string(getpid()) + ".json";
+  (void)remove(path.c_str());
+  registry.StartSnapshotWriter(path, 20);
+  std::string content;
+  for (int i = 0; i < 200 && content.empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::ifstream file(path);
+    std::stringstream buf;
+    buf << file.rdbuf();
+    content = buf.str();
+  }
+  registry.StopSnapshotWriter();
+  EXPECT_NE(content.find("\"op_type\":\"SnapshotProbe\""), std::string::npos);
+  EXPECT_EQ(content.back(), '\n');
+  EXPECT_TRUE(registry.WriteSnapshot(path));
+  EXPECT_FALSE(registry.WriteSnapshot("no_such_dir/metrics.json"));
+  (void)remove(path.c_str());
+}
+
+// what a launch pays: a record into the histogram, against the event log
+// line every launch used to print
+TEST_F(TEST_KERNEL_METRICS_UT, BENCHMARK_RECORD) {
+  const int kLaunches = 1000000;
+  KernelMetricsRegistry &registry = KernelMetricsRegistry::Instance();
+  std::string type = "BenchmarkProbe";
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLaunches; ++i) {
+    auto begin = std::chrono::steady_clock::now();
+    KernelMetrics *metrics = registry.GetKernelMetrics(type);
+    metrics->compute_time.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count()));
+  }
+  double record_ns = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start).count() / kLaunches;
+
+  char line[256];
+  FILE *null_file = fopen("/dev/null", "w");
+  ASSERT_NE(null_file, nullptr);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLaunches; ++i) {
+    auto begin = std::chrono::steady_clock::now();
+    double dr_us = std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - begin).count();
+    int len = snprintf(line, sizeof(line),
+                       "[EVENT] [CCECPU][%s]RunCpuKernel[%s], run time is [%lf] us.\n",
+                       __FILE__, type.c_str(), dr_us);
+    fwrite(line, 1, len, null_file);
+  }
+  double log_ns = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - start).count() / kLaunches;
+  fclose(null_file);
+  cout << "record " << record_ns << " ns/launch, event log line " << log_ns
+       << " ns/launch" << endl;
+  EXPECT_EQ(registry.GetKernelMetrics(type)->compute_time.Count(), kLaunches);
+}
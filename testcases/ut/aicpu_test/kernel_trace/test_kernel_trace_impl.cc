@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "cpu_context.h"
+#include "cpu_kernel.h"
+#include "cpu_kernel_register.h"
+#include "cpu_kernel_utils.h"
+#include "kernel_trace.h"
+#include "node_def_builder.h"
+
+using namespace std;
+using namespace aicpu;
+
+class TEST_KERNEL_TRACE_UT : public testing::Test {
+ protected:
+  void TearDown() override { KernelTracer::Instance().Disable(); }
+};
+
+namespace {
+// sums a vector in shards, each shard sleeps so the pool threads take some
+class TraceProbeKernel : public CpuKernel {
+ public:
+  uint32_t Compute(CpuKernelContext &ctx) override {
+    std::vector<int64_t> sums(16, 0);
+    return CpuKernelUtils::ParallelFor(ctx, 16, 1, [&sums](int64_t start, int64_t end) {
+      for (int64_t i = start; i < end; ++i) {
+        sums[i] = i;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    });
+  }
+};
+
+void RegisterProbe() {
+  static bool registered = RegistCpuKernel("TraceProbe", []() {
+    return std::shared_ptr<CpuKernel>(new TraceProbeKernel());
+  });
+  (void)registered;
+}
+
+size_t CountOf(const std::string &text, const std::string &pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+// the events of a chrome trace, one string each
+std::vector<std::string> Events(const std::string &json) {
+  std::vector<std::string> events;
+  size_t pos = json.find("{\"name\":");
+  while (pos != std::string::npos) {
+    size_t next = json.find("{\"name\":", pos + 1);
+    events.push_back(json.substr(pos, next == std::string::npos ? next : next - pos));
+    pos = next;
+  }
+  return events;
+}
+
+double Number(const std::string &event, const std::string &key) {
+  size_t pos = event.find("\"" + key + "\":");
+  return pos == std::string::npos ? -1 : atof(event.c_str() + pos + key.size() + 3);
+}
+}  // namespace
+
+TEST_F(TEST_KERNEL_TRACE_UT, TRACING_OFF_RECORDS_NOTHING) {
+  KernelTracer &tracer = KernelTracer::Instance();
+  tracer.Enable(64);
+  tracer.Disable();
+  {
+    TraceLaunchScope launch;
+    TraceScope trace("Disabled");
+  }
+  EXPECT_EQ(tracer.Dump().find("Disabled"), std::string::npos);
+}
+
+// spans carry the launch they run for, an inner one lies within the outer one
+TEST_F(TEST_KERNEL_TRACE_UT, SCOPES_CARRY_LAUNCH) {
+  KernelTracer &tracer = KernelTracer::Instance();
+  tracer.Enable(64);
+  {
+    TraceLaunchScope launch;
+    KernelTracer::CurrentLaunch().task_id = 7;
+    KernelTracer::CurrentLaunch().stream_id = 3;
+    KernelTracer::CurrentLaunch().SetOpType(
+        "AnOpTypeLongerThanThirtyTwoCharacters");
+    TraceScope outer("Outer");
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    {
+      TraceScope inner("Inner");
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+  EXPECT_EQ(KernelTracer::CurrentLaunch().task_id, 0);
+  auto events = Events(tracer.Dump());
+  ASSERT_EQ(events.size(), 2);
+  // spans are recorded when they end
+  EXPECT_NE(events[0].find("\"name\":\"Inner\""), std::string::npos);
+  EXPECT_NE(events[1].find("\"name\":\"Outer\""), std::string::npos);
+  for (auto &event : events) {
+    EXPECT_NE(event.find("\"op_type\":\"AnOpTypeLongerThanThirtyTwoChar\""),
+              std::string::npos);
+    EXPECT_EQ(Number(event, "stream_id"), 3);
+    EXPECT_EQ(Number(event, "task_id"), 7);
+    EXPECT_NE(event.find("\"ph\":\"X\""), std::string::npos);
+  }
+  EXPECT_GE(Number(events[0], "ts"), Number(events[1], "ts"));
+  EXPECT_LE(Number(events[0], "ts") + Number(events[0], "dur"),
+            Number(events[1], "ts") + Number(events[1], "dur"));
+  EXPECT_GE(Number(events[1], "dur"), 200);
+}
+
+TEST_F(TEST_KERNEL_TRACE_UT, RING_KEEPS_LATEST_EVENTS) {
+  KernelTracer &tracer = KernelTracer::Instance();
+  tracer.Enable(8);
+  TraceLaunch launch;
+  for (uint64_t i = 1; i <= 20; ++i) {
+    tracer.Record("Ring", launch, i * 1000, i * 1000 + 1);
+  }
+  auto events = Events(tracer.Dump());
+  ASSERT_EQ(events.size(), 8);
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(Number(events[i], "ts"), 13 + i);
+  }
+  tracer.Enable(8);
+  EXPECT_TRUE(Events(tracer.Dump()).empty());
+}
+
+// the shards of a kernel belong to its launch on whichever thread they run
+TEST_F(TEST_KERNEL_TRACE_UT, SHARDS_BELONG_TO_LAUNCH) {
+  RegisterProbe();
+  auto node_def = NodeDefBuilder::CreateNodeDef();
+  NodeDefBuilder(node_def.get(), "TraceProbe", "TraceProbe");
+  CpuKernelContext ctx(HOST);
+  ASSERT_EQ(ctx.Init(node_def.get()), 0);
+
+  KernelTracer &tracer = KernelTracer::Instance();
+  tracer.Enable(1024);
+  {
+    TraceLaunchScope launch;
+    KernelTracer::CurrentLaunch().task_id = 11;
+    ASSERT_EQ(CpuKernelRegister::Instance().RunCpuKernel(ctx), 0);
+  }
+  // a thread outside the launch
+  std::thread([&tracer]() { TraceScope trace("Other"); }).join();
+  std::string json = tracer.Dump();
+  EXPECT_EQ(CountOf(json, "\"name\":\"Compute\""), 1);
+  EXPECT_EQ(CountOf(json, "\"name\":\"Other\""), 1);
+  size_t shards = 0;
+  int64_t wrong = 0;
+  for (auto &event : Events(json)) {
+    if (event.find("\"name\":\"Other\"") != std::string::npos) {
+      wrong += Number(event, "task_id") != 0 ? 1 : 0;
+      continue;
+    }
+    shards += event.find("\"name\":\"Shard\"") != std::string::npos ? 1 : 0;
+    wrong += event.find("\"op_type\":\"TraceProbe\"") == std::string::npos ? 1 : 0;
+    wrong += Number(event, "task_id") != 11 ? 1 : 0;
+  }
+  EXPECT_GE(shards, 1);
+  EXPECT_EQ(wrong, 0);
+}
+
+TEST_F(TEST_KERNEL_TRACE_UT, WRITE_TRACE) {
+  KernelTracer &tracer = KernelTracer::Instance();
+  tracer.Enable(16);
+  { TraceScope trace("Written"); }
+  std::string path = "kernel_trace_" + std::to_string(getpid()) + ".json";
+  ASSERT_TRUE(tracer.WriteTrace(path));
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_EQ(content.str().find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0);
+  EXPECT_NE(content.str().find("\"name\":\"Written\""), std::string::npos);
+  EXPECT_EQ(content.str().substr(content.str().size() - 3), "]}\n");
+  (void)remove(path.c_str());
+  EXPECT_FALSE(tracer.WriteTrace("no_such_dir/trace.json"));
+}
+
+// what a span costs a launch with tracing off and on
+TEST_F(TEST_KERNEL_TRACE_UT, BENCHMARK_SCOPE) {
+  const int kSpans = 1000000;
+  KernelTracer &tracer = KernelTracer::Instance();
+  for (int enabled = 0; enabled < 2; ++enabled) {
+    if (enabled != 0) {
+      tracer.Enable(16384);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSpans; ++i) {
+      TraceScope trace("Benchmark");
+    }
+    double span_ns = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start).count() / kSpans;
+    cout << (enabled != 0 ? "tracing on " : "tracing off ") << span_ns
+         << " ns/span" << endl;
+  }
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#include "HostBufferPool.h"
+
+#include <cstdlib>
+#include <iostream>
+#include "HostPinnedMem.h"
+
+using namespace std;
+
+HostBuffer::HostBuffer(HostBufferPool *pool, void *data, size_t size, bool pinned)
+    : pool_(pool), data_(data), size_(size), pinned_(pinned)
+{
+}
+
+HostBuffer::~HostBuffer()
+{
+    Release();
+}
+
+HostBuffer::HostBuffer(HostBuffer &&other) noexcept
+    : pool_(other.pool_), data_(other.data_), size_(other.size_), pinned_(other.pinned_)
+{
+    other.pool_ = nullptr;
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+HostBuffer &HostBuffer::operator=(HostBuffer &&other) noexcept
+{
+    if (this != &other) {
+        Release();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        size_ = other.size_;
+        pinned_ = other.pinned_;
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void HostBuffer::Release()
+{
+    if (pool_ != nullptr && data_ != nullptr) {
+        pool_->Recycle(data_, size_, pinned_);
+    }
+    pool_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+}
+
+HostBufferPool::HostBufferPool(HostMemType type) : type_(type)
+{
+}
+
+HostBufferPool::~HostBufferPool()
+{
+    Clear();
+    if (allocated_ != 0) {
+        cout << allocated_ << " host buffers still borrowed when the pool goes away" << endl;
+    }
+}
+
+int HostBufferPool::Reserve(size_t size, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        Block block;
+        if (!Allocate(size, block)) {
+            return -1;
+        }
+        lock_guard<mutex> lock(mutex_);
+        idle_[size].push_back(block);
+    }
+    return 0;
+}
+
+HostBuffer HostBufferPool::Acquire(size_t size)
+{
+    Block block;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = idle_.find(size);
+        if (it != idle_.end() && !it->second.empty()) {
+            block = it->second.back();
+            it->second.pop_back();
+            return HostBuffer(this, block.data, size, block.pinned);
+        }
+    }
+    if (!Allocate(size, block)) {
+        return HostBuffer();
+    }
+    return HostBuffer(this, block.data, size, block.pinned);
+}
+
+void HostBufferPool::Clear()
+{
+    lock_guard<mutex> lock(mutex_);
+    for (auto &sized : idle_) {
+        for (auto &block : sized.second) {
+            Free(block);
+        }
+    }
+    idle_.clear();
+}
+
+size_t HostBufferPool::Allocated() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return allocated_;
+}
+
+size_t HostBufferPool::Idle() const
+{
+    lock_guard<mutex> lock(mutex_);
+    size_t idle = 0;
+    for (const auto &sized : idle_) {
+        idle += sized.second.size();
+    }
+    return idle;
+}
+
+bool HostBufferPool::Allocate(size_t size, Block &block)
+{
+    block.data = nullptr;
+    block.pinned = false;
+    if (size == 0) {
+        cout << "host buffer of size 0 requested" << endl;
+        return false;
+    }
+    if (type_ == HostMemType::PINNED) {
+        int ret = HostPinnedMalloc(&block.data, size);
+        if (ret == 0 && block.data != nullptr) {
+            block.pinned = true;
+        } else {
+            block.data = nullptr;
+            lock_guard<mutex> lock(mutex_);
+            if (!warned_) {
+                cout << "aclrtMallocHost faild, ret = " << ret << ", host buffers fall back to the heap" << endl;
+                warned_ = true;
+            }
+        }
+    }
+    if (block.data == nullptr) {
+        block.data = malloc(size);
+        if (block.data == nullptr) {
+            cout << "Failed to malloc host buffer of " << size << " bytes" << endl;
+            return false;
+        }
+    }
+    lock_guard<mutex> lock(mutex_);
+    allocated_++;
+    return true;
+}
+
+// called with mutex_ held
+void HostBufferPool::Free(Block &block)
+{
+    if (block.pinned) {
+        HostPinnedFree(block.data);
+    } else {
+        free(block.data);
+    }
+    block.data = nullptr;
+    allocated_--;
+}
+
+void HostBufferPool::Recycle(void *data, size_t size, bool pinned)
+{
+    lock_guard<mutex> lock(mutex_);
+    idle_[size].push_back(Block{data, pinned});
+}
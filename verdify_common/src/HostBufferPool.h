@@ -0,0 +1,93 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#ifndef HOST_BUFFER_POOL_H
+#define HOST_BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Where a HostBufferPool takes its memory from. PINNED goes through HostPinnedMalloc
+// and falls back to the heap when the runtime refuses, HEAP never calls into ACL
+enum class HostMemType {
+    PINNED,
+    HEAP
+};
+
+class HostBufferPool;
+
+// A buffer borrowed from a HostBufferPool, given back to it when the handle is
+// released or destroyed. The pool has to outlive its handles
+class HostBuffer {
+public:
+    HostBuffer() = default;
+    ~HostBuffer();
+    HostBuffer(HostBuffer &&other) noexcept;
+    HostBuffer &operator=(HostBuffer &&other) noexcept;
+    HostBuffer(const HostBuffer &) = delete;
+    HostBuffer &operator=(const HostBuffer &) = delete;
+
+    uint8_t *data() const { return static_cast<uint8_t *>(data_); }
+    size_t size() const { return size_; }
+    // false when the buffer came from the heap, device copies from it are then staged by the runtime
+    bool pinned() const { return pinned_; }
+    explicit operator bool() const { return data_ != nullptr; }
+
+    // hand the buffer back to the pool early, the handle is empty afterwards
+    void Release();
+
+private:
+    friend class HostBufferPool;
+    HostBuffer(HostBufferPool *pool, void *data, size_t size, bool pinned);
+
+    HostBufferPool *pool_ = nullptr;
+    void *data_ = nullptr;
+    size_t size_ = 0;
+    bool pinned_ = false;
+};
+
+// Page-locked host buffers recycled by size. Reserve them once from the model
+// desc, frames then only Acquire and release and never reach the allocator
+class HostBufferPool {
+public:
+    explicit HostBufferPool(HostMemType type = HostMemType::PINNED);
+    ~HostBufferPool();
+    HostBufferPool(const HostBufferPool &) = delete;
+    HostBufferPool &operator=(const HostBufferPool &) = delete;
+
+    // allocate count more idle buffers of size
+    int Reserve(size_t size, size_t count);
+
+    // an idle buffer of exactly size, allocated if none is left. Empty on failure
+    HostBuffer Acquire(size_t size);
+
+    // free the idle buffers, call it before the ACL context goes away
+    void Clear();
+
+    size_t Allocated() const;  // buffers owned, idle or borrowed
+    size_t Idle() const;
+
+private:
+    friend class HostBuffer;
+
+    struct Block {
+        void *data;
+        bool pinned;
+    };
+
+    bool Allocate(size_t size, Block &block);
+    void Free(Block &block);
+    void Recycle(void *data, size_t size, bool pinned);
+
+    HostMemType type_;
+    mutable std::mutex mutex_;  // handles may be released from another thread
+    std::unordered_map<size_t, std::vector<Block>> idle_;
+    size_t allocated_ = 0;
+    bool warned_ = false;
+};
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#include "HostPinnedMem.h"
+
+#include "acl/acl.h"
+
+int HostPinnedMalloc(void **ptr, size_t size)
+{
+    return static_cast<int>(aclrtMallocHost(ptr, size));
+}
+
+void HostPinnedFree(void *ptr)
+{
+    aclrtFreeHost(ptr);
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#ifndef HOST_PINNED_MEM_H
+#define HOST_PINNED_MEM_H
+
+#include <cstddef>
+
+// The page-locked allocator behind HostBufferPool's PINNED mode. HostPinnedMem.cpp
+// implements it with aclrtMallocHost and aclrtFreeHost, so HostBufferPool.cpp
+// itself builds and runs without the ACL runtime
+
+// 0 on success, the ACL error code otherwise
+int HostPinnedMalloc(void **ptr, size_t size);
+void HostPinnedFree(void *ptr);
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include "HostBufferPool.h"
+#include "HostPinnedMem.h"
+
+using namespace std;
+
+// stands in for HostPinnedMem.cpp, pinned blocks come from the heap and are tracked
+// so the test can tell them apart and refuse them on demand
+namespace {
+set<void *> g_pinned;
+int g_pinnedError = 0;
+}
+
+int HostPinnedMalloc(void **ptr, size_t size)
+{
+    if (g_pinnedError != 0) {
+        *ptr = nullptr;
+        return g_pinnedError;
+    }
+    *ptr = malloc(size);
+    g_pinned.insert(*ptr);
+    return 0;
+}
+
+void HostPinnedFree(void *ptr)
+{
+    EXPECT_EQ(g_pinned.erase(ptr), 1U);
+    free(ptr);
+}
+
+class TEST_HOST_BUFFER_POOL : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        g_pinned.clear();
+        g_pinnedError = 0;
+    }
+};
+
+TEST_F(TEST_HOST_BUFFER_POOL, HEAP_RESERVE_ACQUIRE_RELEASE)
+{
+    HostBufferPool pool(HostMemType::HEAP);
+    EXPECT_EQ(pool.Reserve(64, 2), 0);
+    EXPECT_EQ(pool.Allocated(), 2U);
+    EXPECT_EQ(pool.Idle(), 2U);
+
+    {
+        HostBuffer first = pool.Acquire(64);
+        HostBuffer second = pool.Acquire(64);
+        ASSERT_TRUE(first);
+        ASSERT_TRUE(second);
+        EXPECT_NE(first.data(), second.data());
+        EXPECT_EQ(first.size(), 64U);
+        EXPECT_FALSE(first.pinned());
+        EXPECT_EQ(pool.Idle(), 0U);
+
+        // none idle left, a third one is allocated
+        HostBuffer third = pool.Acquire(64);
+        ASSERT_TRUE(third);
+        EXPECT_EQ(pool.Allocated(), 3U);
+
+        first.Release();
+        EXPECT_FALSE(first);
+        EXPECT_EQ(pool.Idle(), 1U);
+    }
+    EXPECT_EQ(pool.Allocated(), 3U);
+    EXPECT_EQ(pool.Idle(), 3U);
+    EXPECT_TRUE(g_pinned.empty());
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, RECYCLE_BY_SIZE)
+{
+    HostBufferPool pool(HostMemType::HEAP);
+    uint8_t *small = nullptr;
+    {
+        HostBuffer buffer = pool.Acquire(16);
+        ASSERT_TRUE(buffer);
+        small = buffer.data();
+    }
+    EXPECT_EQ(pool.Idle(), 1U);
+
+    // a different size never gets the idle block
+    HostBuffer large = pool.Acquire(32);
+    ASSERT_TRUE(large);
+    EXPECT_NE(large.data(), small);
+    EXPECT_EQ(pool.Allocated(), 2U);
+
+    HostBuffer again = pool.Acquire(16);
+    EXPECT_EQ(again.data(), small);
+    EXPECT_EQ(pool.Allocated(), 2U);
+    EXPECT_EQ(pool.Idle(), 0U);
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, MOVE_KEEPS_ONE_OWNER)
+{
+    HostBufferPool pool(HostMemType::HEAP);
+    HostBuffer source = pool.Acquire(8);
+    ASSERT_TRUE(source);
+    uint8_t *data = source.data();
+
+    HostBuffer moved(std::move(source));
+    EXPECT_FALSE(source);
+    EXPECT_EQ(source.size(), 0U);
+    EXPECT_EQ(moved.data(), data);
+
+    HostBuffer assigned = pool.Acquire(8);
+    EXPECT_EQ(pool.Allocated(), 2U);
+    // the buffer assigned over goes back to the pool, the moved one changes hands
+    assigned = std::move(moved);
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(assigned.data(), data);
+    EXPECT_EQ(pool.Idle(), 1U);
+
+    moved.Release();
+    EXPECT_EQ(pool.Idle(), 1U);
+    assigned.Release();
+    EXPECT_EQ(pool.Idle(), 2U);
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, CLEAR_FREES_IDLE_ONLY)
+{
+    HostBufferPool pool(HostMemType::HEAP);
+    EXPECT_EQ(pool.Reserve(128, 3), 0);
+    HostBuffer borrowed = pool.Acquire(128);
+    ASSERT_TRUE(borrowed);
+
+    pool.Clear();
+    EXPECT_EQ(pool.Idle(), 0U);
+    EXPECT_EQ(pool.Allocated(), 1U);
+
+    borrowed.Release();
+    EXPECT_EQ(pool.Idle(), 1U);
+    pool.Clear();
+    EXPECT_EQ(pool.Allocated(), 0U);
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, SIZE_ZERO_FAILED)
+{
+    HostBufferPool pool(HostMemType::HEAP);
+    EXPECT_EQ(pool.Reserve(0, 1), -1);
+    HostBuffer buffer = pool.Acquire(0);
+    EXPECT_FALSE(buffer);
+    EXPECT_EQ(buffer.data(), nullptr);
+    EXPECT_EQ(pool.Allocated(), 0U);
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, PINNED_FREED_AS_PINNED)
+{
+    {
+        HostBufferPool pool(HostMemType::PINNED);
+        EXPECT_EQ(pool.Reserve(64, 2), 0);
+        EXPECT_EQ(g_pinned.size(), 2U);
+        HostBuffer buffer = pool.Acquire(64);
+        EXPECT_TRUE(buffer.pinned());
+        EXPECT_EQ(g_pinned.count(buffer.data()), 1U);
+    }
+    // the pool handed every pinned block back through HostPinnedFree
+    EXPECT_TRUE(g_pinned.empty());
+}
+
+TEST_F(TEST_HOST_BUFFER_POOL, PINNED_FALLS_BACK_TO_HEAP)
+{
+    HostBufferPool pool(HostMemType::PINNED);
+    g_pinnedError = 100000;
+    HostBuffer heap = pool.Acquire(64);
+    ASSERT_TRUE(heap);
+    EXPECT_FALSE(heap.pinned());
+
+    g_pinnedError = 0;
+    HostBuffer pinned = pool.Acquire(64);
+    ASSERT_TRUE(pinned);
+    EXPECT_TRUE(pinned.pinned());
+    EXPECT_EQ(pool.Allocated(), 2U);
+
+    // both recycled, each freed the way it was allocated
+    heap.Release();
+    pinned.Release();
+    pool.Clear();
+    EXPECT_EQ(pool.Allocated(), 0U);
+    EXPECT_TRUE(g_pinned.empty());
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright(C) 2020. Huawei Technologies Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HostRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "cpu_kernel_register.h"
+#include "cpu_kernel_utils.h"
+#include "node_def_builder.h"
+
+using namespace std;
+using namespace aicpu;
+
+namespace {
+const string kOpType = "FaceAlign";
+const vector<int64_t> kDefaultKeypoint = {40, 45, 72, 45, 52, 65, 42, 82, 72, 82};
+const int kKeypointNum = 10;
+
+double Percentile(const vector<double> &sorted, double percent)
+{
+    size_t index = static_cast<size_t>(percent / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+}
+
+HostRunner::HostRunner()
+{
+}
+
+HostRunner::~HostRunner()
+{
+    ctx_ = nullptr;
+    nodeDef_ = nullptr;
+}
+
+int HostRunner::Init(const HostRunConfig &config)
+{
+    if (config.imageH <= 0 || config.imageW <= 0 || config.faceNum <= 0 || config.faceH <= 0 ||
+        config.faceW <= 0 || config.iterations == 0) {
+        cout << "invalid host run config" << endl;
+        return -1;
+    }
+    config_ = config;
+    image_.assign(config_.imageH * config_.imageW * 3, 0);
+    keypoints_.assign(config_.faceNum * kKeypointNum, 0.0f);
+    faceNum_ = config_.faceNum;
+    output_.assign(config_.faceNum * config_.faceH * config_.faceW * 3, 0);
+    FillFrames();
+
+    // the tensors keep the buffer addresses, Bind only swaps them
+    nodeDef_ = NodeDefBuilder::CreateNodeDef();
+    if (nodeDef_ == nullptr) {
+        cout << "create node def faild." << endl;
+        return -1;
+    }
+    NodeDefBuilder(nodeDef_.get(), kOpType, kOpType)
+        .Input({"image", DT_UINT8, {1, config_.imageH, config_.imageW, 3}, image_.data(), FORMAT_NHWC})
+        .Input({"keypoints", DT_FLOAT, {config_.faceNum, kKeypointNum}, keypoints_.data(), FORMAT_ND})
+        .Input({"face_num", DT_INT32, {1}, &faceNum_, FORMAT_ND})
+        .Output({"aligned_image", DT_UINT8, {config_.faceNum, config_.faceH, config_.faceW, 3},
+                 output_.data(), FORMAT_NHWC})
+        .Output({"valid_num", DT_INT32, {1}, &validNum_, FORMAT_ND})
+        .Attr("face_size", vector<int64_t>({config_.faceW, config_.faceH}))
+        .Attr("default_keypoint", kDefaultKeypoint)
+        .Attr("transform_type", config_.transformType);
+
+    ctx_ = make_shared<CpuKernelContext>(HOST);
+    uint32_t ret = ctx_->Init(nodeDef_.get());
+    if (ret != 0) {
+        cout << "context init faild, ret = " << ret << endl;
+        return -1;
+    }
+    // resolved once, a launch then only runs it. Fails here rather than on the
+    // first launch when the kernel library is missing
+    kernel_ = CpuKernelRegister::Instance().GetCpuKernel(kOpType);
+    if (kernel_ == nullptr) {
+        cout << kOpType << " kernel is not registered." << endl;
+        return -1;
+    }
+    return 0;
+}
+
+int HostRunner::Bind(uint8_t *image, float *keypoints, int32_t *faceNum, uint8_t *output)
+{
+    if (ctx_ == nullptr || image == nullptr || keypoints == nullptr || faceNum == nullptr ||
+        output == nullptr) {
+        cout << "bind before init or with a null buffer" << endl;
+        return -1;
+    }
+    ctx_->Input(0)->SetData(image);
+    ctx_->Input(1)->SetData(keypoints);
+    ctx_->Input(2)->SetData(faceNum);
+    ctx_->Output(0)->SetData(output);
+    return 0;
+}
+
+uint32_t HostRunner::RunOnce()
+{
+    return CpuKernelRegister::Instance().RunCpuKernel(*ctx_, kOpType, kernel_);
+}
+
+int HostRunner::Run(HostRunStats &stats)
+{
+    if (ctx_ == nullptr) {
+        cout << "run before init" << endl;
+        return -1;
+    }
+    for (uint32_t i = 0; i < config_.warmup; i++) {
+        uint32_t ret = RunOnce();
+        if (ret != 0) {
+            cout << "FaceAlign run faild, ret = " << ret << endl;
+            return -1;
+        }
+    }
+    vector<double> latencies(config_.iterations);
+    auto start = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < config_.iterations; i++) {
+        auto begin = chrono::steady_clock::now();
+        uint32_t ret = RunOnce();
+        auto end = chrono::steady_clock::now();
+        if (ret != 0) {
+            cout << "FaceAlign run faild, ret = " << ret << endl;
+            return -1;
+        }
+        latencies[i] = chrono::duration<double, nano>(end - begin).count();
+    }
+    double totalNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    sort(latencies.begin(), latencies.end());
+    double sumNs = 0.0;
+    for (double latency : latencies) {
+        sumNs += latency;
+    }
+    stats.iterations = config_.iterations;
+    stats.faceNum = config_.faceNum;
+    stats.meanNs = sumNs / latencies.size();
+    stats.p50Ns = Percentile(latencies, 50.0);
+    stats.p99Ns = Percentile(latencies, 99.0);
+    stats.maxNs = latencies.back();
+    stats.launchesPerSec = config_.iterations * 1e9 / totalNs;
+    stats.facesPerSec = stats.launchesPerSec * config_.faceNum;
+    return 0;
+}
+
+uint32_t HostRunner::GetThreadNum() const
+{
+    return ctx_ == nullptr ? 0 : CpuKernelUtils::GetCPUNum(*ctx_);
+}
+
+// a random frame with the template scaled and moved somewhere in it for each face
+void HostRunner::FillFrames()
+{
+    mt19937 gen(0);
+    uniform_int_distribution<int> pixel(0, 255);
+    for (auto &value : image_) {
+        value = static_cast<uint8_t>(pixel(gen));
+    }
+    float maxScale = min(config_.imageW / (2.0f * config_.faceW), config_.imageH / (2.0f * config_.faceH));
+    uniform_real_distribution<float> scale(min(0.8f, maxScale), max(0.8f, maxScale));
+    uniform_real_distribution<float> noise(-1.5f, 1.5f);
+    for (int32_t i = 0; i < config_.faceNum; i++) {
+        float s = scale(gen);
+        uniform_real_distribution<float> tx(0.0f, max(1.0f, config_.imageW - s * config_.faceW));
+        uniform_real_distribution<float> ty(0.0f, max(1.0f, config_.imageH - s * config_.faceH));
+        float x = tx(gen);
+        float y = ty(gen);
+        for (int k = 0; k < kKeypointNum / 2; k++) {
+            keypoints_[i * kKeypointNum + k * 2] = kDefaultKeypoint[k * 2] * s + x + noise(gen);
+            keypoints_[i * kKeypointNum + k * 2 + 1] = kDefaultKeypoint[k * 2 + 1] * s + y + noise(gen);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright(C) 2020. Huawei Technologies Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOST_RUNNER_H
+#define HOST_RUNNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cpu_context.h"
+#include "cpu_kernel.h"
+#include "cpu_node_def.h"
+
+// One FaceAlign launch configuration
+struct HostRunConfig {
+    int64_t imageH = 720;
+    int64_t imageW = 1280;
+    int32_t faceNum = 4;
+    int64_t faceH = 112;
+    int64_t faceW = 112;
+    std::string transformType = "similarity";
+    uint32_t warmup = 10;
+    uint32_t iterations = 200;
+};
+
+// Latencies of the timed launches, in nanoseconds
+struct HostRunStats {
+    uint32_t iterations = 0;
+    int32_t faceNum = 0;
+    double meanNs = 0.0;
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double maxNs = 0.0;
+    double launchesPerSec = 0.0;
+    double facesPerSec = 0.0;
+};
+
+// Runs FaceAlign on the host device without Ascend hardware. The NodeDef is
+// built once per Init and its tensors point at the bound buffers, so a launch
+// only runs the kernel
+class HostRunner {
+public:
+    HostRunner();
+    ~HostRunner();
+
+    // Build the NodeDef and context for config, bound to buffers of synthetic
+    // frames owned by the runner
+    int Init(const HostRunConfig &config);
+
+    // Point the launch at caller buffers instead, nothing is copied. They must
+    // match the shapes of the config and outlive the runs
+    int Bind(uint8_t *image, float *keypoints, int32_t *faceNum, uint8_t *output);
+
+    // Launch once through CpuKernelRegister with the kernel resolved by Init
+    uint32_t RunOnce();
+
+    // Warm up, then time config.iterations launches
+    int Run(HostRunStats &stats);
+
+    uint32_t GetThreadNum() const;
+
+private:
+    HostRunner(const HostRunner &) = delete;
+    HostRunner &operator=(const HostRunner &) = delete;
+
+    void FillFrames();
+
+    HostRunConfig config_;
+    std::vector<uint8_t> image_;
+    std::vector<float> keypoints_;
+    int32_t faceNum_ = 0;
+    std::vector<uint8_t> output_;
+    int32_t validNum_ = 0;  // faces the last launch aligned, kept by the runner even after Bind
+    std::shared_ptr<aicpu::NodeDef> nodeDef_ = nullptr;
+    std::shared_ptr<aicpu::CpuKernelContext> ctx_ = nullptr;
+    std::shared_ptr<aicpu::CpuKernel> kernel_ = nullptr;
+};
+
+#endif
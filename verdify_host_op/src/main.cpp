@@ -0,0 +1,106 @@
+/**
+* @file Main.cpp
+*
+* Copyright (c) Huawei Technologies Co., Ltd. 2019. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "HostRunner.h"
+
+using namespace std;
+
+namespace {
+// "1,4,16" -> {1, 4, 16}
+bool ParseFaceNums(const string &arg, vector<int32_t> &faceNums)
+{
+    stringstream ss(arg);
+    string item;
+    while (getline(ss, item, ',')) {
+        int32_t faceNum = atoi(item.c_str());
+        if (faceNum <= 0) {
+            return false;
+        }
+        faceNums.push_back(faceNum);
+    }
+    return !faceNums.empty();
+}
+
+// "1280x720,1920x1080" -> {{720, 1280}, {1080, 1920}}
+bool ParseResolutions(const string &arg, vector<pair<int64_t, int64_t>> &resolutions)
+{
+    stringstream ss(arg);
+    string item;
+    while (getline(ss, item, ',')) {
+        long long width = 0;
+        long long height = 0;
+        if (sscanf(item.c_str(), "%lldx%lld", &width, &height) != 2 || width <= 0 || height <= 0) {
+            return false;
+        }
+        resolutions.emplace_back(height, width);
+    }
+    return !resolutions.empty();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && string(argv[1]) == "-h") {
+        cout << "please run: main_host [iterations] [face_nums] [resolutions] [transform_type]" << endl;
+        cout << "  e.g. main_host 200 1,4,16,64 1280x720,1920x1080 similarity" << endl;
+        cout << "  host threads follow AICPU_HOST_THREAD_NUM and AICPU_HOST_SCHEDULER" << endl;
+        return 0;
+    }
+    HostRunConfig config;
+    vector<int32_t> faceNums;
+    vector<pair<int64_t, int64_t>> resolutions;
+    if (argc > 1) {
+        config.iterations = static_cast<uint32_t>(atoi(argv[1]));
+    }
+    if (!ParseFaceNums(argc > 2 ? argv[2] : "1,4,16,64", faceNums) ||
+        !ParseResolutions(argc > 3 ? argv[3] : "1280x720,1920x1080", resolutions)) {
+        cout << "invalid face_nums or resolutions, run main_host -h" << endl;
+        return -1;
+    }
+    if (argc > 4) {
+        config.transformType = argv[4];
+    }
+
+    bool header = true;
+    for (const auto &resolution : resolutions) {
+        for (int32_t faceNum : faceNums) {
+            config.imageH = resolution.first;
+            config.imageW = resolution.second;
+            config.faceNum = faceNum;
+            HostRunner runner;
+            if (runner.Init(config) != 0) {
+                cout << "HostRunner Init faild." << endl;
+                return -1;
+            }
+            HostRunStats stats;
+            if (runner.Run(stats) != 0) {
+                return -1;
+            }
+            if (header) {
+                printf("FaceAlign on host, %u threads, %u iterations, %s\n", runner.GetThreadNum(),
+                       config.iterations, config.transformType.c_str());
+                printf("%-11s %6s %10s %10s %10s %12s %12s\n", "resolution", "faces", "p50(us)", "p99(us)",
+                       "max(us)", "launches/s", "faces/s");
+                header = false;
+            }
+            string name = to_string(config.imageW) + "x" + to_string(config.imageH);
+            printf("%-11s %6d %10.1f %10.1f %10.1f %12.1f %12.1f\n", name.c_str(), stats.faceNum,
+                   stats.p50Ns / 1e3, stats.p99Ns / 1e3, stats.maxNs / 1e3, stats.launchesPerSec,
+                   stats.facesPerSec);
+        }
+    }
+    return 0;
+}
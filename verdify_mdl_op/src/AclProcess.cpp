@@ -1,4 +1,5 @@
 #include "AclProcess.h"
+#include <cstring>
 
 AclProcess::AclProcess()
 {
@@ -6,16 +7,31 @@ AclProcess::AclProcess()
 }
 AclProcess::~AclProcess()
 {
-    m_modelProcess = nullptr;
-    aclError ret = aclrtSynchronizeStream(stream_);
+    aclError ret = Flush();
     if (ret != ACL_ERROR_NONE) {
         cout << "some tasks in stream not done, ret = " << ret <<endl;
     }
     cout << "all tasks in stream done" << endl;
-    ret = aclrtDestroyStream(stream_);
-    if (ret != ACL_ERROR_NONE) {
-        cout << "Destroy Stream faild, ret = " << ret <<endl;
+    m_modelProcess = nullptr;
+    for (auto &slot : slots_) {
+        for (auto buffer : slot.inputBuffers) {
+            aclrtFree(buffer);
+        }
+        for (auto buffer : slot.outputBuffers) {
+            aclrtFree(buffer);
+        }
+        if (slot.done != nullptr) {
+            aclrtDestroyEvent(slot.done);
+        }
+        if (slot.stream != nullptr) {
+            ret = aclrtDestroyStream(slot.stream);
+            if (ret != ACL_ERROR_NONE) {
+                cout << "Destroy Stream faild, ret = " << ret <<endl;
+            }
+        }
     }
+    slots_.clear();
+    hostPool_.Clear();
     cout << "Destroy Stream successfully" << endl;
     ret = aclrtDestroyContext(context_);
     if (ret != ACL_ERROR_NONE) {
@@ -29,7 +45,7 @@ AclProcess::~AclProcess()
     cout << "acl deinit successfully" << endl;
 }
 
-int AclProcess::Init(int deviceId, string modelPath)
+int AclProcess::Init(int deviceId, string modelPath, size_t pipelineDepth)
 {
     //Init
     aclError ret = aclInit(nullptr); // Initialize ACL
@@ -50,12 +66,21 @@ int AclProcess::Init(int deviceId, string modelPath)
         return ret;
     }
     cout << "set context successfully" << endl;
-    ret = aclrtCreateStream(&stream_);
-    if (ret != ACL_ERROR_NONE) {
-        cout << "Failed to create stream, ret = " << ret << endl;
-        return ret;
+    //every slot queues its copies and inference on its own stream
+    slots_.resize(pipelineDepth == 0 ? 1 : pipelineDepth);
+    for (auto &slot : slots_) {
+        ret = aclrtCreateStream(&slot.stream);
+        if (ret != ACL_ERROR_NONE) {
+            cout << "Failed to create stream, ret = " << ret << endl;
+            return ret;
+        }
+        ret = aclrtCreateEvent(&slot.done);
+        if (ret != ACL_ERROR_NONE) {
+            cout << "Failed to create event, ret = " << ret << endl;
+            return ret;
+        }
     }
-    cout << "Create stream successfully" << endl;
+    cout << "Create " << slots_.size() << " streams successfully" << endl;
     //Load model
     if (m_modelProcess == nullptr) {
         m_modelProcess = std::make_shared<ModelProcess>(deviceId, "");
@@ -67,37 +92,59 @@ int AclProcess::Init(int deviceId, string modelPath)
         return ret;
     }
     m_modelDesc = m_modelProcess->GetModelDesc();
-    //get model input description and malloc them
+    //get model input and output sizes, every slot mallocs its own buffers
     size_t inputSize = aclmdlGetNumInputs(m_modelDesc);
     std::cout<<"inputSize "<<inputSize<<std::endl;
     for (size_t i = 0; i < inputSize; i++) {
-        size_t bufferSize = aclmdlGetInputSizeByIndex(m_modelDesc, i);
-        std::cout<<" i "<<i<<" bufferSize "<<bufferSize<<std::endl;
-        void *inputBuffer = nullptr;
-        //aclError ret = aclrtMalloc(&inputBuffer, bufferSize, ACL_MEM_MALLOC_NORMAL_ONLY);
-        aclError ret = aclrtMalloc(&inputBuffer, bufferSize, ACL_MEM_MALLOC_HUGE_FIRST);
-        if (ret != ACL_ERROR_NONE) {
-            cout << "Failed to malloc buffer, ret = " << ret << endl;
-            return ret;
-        }
-        inputBuffers.push_back(inputBuffer);
-        inputSizes.push_back(bufferSize);
+        inputSizes.push_back(aclmdlGetInputSizeByIndex(m_modelDesc, i));
+        std::cout<<" i "<<i<<" bufferSize "<<inputSizes[i]<<std::endl;
     }
-    //get model output description and malloc them
     size_t outputSize = aclmdlGetNumOutputs(m_modelDesc);
     std::cout<<"outputSize "<<outputSize<<std::endl;
     for (size_t i = 0; i < outputSize; i++) {
-        size_t bufferSize = aclmdlGetOutputSizeByIndex(m_modelDesc, i);
-        std::cout<<"i "<<i<<" bufferSize  "<<bufferSize<<std::endl;;
-        void *outputBuffer = nullptr;
-        //aclError ret = aclrtMalloc(&outputBuffer, bufferSize, ACL_MEM_MALLOC_NORMAL_ONLY);
-        aclError ret = aclrtMalloc(&outputBuffer, bufferSize, ACL_MEM_MALLOC_HUGE_FIRST);
+        outputSizes.push_back(aclmdlGetOutputSizeByIndex(m_modelDesc, i));
+        std::cout<<"i "<<i<<" bufferSize  "<<outputSizes[i]<<std::endl;;
+    }
+    //pinned staging for every slot up front, frames only borrow it
+    for (size_t i = 0; i < inputSize; i++) {
+        ret = hostPool_.Reserve(inputSizes[i], slots_.size());
+        if (ret != ACL_ERROR_NONE) {
+            cout << "Failed to reserve host buffers" << endl;
+            return ret;
+        }
+    }
+    ret = hostPool_.Reserve(outputSizes[0], slots_.size());
+    if (ret != ACL_ERROR_NONE) {
+        cout << "Failed to reserve host buffers" << endl;
+        return ret;
+    }
+    for (size_t slotIndex = 0; slotIndex < slots_.size(); slotIndex++) {
+        FrameSlot &slot = slots_[slotIndex];
+        for (size_t i = 0; i < inputSize; i++) {
+            void *inputBuffer = nullptr;
+            ret = aclrtMalloc(&inputBuffer, inputSizes[i], ACL_MEM_MALLOC_HUGE_FIRST);
+            if (ret != ACL_ERROR_NONE) {
+                cout << "Failed to malloc buffer, ret = " << ret << endl;
+                return ret;
+            }
+            slot.inputBuffers.push_back(inputBuffer);
+        }
+        for (size_t i = 0; i < outputSize; i++) {
+            void *outputBuffer = nullptr;
+            ret = aclrtMalloc(&outputBuffer, outputSizes[i], ACL_MEM_MALLOC_HUGE_FIRST);
+            if (ret != ACL_ERROR_NONE) {
+                cout << "Failed to malloc buffer, ret = " << ret << endl;
+                return ret;
+            }
+            slot.outputBuffers.push_back(outputBuffer);
+        }
+        //the datasets are built once here, frames reuse the ones of their slot
+        ret = m_modelProcess->PrepareInference(slot.inputBuffers, inputSizes, slot.outputBuffers, outputSizes,
+            slotIndex);
         if (ret != ACL_ERROR_NONE) {
-            cout << "Failed to malloc buffer, ret = " << ret << endl;
+            cout << "Failed to prepare inference, ret = " << ret << endl;
             return ret;
         }
-        outputBuffers.push_back(outputBuffer);
-        outputSizes.push_back(bufferSize);
     }
     cout << "finish init AclProcess" << endl;
     return ACL_ERROR_NONE;
@@ -105,49 +152,143 @@ int AclProcess::Init(int deviceId, string modelPath)
 
 int AclProcess::Process(Mat& img)
 {
+    aclError ret = Submit(img);
+    if (ret != ACL_ERROR_NONE) {
+        return ret;
+    }
+    return Flush();
+}
+
+int AclProcess::Submit(Mat& img)
+{
+    size_t slotIndex = nextSlot_;
+    FrameSlot &slot = slots_[slotIndex];
+    nextSlot_ = (nextSlot_ + 1) % slots_.size();
+    //the slot is reused once the frame depth submits back is written out
     aclError ret = ACL_ERROR_NONE;
-    Mat imgResize;
+    if (slot.busy) {
+        ret = Complete(slot);
+        if (ret != ACL_ERROR_NONE) {
+            return ret;
+        }
+    }
+    //host work here overlaps the frames still queued on the other streams
+    ret = Preprocess(img, slot);
+    if (ret == ACL_ERROR_NONE) {
+        ret = m_modelProcess->ModelInferenceAsync(slot.inputBuffers, inputSizes, slot.outputBuffers, outputSizes,
+            slot.stream, slotIndex);
+    }
+    if (ret == ACL_ERROR_NONE) {
+        slot.hostOutput = hostPool_.Acquire(outputSizes[0]);
+        ret = slot.hostOutput ? ACL_ERROR_NONE : -1;
+    }
+    if (ret == ACL_ERROR_NONE) {
+        ret = aclrtMemcpyAsync(slot.hostOutput.data(), slot.hostOutput.size(), slot.outputBuffers[0],
+            outputSizes[0], ACL_MEMCPY_DEVICE_TO_HOST, slot.stream);
+    }
+    if (ret == ACL_ERROR_NONE) {
+        ret = aclrtRecordEvent(slot.done, slot.stream);
+    }
+    if (ret != ACL_ERROR_NONE) {
+        cout<<"model run faild.ret = "<< ret <<endl;
+        //nothing may still read the staging buffers when the slot is taken again
+        aclrtSynchronizeStream(slot.stream);
+        slot.hostInputs.clear();
+        slot.hostOutput.Release();
+        return ret;
+    }
+    slot.frameId = nextFrame_++;
+    slot.busy = true;
+    return ACL_ERROR_NONE;
+}
+
+int AclProcess::Flush()
+{
+    //oldest frame first, the files come out in submit order
+    aclError result = ACL_ERROR_NONE;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        FrameSlot &slot = slots_[(nextSlot_ + i) % slots_.size()];
+        if (slot.busy) {
+            aclError ret = Complete(slot);
+            if (ret != ACL_ERROR_NONE) {
+                result = ret;
+            }
+        }
+    }
+    return result;
+}
+
+aclError AclProcess::Preprocess(Mat& img, FrameSlot& slot)
+{
+    slot.hostInputs.clear();
+    for (size_t i = 0; i < inputSizes.size(); i++) {
+        slot.hostInputs.push_back(hostPool_.Acquire(inputSizes[i]));
+        if (!slot.hostInputs.back()) {
+            cout << "Failed to get a host buffer for input " << i << endl;
+            return -1;
+        }
+    }
     int batch,channels,height,width;
     aclmdlIODims dims;
     aclmdlGetInputDims(m_modelDesc, 0, &dims);
-    if(dims.dimCount == 4){
-        batch = dims.dims[0];
-        height = dims.dims[1];
-        width = dims.dims[2];
-        channels = dims.dims[3];
+    if(dims.dimCount != 4 || (size_t)(dims.dims[1] * dims.dims[2] * 3) > slot.hostInputs[0].size()){
+        cout << "unexpected image input dims" << endl;
+        return -1;
     }
+    batch = dims.dims[0];
+    height = dims.dims[1];
+    width = dims.dims[2];
+    channels = dims.dims[3];
+    //resize straight into the staging buffer of the slot
+    Mat imgResize(height, width, CV_8UC3, slot.hostInputs[0].data());
     resize(img, imgResize, Size(width, height),INTER_NEAREST);
-    aclrtMemcpy(inputBuffers[0], inputSizes[0], imgResize.data,imgResize.cols * imgResize.rows * imgResize.channels(), ACL_MEMCPY_HOST_TO_DEVICE);
     float keypoints[] = {60.,190.,120.,200.,90.,230.,65.,260.,115.,265.,
                         425.,215.,485.,210.,460.,245.,435.,275.,483.,270.,
                         786.,192.,840.,190.,815.,230.,790.,260.,840.,260.,
                         1165.,130.,1225.,130.,1195.,165.,1170.,195.,1215.,195.};
-    int32_t face_num = 4;
-    aclrtMemcpy(inputBuffers[1], inputSizes[1], keypoints, face_num * 10 * sizeof(float), ACL_MEMCPY_HOST_TO_DEVICE);
-    aclrtMemcpy(inputBuffers[2], inputSizes[2], &face_num, sizeof(int32_t), ACL_MEMCPY_HOST_TO_DEVICE);
+    slot.faceNum = 4;
+    memcpy(slot.hostInputs[1].data(), keypoints, slot.faceNum * 10 * sizeof(float));
+    memcpy(slot.hostInputs[2].data(), &slot.faceNum, sizeof(int32_t));
 
-    //forward
-    ret = m_modelProcess->ModelInference(inputBuffers, inputSizes, outputBuffers, outputSizes);
+    aclError ret = aclrtMemcpyAsync(slot.inputBuffers[0], inputSizes[0], slot.hostInputs[0].data(),
+        imgResize.cols * imgResize.rows * imgResize.channels(), ACL_MEMCPY_HOST_TO_DEVICE, slot.stream);
+    if (ret == ACL_ERROR_NONE) {
+        ret = aclrtMemcpyAsync(slot.inputBuffers[1], inputSizes[1], slot.hostInputs[1].data(),
+            slot.faceNum * 10 * sizeof(float), ACL_MEMCPY_HOST_TO_DEVICE, slot.stream);
+    }
+    if (ret == ACL_ERROR_NONE) {
+        ret = aclrtMemcpyAsync(slot.inputBuffers[2], inputSizes[2], slot.hostInputs[2].data(),
+            sizeof(int32_t), ACL_MEMCPY_HOST_TO_DEVICE, slot.stream);
+    }
+    return ret;
+}
+
+aclError AclProcess::Complete(FrameSlot& slot)
+{
+    slot.busy = false;
+    aclError ret = aclrtSynchronizeEvent(slot.done);
     if (ret != ACL_ERROR_NONE) {
-        cout<<"model run faild.ret = "<< ret <<endl;
+        cout << "wait frame " << slot.frameId << " faild, ret = " << ret << endl;
         return ret;
     }
-    //postprocess
-    cout << "begin postprocess"<<endl;
-    PostProcess(outputBuffers, outputSizes, face_num, 112, 112);
-    cout<<"model run success!"<<endl;
-    return ACL_ERROR_NONE;
+    ret = PostProcess(slot, 112, 112);
+    //the staging goes back to the pool for the next frame
+    slot.hostInputs.clear();
+    slot.hostOutput.Release();
+    return ret;
 }
 
-aclError AclProcess::PostProcess(std::vector<void *> outputBuffers, std::vector<size_t> outputSizes, int face_num, int width, int height)
+aclError AclProcess::PostProcess(FrameSlot& slot, int width, int height)
 {
-    void* host_data = malloc(outputSizes[0]);
-    aclrtMemcpy(host_data, outputSizes[0], outputBuffers[0], outputSizes[0], ACL_MEMCPY_DEVICE_TO_HOST);
     Mat aligned_img = Mat(width, height, CV_8UC3);
-    char file_name[20];
-    for(int i = 0; i < face_num; i++){
-        aligned_img.data = ((uchar*)host_data) + i * 3 * width * height;
-        sprintf(file_name, "face_aligned_%d.jpg", i);
+    char file_name[64];
+    for(int i = 0; i < slot.faceNum; i++){
+        aligned_img.data = slot.hostOutput.data() + i * 3 * width * height;
+        if (slot.frameId == 0) {
+            sprintf(file_name, "face_aligned_%d.jpg", i);
+        } else {
+            sprintf(file_name, "face_aligned_%lld_%d.jpg", (long long)slot.frameId, i);
+        }
         imwrite(file_name, aligned_img);
     }
     return ACL_ERROR_NONE;
@@ -2,6 +2,7 @@
 
 #include "iostream"
 #include "acl/acl.h"
+#include "HostBufferPool.h"
 #include "ModelProcess.h"
 #include "opencv2/opencv.hpp"
 
@@ -17,21 +18,43 @@ struct ObjDetectInfo {
     float classId;
 };
 
+// One in-flight frame of the pipeline, with its own stream, device buffers and host staging
+struct FrameSlot {
+    aclrtStream stream = nullptr;
+    aclrtEvent done = nullptr;  // recorded after the readback of the frame
+    std::vector<void *> inputBuffers;
+    std::vector<void *> outputBuffers;
+    std::vector<HostBuffer> hostInputs;  // pinned staging the async H2D copies read from
+    HostBuffer hostOutput;  // aligned faces copied back, recycled once written out
+    int32_t faceNum = 0;
+    int64_t frameId = 0;
+    bool busy = false;
+};
+
 class AclProcess{
 public:
     AclProcess();
     ~AclProcess();
-    int Init(int deviceId, string modelPath);
+    // pipelineDepth frames may be in flight, 1 runs them one by one
+    int Init(int deviceId, string modelPath, size_t pipelineDepth = 3);
+    // align the faces of one frame and wait for them
     int Process(Mat& img);
+    // queue a frame, only waits when the slot it takes still holds a frame
+    int Submit(Mat& img);
+    // wait for every queued frame
+    int Flush();
 private:
-    aclError PostProcess(std::vector<void *> outputBuffers, std::vector<size_t> outputSizes, int face_num, int width, int height);
+    aclError Preprocess(Mat& img, FrameSlot& slot);
+    aclError Complete(FrameSlot& slot);
+    aclError PostProcess(FrameSlot& slot, int width, int height);
 
-    std::vector<void *> inputBuffers;
     std::vector<size_t> inputSizes;
-    std::vector<void *> outputBuffers;
     std::vector<size_t> outputSizes;
+    HostBufferPool hostPool_;  // declared before slots_, the handles go back to it
+    std::vector<FrameSlot> slots_;
+    size_t nextSlot_ = 0;
+    int64_t nextFrame_ = 0;
     aclrtContext context_;
-    aclrtStream stream_;
     std::shared_ptr<ModelProcess> m_modelProcess;
     aclmdlDesc *m_modelDesc;
 };
@@ -55,17 +55,34 @@ aclmdlDesc *ModelProcess::GetModelDesc()
     return modelDesc_.get();
 }
 
+int ModelProcess::PrepareInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
+    std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, size_t slot)
+{
+    if (slot >= inputs_.size()) {
+        inputs_.resize(slot + 1, nullptr);
+        outputs_.resize(slot + 1, nullptr);
+    }
+    aclError ret = PrepareDataset(inputs_[slot], inputBufs, inputSizes);
+    if (ret != ACL_ERROR_NONE) {
+        cout << "Prepare input dataset failed, ret[" << ret << "]." << endl;
+        return ret;
+    }
+    ret = PrepareDataset(outputs_[slot], ouputBufs, outputSizes);
+    if (ret != ACL_ERROR_NONE) {
+        cout << "Prepare output dataset failed, ret[" << ret << "]." << endl;
+        return ret;
+    }
+    return ACL_ERROR_NONE;
+}
+
 int ModelProcess::ModelInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
     std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, size_t dynamicBatchSize)
 {
-    cout << "ModelProcess:Begin to inference." << endl;
-    aclmdlDataset *input = nullptr;
-    input = CreateAndFillDataset(inputBufs, inputSizes);
-    if (input == nullptr) {
-        cout << "CreateAndFillDataset Faild." << endl;
-        return -1;
+    // the datasets were built by PrepareInference, this only checks their buffer addresses
+    aclError ret = PrepareInference(inputBufs, inputSizes, ouputBufs, outputSizes);
+    if (ret != ACL_ERROR_NONE) {
+        return ret;
     }
-    aclError ret = 0;
     if (dynamicBatchSize != 0) {
         size_t index;
         ret = aclmdlGetInputIndexByName(modelDesc_.get(), ACL_DYNAMIC_TENSOR_NAME, &index);
@@ -73,31 +90,33 @@ int ModelProcess::ModelInference(std::vector<void *> &inputBufs, std::vector<siz
             cout << "aclmdlGetInputIndexByName failed, maybe static model" << endl;;
             return -2;
         }
-        ret = aclmdlSetDynamicBatchSize(modelId_, input, index, dynamicBatchSize);
+        ret = aclmdlSetDynamicBatchSize(modelId_, inputs_[0], index, dynamicBatchSize);
         if (ret != ACL_ERROR_NONE) {
-            cout << "dynamic batch set failed, modelId_=" << modelId_ << ", input=" << input << ", index=" << index
+            cout << "dynamic batch set failed, modelId_=" << modelId_ << ", input=" << inputs_[0] << ", index=" << index
                      << ", dynamicBatchSize=" << dynamicBatchSize <<endl;;
             return -2;
         }
-        cout << "set dynamicBatchSize successfully, dynamicBatchSize=" << dynamicBatchSize;
-    }
-    aclmdlDataset *output = nullptr;
-    output = CreateAndFillDataset(ouputBufs, outputSizes);
-    if (output == nullptr) {
-        DestroyDataset(input);
-        input = nullptr;
-        cout << "CreateAndFillDataset Faild." << endl;
-        return -1;
     }
-    cout << "aclmdlExecute" << endl;
-    ret = aclmdlExecute(modelId_, input, output);
+    ret = aclmdlExecute(modelId_, inputs_[0], outputs_[0]);
     if (ret != ACL_ERROR_NONE) {
         cout << "aclmdlExecute failed, ret[" << ret << "]." << endl;
         return ret;
     }
-    cout << "aclmdlExecute end" << endl;
-    DestroyDataset(input);
-    DestroyDataset(output);
+    return ACL_ERROR_NONE;
+}
+
+int ModelProcess::ModelInferenceAsync(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
+    std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, aclrtStream stream, size_t slot)
+{
+    aclError ret = PrepareInference(inputBufs, inputSizes, ouputBufs, outputSizes, slot);
+    if (ret != ACL_ERROR_NONE) {
+        return ret;
+    }
+    ret = aclmdlExecuteAsync(modelId_, inputs_[slot], outputs_[slot], stream);
+    if (ret != ACL_ERROR_NONE) {
+        cout << "aclmdlExecuteAsync failed, ret[" << ret << "]." << endl;
+        return ret;
+    }
     return ACL_ERROR_NONE;
 }
 
@@ -105,6 +124,12 @@ int ModelProcess::DeInit()
 {
     cout << "ModelProcess:Begin to deinit instance." << endl;
     isDeInit_ = true;
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        DestroyDataset(inputs_[i]);
+        DestroyDataset(outputs_[i]);
+    }
+    inputs_.clear();
+    outputs_.clear();
     aclError ret = aclmdlUnload(modelId_);
     if (ret != ACL_ERROR_NONE) {
         cout << "aclmdlUnload  failed, ret["<< ret << "]." << endl;
@@ -202,3 +227,29 @@ aclmdlDataset *ModelProcess::CreateAndFillDataset(std::vector<void *> &bufs, std
     }
     return dataset;
 }
+
+aclError ModelProcess::PrepareDataset(aclmdlDataset *&dataset, std::vector<void *> &bufs, std::vector<size_t> &sizes)
+{
+    if (dataset != nullptr && aclmdlGetDatasetNumBuffers(dataset) == bufs.size()) {
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            aclDataBuffer *data = aclmdlGetDatasetBuffer(dataset, i);
+            if (aclGetDataBufferAddr(data) == bufs[i] && aclGetDataBufferSizeV2(data) == sizes[i]) {
+                continue;
+            }
+            aclError ret = aclUpdateDataBuffer(data, bufs[i], sizes[i]);
+            if (ret != ACL_ERROR_NONE) {
+                cout << "aclUpdateDataBuffer failed, ret[" << ret << "]." << endl;
+                return ret;
+            }
+        }
+        return ACL_ERROR_NONE;
+    }
+    // first use, or the number of buffers changed
+    DestroyDataset(dataset);
+    dataset = CreateAndFillDataset(bufs, sizes);
+    if (dataset == nullptr) {
+        cout << "CreateAndFillDataset Faild." << endl;
+        return -1;
+    }
+    return ACL_ERROR_NONE;
+}
@@ -40,8 +40,16 @@ public:
     int Init(std::string modelPath);
     int DeInit();
 
+    // Create the input and output datasets of a pipeline slot once, later inferences only re-point their buffers
+    int PrepareInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
+        std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, size_t slot = 0);
+
     int ModelInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes, std::vector<void *> &ouputBufs,
         std::vector<size_t> &outputSizes, size_t dynamicBatchSize = 0);
+
+    // Queue the model on stream with the datasets of slot, synchronize before reading the outputs
+    int ModelInferenceAsync(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
+        std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, aclrtStream stream, size_t slot);
     aclmdlDesc *GetModelDesc();
 
     std::vector<void *> inputBuffers_ = {};
@@ -52,6 +60,7 @@ public:
 private:
     aclmdlDataset *CreateAndFillDataset(std::vector<void *> &bufs, std::vector<size_t> &sizes);
     void DestroyDataset(aclmdlDataset *dataset);
+    aclError PrepareDataset(aclmdlDataset *&dataset, std::vector<void *> &bufs, std::vector<size_t> &sizes);
 
     int deviceId_ = 0; // Device used
     std::string modelName_ = "";
@@ -59,6 +68,8 @@ private:
     aclrtContext contextModel_ = nullptr;
     shared_ptr<aclmdlDesc> modelDesc_ = nullptr;
     bool isDeInit_ = false;
+    std::vector<aclmdlDataset *> inputs_; // One per pipeline slot, kept across inferences
+    std::vector<aclmdlDataset *> outputs_; // The buffers stay owned by the caller
 };
 
 #endif
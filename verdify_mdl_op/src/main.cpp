@@ -8,6 +8,8 @@
 * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 */
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include "AclProcess.h"
 #include "opencv2/opencv.hpp"
@@ -18,7 +20,7 @@ using namespace cv;
 int main(int argc, char* argv[])
 {
     if(argc <= 2){
-        cout << "please run: main xxx.om xxx.jpg" <<endl;
+        cout << "please run: main xxx.om xxx.jpg [frames] [pipeline_depth]" <<endl;
         return -1;
     }
 
@@ -28,13 +30,35 @@ int main(int argc, char* argv[])
         return -1;
     }
 
+    int frames = argc > 3 ? atoi(argv[3]) : 1;
+    int depth = argc > 4 ? atoi(argv[4]) : 3;
+    if(frames <= 0 || depth <= 0){
+        cout << "frames and pipeline_depth must be positive." << endl;
+        return -1;
+    }
+
     AclProcess aclprocess;
-    aclError ret = aclprocess.Init(0, argv[1]);
+    aclError ret = aclprocess.Init(0, argv[1], depth);
     if(ret != ACL_ERROR_NONE){
         cout << "AclProcess Init faild." << endl;
         return -1;
     }
 
-    aclprocess.Process(img);
+    //up to depth frames in flight, the same image stands in for a video
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < frames; i++){
+        ret = aclprocess.Submit(img);
+        if(ret != ACL_ERROR_NONE){
+            cout << "AclProcess Submit faild." << endl;
+            return -1;
+        }
+    }
+    ret = aclprocess.Flush();
+    if(ret != ACL_ERROR_NONE){
+        cout << "AclProcess Flush faild." << endl;
+        return -1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << frames << " frames, pipeline depth " << depth << ", " << frames / seconds << " fps" << endl;
     return 0;
 }
\ No newline at end of file
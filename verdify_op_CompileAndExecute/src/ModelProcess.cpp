@@ -12,73 +12,125 @@ ModelProcess::ModelProcess()
 
 ModelProcess::~ModelProcess()
 {
+    DeInit();
 }
 
+int ModelProcess::Init()
+{
+    if (!bucketOps_.empty()) {
+        return ACL_SUCCESS;
+    }
+    int64_t faceCapacity = keypoints_shape_[0];
+    for (int64_t faceNum = 1; faceNum < faceCapacity; faceNum *= 2) {
+        faceNumBuckets_.push_back(faceNum);
+    }
+    faceNumBuckets_.push_back(faceCapacity);
+    for (auto faceNum : faceNumBuckets_) {
+        CompiledOp *op = nullptr;
+        auto ret = opCache_.Prepare(BucketSpec(faceNum), op);
+        if (ret != ACL_SUCCESS) {
+            cout << "Failed to compile " << opType_ << " for " << faceNum << " faces" << endl;
+            DeInit();
+            return ret;
+        }
+        bucketOps_.push_back(op);
+    }
+    cout << "compiled " << opCache_.Size() << " " << opType_ << " face_num buckets" << endl;
+    return ACL_SUCCESS;
+}
 
+void ModelProcess::DeInit()
+{
+    for (auto &buffers : inputBuffers_) {
+        for (auto buffer : buffers) {
+            aclDestroyDataBuffer(buffer);
+        }
+    }
+    for (auto &buffers : outputBuffers_) {
+        for (auto buffer : buffers) {
+            aclDestroyDataBuffer(buffer);
+        }
+    }
+    inputBuffers_.clear();
+    outputBuffers_.clear();
+    bucketOps_.clear();
+    faceNumBuckets_.clear();
+}
 
-int ModelProcess::ModelInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
-    std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, aclrtStream stream)
+// keypoints and aligned images scale with the faces, the image and face_num do not
+OpSpec ModelProcess::BucketSpec(int64_t faceNum) const
 {
-    cout << "ModelProcess:Begin to inference." << endl;
-    aclmdlDataset *input = nullptr;
-    std::string op_type = "FaceAlign";
+    std::vector<int64_t> keypoints_shape = keypoints_shape_;
+    keypoints_shape[0] = faceNum;
+    std::vector<int64_t> aligned_image_shape = aligned_image_shape_;
+    aligned_image_shape[0] = faceNum;
 
-    aclTensorDesc *image_desc = aclCreateTensorDesc(
-            ACL_INT8, image_shape_.size(), image_shape_.data(), ACL_FORMAT_NHWC);
-    aclTensorDesc *keypoints_desc = aclCreateTensorDesc(
-            ACL_FLOAT, keypoints_shape_.size(), keypoints_shape_.data(), ACL_FORMAT_ND);
-    aclTensorDesc *face_num_desc = aclCreateTensorDesc(
-            ACL_INT32, face_num_shape_.size(), face_num_shape_.data(), ACL_FORMAT_ND);
-    aclTensorDesc *aligned_image_desc = aclCreateTensorDesc(
-            ACL_INT8, aligned_image_shape_.size(), aligned_image_shape_.data(), ACL_FORMAT_ND);
-    std::vector<aclTensorDesc*> input_desc = {image_desc, keypoints_desc,face_num_desc};
-    std::vector<aclTensorDesc*> output_desc = {aligned_image_desc};
+    OpSpec spec;
+    spec.opType = opType_;
+    spec.inputs = {
+        {ACL_INT8, ACL_FORMAT_NHWC, image_shape_},
+        {ACL_FLOAT, ACL_FORMAT_ND, keypoints_shape},
+        {ACL_INT32, ACL_FORMAT_ND, face_num_shape_}};
+    spec.outputs = {
+        {ACL_INT8, ACL_FORMAT_ND, aligned_image_shape},
+        {ACL_INT32, ACL_FORMAT_ND, valid_num_shape_}};
+    spec.listIntAttrs["face_size"] = {aligned_image_shape_[2], aligned_image_shape_[1]};
+    spec.listIntAttrs["default_keypoint"] = {40, 45, 72, 45, 52, 65, 42, 82, 72, 82};
+    return spec;
+}
 
-    auto src_size = aclGetTensorDescSize(image_desc);
-    aclDataBuffer *image_buffer = aclCreateDataBuffer(inputBufs[0], src_size);
-    src_size = aclGetTensorDescSize(keypoints_desc);
-    aclDataBuffer *keypoints_buffer = aclCreateDataBuffer(inputBufs[1], src_size);
-    src_size = aclGetTensorDescSize(face_num_desc);
-    aclDataBuffer *face_num_buffer = aclCreateDataBuffer(inputBufs[2], src_size);
-    src_size = aclGetTensorDescSize(aligned_image_desc);
-    aclDataBuffer *aligned_image_buffer = aclCreateDataBuffer(ouputBufs[0], src_size);
+int ModelProcess::UpdateBuffers(std::vector<aclDataBuffer *> &buffers, std::vector<aclTensorDesc *> &descs,
+    std::vector<void *> &bufs)
+{
+    if (bufs.size() != descs.size()) {
+        cout << "expect " << descs.size() << " buffers, got " << bufs.size() << endl;
+        return -1;
+    }
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        size_t size = aclGetTensorDescSize(descs[i]);
+        if (i == buffers.size()) {
+            aclDataBuffer *buffer = aclCreateDataBuffer(bufs[i], size);
+            if (buffer == nullptr) {
+                cout << "Failed to aclCreateDataBuffer" << endl;
+                return -1;
+            }
+            buffers.push_back(buffer);
+        } else if (aclGetDataBufferAddr(buffers[i]) != bufs[i] || aclGetDataBufferSizeV2(buffers[i]) != size) {
+            auto ret = aclUpdateDataBuffer(buffers[i], bufs[i], size);
+            if (ret != ACL_SUCCESS) {
+                cout << "Failed to aclUpdateDataBuffer" << endl;
+                return ret;
+            }
+        }
+    }
+    return ACL_SUCCESS;
+}
 
-    std::vector<aclDataBuffer*> input_buffer = {image_buffer, keypoints_buffer,face_num_buffer};
-    std::vector<aclDataBuffer*> output_buffer = {aligned_image_buffer};
-    // Set OP attribute
-    aclopAttr *op_attr = aclopCreateAttr();
-    std::vector<int64_t> face_size={112,112};
-    auto ret=aclopSetAttrListInt(op_attr, "face_size", 2, face_size.data());
+int ModelProcess::ModelInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes,
+    std::vector<void *> &ouputBufs, std::vector<size_t> &outputSizes, aclrtStream stream, int32_t faceNum,
+    size_t slot)
+{
+    auto ret = Init();
     if (ret != ACL_SUCCESS) {
-        cout<<"Failed to aclopSetAttrListInt face_size "<<endl;
+        return ret;
+    }
+    // smallest bucket holding the faces, the kernel reads face_num for the rest
+    size_t bucket = 0;
+    while (bucket + 1 < faceNumBuckets_.size() && (faceNum <= 0 || faceNumBuckets_[bucket] < faceNum)) {
+        bucket++;
     }
-    std::vector<int64_t> default_keypoint={40,45,72,45,52,65,42,82,72,82};
-    ret=aclopSetAttrListInt(op_attr, "default_keypoint", default_keypoint.size(), default_keypoint.data());
+    CompiledOp *op = bucketOps_[bucket];
+    if (slot >= inputBuffers_.size()) {
+        inputBuffers_.resize(slot + 1);
+        outputBuffers_.resize(slot + 1);
+    }
+    ret = UpdateBuffers(inputBuffers_[slot], op->inputDesc, inputBufs);
     if (ret != ACL_SUCCESS) {
-        cout<<"Failed to aclopSetAttrListInt default_keypoint "<<endl;
+        return ret;
     }
-
-    cout << "aclopCompileAndExecute start" << endl;
-    ret = aclopCompileAndExecute(
-            op_type.c_str(),
-            inputBufs.size(), input_desc.data(), input_buffer.data(),
-            ouputBufs.size(), output_desc.data(), output_buffer.data(),
-            op_attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, nullptr, stream);
+    ret = UpdateBuffers(outputBuffers_[slot], op->outputDesc, ouputBufs);
     if (ret != ACL_SUCCESS) {
-        cout<<"Failed to aclopCompileAndExecute "<<endl;
+        return ret;
     }
-    aclrtSynchronizeStream(stream);
-    cout << "aclopCompileAndExecute end" << endl;
-    aclDestroyDataBuffer(image_buffer);
-    aclDestroyDataBuffer(keypoints_buffer);
-    aclDestroyDataBuffer(face_num_buffer);
-    aclDestroyDataBuffer(aligned_image_buffer);
-
-    aclDestroyTensorDesc(image_desc);
-    aclDestroyTensorDesc(keypoints_desc);
-    aclDestroyTensorDesc(face_num_desc);
-    aclDestroyTensorDesc(aligned_image_desc);
-    return ACL_ERROR_NONE;
+    return OpHandleCache::Execute(*op, inputBuffers_[slot], outputBuffers_[slot], stream);
 }
-
-
@@ -26,6 +26,7 @@
 #include <fstream>
 #include "acl/acl.h"
 #include "acl/acl_op_compiler.h"
+#include "OpHandleCache.h"
 
 using namespace std;
 
@@ -37,9 +38,16 @@ public:
     ModelProcess();
     ~ModelProcess();
 
+    // Compile the op for every face_num bucket up to the shapes below, frames
+    // never reach the compiler afterwards
+    int Init();
+    void DeInit();
 
+    // Queue the op on stream for faceNum faces, synchronize before reading the outputs.
+    // faceNum <= 0 runs the largest bucket. Frames in flight together use different
+    // slots, so one does not re-point the data buffers another is still queued with
     int ModelInference(std::vector<void *> &inputBufs, std::vector<size_t> &inputSizes, std::vector<void *> &ouputBufs,
-        std::vector<size_t> &outputSizes, aclrtStream stream);
+        std::vector<size_t> &outputSizes, aclrtStream stream, int32_t faceNum = 0, size_t slot = 0);
     unsigned int getNumInput(){return 3;}
     unsigned int getInputSizeByIndex(int index){
         if(index==0) {
@@ -51,10 +59,12 @@ public:
         }
         return 0;
     };
-    unsigned int getNumOutput(){return 1;}
+    unsigned int getNumOutput(){return 2;}
     unsigned int getOutputSizeByIndex(int index) {
         if(index==0){
            return aligned_image_shape_[0]*aligned_image_shape_[1]*aligned_image_shape_[2]*aligned_image_shape_[3]*sizeof(unsigned char);
+        } else if(index == 1){
+           return valid_num_shape_[0] * sizeof(int);
         }
         return 0;
     }
@@ -81,7 +91,19 @@ public:
     std::vector<int64_t> keypoints_shape_ = {4, 10};
     std::vector<int64_t> face_num_shape_ = {1,1};
     std::vector<int64_t> aligned_image_shape_ = {4, 112, 112, 3};
+    std::vector<int64_t> valid_num_shape_ = {1};
 private:
+    OpSpec BucketSpec(int64_t faceNum) const;
+    int UpdateBuffers(std::vector<aclDataBuffer *> &buffers, std::vector<aclTensorDesc *> &descs,
+        std::vector<void *> &bufs);
+
+    // compiled by Init, a frame only picks its bucket and re-points the data buffers
+    std::string opType_ = "FaceAlign";
+    OpHandleCache opCache_;
+    std::vector<int64_t> faceNumBuckets_;  // powers of two, then the face capacity
+    std::vector<CompiledOp *> bucketOps_;
+    std::vector<std::vector<aclDataBuffer *>> inputBuffers_;  // one set per slot
+    std::vector<std::vector<aclDataBuffer *>> outputBuffers_;
 };
 
 #endif
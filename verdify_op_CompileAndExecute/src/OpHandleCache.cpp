@@ -0,0 +1,153 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#include "OpHandleCache.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+std::string OpSpec::Key() const
+{
+    ostringstream key;
+    key << opType;
+    auto addTensors = [&key](const char *tag, const std::vector<OpTensorSpec> &tensors) {
+        for (const auto &tensor : tensors) {
+            key << '|' << tag << tensor.dataType << ',' << tensor.format << ':';
+            for (auto dim : tensor.dims) {
+                key << dim << ',';
+            }
+        }
+    };
+    addTensors("i", inputs);
+    addTensors("o", outputs);
+    for (const auto &attr : listIntAttrs) {
+        key << '|' << attr.first << '=';
+        for (auto value : attr.second) {
+            key << value << ',';
+        }
+    }
+    for (const auto &attr : stringAttrs) {
+        key << '|' << attr.first << '=' << attr.second;
+    }
+    return key.str();
+}
+
+CompiledOp::~CompiledOp()
+{
+    if (handle != nullptr) {
+        aclopDestroyHandle(handle);
+    }
+    for (auto desc : inputDesc) {
+        aclDestroyTensorDesc(desc);
+    }
+    for (auto desc : outputDesc) {
+        aclDestroyTensorDesc(desc);
+    }
+    if (attr != nullptr) {
+        aclopDestroyAttr(attr);
+    }
+}
+
+int OpHandleCache::Prepare(const OpSpec &spec, CompiledOp *&op)
+{
+    std::string key = spec.Key();
+    auto it = ops_.find(key);
+    if (it != ops_.end()) {
+        op = it->second.get();
+        return ACL_SUCCESS;
+    }
+    std::unique_ptr<CompiledOp> compiled(new CompiledOp());
+    int ret = Compile(spec, *compiled);
+    if (ret != ACL_SUCCESS) {
+        return ret;
+    }
+    op = compiled.get();
+    ops_[key] = std::move(compiled);
+    return ACL_SUCCESS;
+}
+
+CompiledOp *OpHandleCache::Get(const OpSpec &spec) const
+{
+    auto it = ops_.find(spec.Key());
+    return it == ops_.end() ? nullptr : it->second.get();
+}
+
+int OpHandleCache::Execute(CompiledOp &op, std::vector<aclDataBuffer *> &inputs,
+    std::vector<aclDataBuffer *> &outputs, aclrtStream stream)
+{
+    if (inputs.size() != op.inputDesc.size() || outputs.size() != op.outputDesc.size()) {
+        cout << op.opType << " expects " << op.inputDesc.size() << " inputs and " << op.outputDesc.size()
+             << " outputs" << endl;
+        return -1;
+    }
+    aclError ret = ACL_SUCCESS;
+    if (op.handle != nullptr) {
+        ret = aclopExecWithHandle(op.handle, inputs.size(), inputs.data(), outputs.size(), outputs.data(), stream);
+    } else {
+        ret = aclopExecuteV2(op.opType.c_str(), inputs.size(), op.inputDesc.data(), inputs.data(),
+            outputs.size(), op.outputDesc.data(), outputs.data(), op.attr, stream);
+    }
+    if (ret != ACL_SUCCESS) {
+        cout << "Failed to execute " << op.opType << ", ret = " << ret << endl;
+    }
+    return ret;
+}
+
+int OpHandleCache::Compile(const OpSpec &spec, CompiledOp &op)
+{
+    op.opType = spec.opType;
+    for (const auto &tensor : spec.inputs) {
+        op.inputDesc.push_back(aclCreateTensorDesc(tensor.dataType, tensor.dims.size(), tensor.dims.data(),
+            tensor.format));
+        if (op.inputDesc.back() == nullptr) {
+            cout << "Failed to aclCreateTensorDesc" << endl;
+            return -1;
+        }
+    }
+    for (const auto &tensor : spec.outputs) {
+        op.outputDesc.push_back(aclCreateTensorDesc(tensor.dataType, tensor.dims.size(), tensor.dims.data(),
+            tensor.format));
+        if (op.outputDesc.back() == nullptr) {
+            cout << "Failed to aclCreateTensorDesc" << endl;
+            return -1;
+        }
+    }
+    op.attr = aclopCreateAttr();
+    if (op.attr == nullptr) {
+        cout << "Failed to aclopCreateAttr" << endl;
+        return -1;
+    }
+    for (const auto &attr : spec.listIntAttrs) {
+        auto ret = aclopSetAttrListInt(op.attr, attr.first.c_str(), attr.second.size(), attr.second.data());
+        if (ret != ACL_SUCCESS) {
+            cout << "Failed to aclopSetAttrListInt " << attr.first << endl;
+            return ret;
+        }
+    }
+    for (const auto &attr : spec.stringAttrs) {
+        auto ret = aclopSetAttrString(op.attr, attr.first.c_str(), attr.second.c_str());
+        if (ret != ACL_SUCCESS) {
+            cout << "Failed to aclopSetAttrString " << attr.first << endl;
+            return ret;
+        }
+    }
+
+    auto ret = aclopCompile(op.opType.c_str(), op.inputDesc.size(), op.inputDesc.data(), op.outputDesc.size(),
+        op.outputDesc.data(), op.attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, nullptr);
+    if (ret != ACL_SUCCESS) {
+        cout << "Failed to aclopCompile " << op.opType << ", ret = " << ret << endl;
+        return ret;
+    }
+    // without a handle every execute still looks the compiled op up by its descs
+    ret = aclopCreateHandle(op.opType.c_str(), op.inputDesc.size(), op.inputDesc.data(), op.outputDesc.size(),
+        op.outputDesc.data(), op.attr, &op.handle);
+    if (ret != ACL_SUCCESS) {
+        cout << "aclopCreateHandle of " << op.opType << " failed, ret = " << ret << ", execute by aclopExecuteV2"
+             << endl;
+        op.handle = nullptr;
+    }
+    return ACL_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright(C) 2022. Deepglint Technologies Co.,Ltd. All rights reserved.
+ */
+
+#ifndef OP_HANDLE_CACHE_H
+#define OP_HANDLE_CACHE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "acl/acl.h"
+#include "acl/acl_op_compiler.h"
+
+// Shape, dtype and format of one op input or output
+struct OpTensorSpec {
+    aclDataType dataType;
+    aclFormat format;
+    std::vector<int64_t> dims;
+};
+
+// Everything a single op is compiled for
+struct OpSpec {
+    std::string opType;
+    std::vector<OpTensorSpec> inputs;
+    std::vector<OpTensorSpec> outputs;
+    std::map<std::string, std::vector<int64_t>> listIntAttrs;
+    std::map<std::string, std::string> stringAttrs;
+
+    // op type, tensors and attrs in one string, equal specs give equal keys
+    std::string Key() const;
+};
+
+// A compiled op with the descs and attr it was compiled for. Execute goes
+// through the handle when the runtime gave one, aclopExecuteV2 otherwise
+struct CompiledOp {
+    CompiledOp() = default;
+    ~CompiledOp();
+    CompiledOp(const CompiledOp &) = delete;
+    CompiledOp &operator=(const CompiledOp &) = delete;
+
+    std::string opType;
+    std::vector<aclTensorDesc *> inputDesc;
+    std::vector<aclTensorDesc *> outputDesc;
+    aclopAttr *attr = nullptr;
+    aclopHandle *handle = nullptr;
+};
+
+// Compiles every distinct OpSpec once and keeps it until the cache goes away.
+// Frames then execute asynchronously on their stream and never reach the compiler
+class OpHandleCache {
+public:
+    OpHandleCache() = default;
+    ~OpHandleCache() = default;
+
+    // Compile spec unless it already is, op stays owned by the cache
+    int Prepare(const OpSpec &spec, CompiledOp *&op);
+
+    // nullptr if spec was never prepared
+    CompiledOp *Get(const OpSpec &spec) const;
+
+    size_t Size() const { return ops_.size(); }
+
+    // Queue op on stream, the caller synchronizes before reading the outputs
+    static int Execute(CompiledOp &op, std::vector<aclDataBuffer *> &inputs, std::vector<aclDataBuffer *> &outputs,
+        aclrtStream stream);
+
+private:
+    OpHandleCache(const OpHandleCache &) = delete;
+    OpHandleCache &operator=(const OpHandleCache &) = delete;
+
+    static int Compile(const OpSpec &spec, CompiledOp &op);
+
+    std::unordered_map<std::string, std::unique_ptr<CompiledOp>> ops_;
+};
+
+#endif